@@ -0,0 +1,156 @@
+/**
+Software License Agreement (BSD)
+
+\file      async_os32c.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_ASYNC_OS32C_H
+#define OMRON_OS32C_DRIVER_ASYNC_OS32C_H
+
+// Some versions of Asio use std::exchange in awaitable.hpp without including <utility>
+#include <utility>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/timeout_tcp_socket.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Awaitable interface to an OS32C, for driving any number of sensors from
+ * straight-line coroutines on a single thread. Requires C++20 and is only built
+ * when the compiler supports coroutines.
+ *
+ * The session underneath still uses blocking sockets, so each call runs on a
+ * thread pool, serialized per sensor by a strand, while the awaiting coroutine
+ * is suspended. The pool needs about one thread per sensor that is expected to
+ * have a request in flight at the same time, but the orchestration code needs
+ * no threads of its own.
+ *
+ * Timeouts and cancellation end the wait. Given the session socket of the
+ * sensor, they also shut the connection down, so that a request blocked on a
+ * sensor that stopped answering fails at once and frees its thread and the
+ * strand. The sensor then has to be opened again. Without the socket, a
+ * request that has been given up on still runs to completion on the pool, and
+ * the next call to the same sensor is queued behind it.
+ *
+ * All member functions must be called from the executor given to the
+ * constructor, which must not run handlers concurrently, such as an io_context
+ * run by one thread or a strand.
+ */
+class AsyncOS32C
+{
+public:
+  typedef std::chrono::steady_clock::duration Duration;
+
+  /**
+   * @param executor Executor the awaiting coroutines run on
+   * @param pool Threads to run the blocking calls on
+   * @param os32c Sensor to use. Must not be used directly while this object is.
+   * @param timeout Time to wait for each call before giving up, or zero to wait
+   *  for as long as it takes
+   * @param socket Session socket of the sensor, to abort when a call is given
+   *  up on, or an empty pointer to leave the request running
+   */
+  AsyncOS32C(const boost::asio::any_io_executor& executor, boost::asio::thread_pool& pool,
+             boost::shared_ptr<OS32C> os32c, Duration timeout = Duration::zero(),
+             boost::shared_ptr<TimeoutTCPSocket> socket = boost::shared_ptr<TimeoutTCPSocket>());
+
+  /**
+   * Open a session with the sensor
+   * @param host Hostname or IP address of the sensor
+   */
+  boost::asio::awaitable<void> open(std::string host);
+
+  /**
+   * Select the beams to measure, as OS32C::selectBeams()
+   */
+  boost::asio::awaitable<void> selectBeams(BeamSelection selection);
+
+  /**
+   * Request a single scan, as OS32C::getSingleRRScan()
+   */
+  boost::asio::awaitable<RangeAndReflectanceMeasurement> getSingleRRScan();
+
+  /**
+   * Wait for the next scan. Scans are polled, so the requests are paced at the
+   * scan period reported by the previous scan, and the beam selection switches
+   * over as reports with the new selection arrive.
+   * @return The scan
+   */
+  boost::asio::awaitable<RangeAndReflectanceMeasurement> nextReport();
+
+  /**
+   * Run any function of the OS32C on the pool
+   * @param fn Function to run, given the sensor
+   * @return Result of the function
+   * @throw boost::system::system_error with boost::asio::error::timed_out if the
+   *  call times out, or boost::asio::error::operation_aborted if it is cancelled
+   */
+  template <typename T>
+  boost::asio::awaitable<T> call(std::function<T(OS32C&)> fn)
+  {
+    // The result outlives this frame if the wait is given up on
+    std::shared_ptr<std::optional<T> > result = std::make_shared<std::optional<T> >();
+    co_await run([result, fn](OS32C& os32c) { result->emplace(fn(os32c)); });
+    co_return std::move(**result);
+  }
+
+  /**
+   * End the waits in progress, which throw boost::asio::error::operation_aborted.
+   * Requests already sent to the sensor are aborted if the session socket was
+   * given, and otherwise complete in the background.
+   */
+  void cancel();
+
+private:
+  struct CallState;
+
+  boost::asio::any_io_executor executor_;
+  boost::asio::strand<boost::asio::thread_pool::executor_type> strand_;
+  boost::shared_ptr<OS32C> os32c_;
+  Duration timeout_;
+  boost::shared_ptr<TimeoutTCPSocket> socket_;
+  std::vector<std::weak_ptr<CallState> > calls_;
+  boost::asio::steady_timer report_timer_;
+  std::chrono::steady_clock::time_point last_report_;
+  Duration scan_period_;
+
+  /**
+   * Run a function on the pool and wait for it, with the timeout
+   */
+  boost::asio::awaitable<void> run(std::function<void(OS32C&)> fn);
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_ASYNC_OS32C_H
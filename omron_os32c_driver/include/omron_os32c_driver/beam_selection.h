@@ -0,0 +1,168 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_selection.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_BEAM_SELECTION_H
+#define OMRON_OS32C_DRIVER_BEAM_SELECTION_H
+
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Set of beams to be measured by the OS32C. The device takes a bitmap with
+ * one bit per beam, so any combination of sectors can be selected, thinned out
+ * to every Nth beam, and have individual sectors or beams excluded. Every
+ * beam that is not selected is left out of the measurement reports entirely.
+ *
+ * To keep a regular angle increment in the output, the selected beams are
+ * mapped onto slots spaced by the decimation, starting from the first selected
+ * beam. Slots between selected sectors or for excluded beams have no measurement.
+ */
+class BeamSelection
+{
+public:
+  static const int NUM_BEAMS = 677;
+  static const size_t MASK_SIZE = 88;
+
+  BeamSelection();
+
+  /**
+   * Add a sector of beams. Angles are in ROS conventions, with zero straight
+   * ahead and positive numbers CCW, in radians.
+   * @param start_angle Most CCW angle of the sector
+   * @param end_angle Most CW angle of the sector
+   * @throw std::invalid_argument if the sector is out of range or empty
+   */
+  void addSector(double start_angle, double end_angle);
+
+  /**
+   * Remove a sector of beams, such as one occluded by the robot itself.
+   * @param start_angle Most CCW angle of the sector
+   * @param end_angle Most CW angle of the sector
+   * @throw std::invalid_argument if the sector is out of range or empty
+   */
+  void excludeSector(double start_angle, double end_angle);
+
+  /**
+   * Remove a single beam
+   * @param beam_num OS32C beam number to remove
+   */
+  void excludeBeam(int beam_num);
+
+  /**
+   * Only measure every Nth beam, counting from the first selected beam.
+   * @param decimation Spacing between measured beams. 1 measures every beam
+   * @throw std::invalid_argument if decimation is less than 1
+   */
+  void setDecimation(int decimation);
+
+  int getDecimation() const
+  {
+    return decimation_;
+  }
+
+  /**
+   * Beam numbers that will be measured, in the order they are reported
+   */
+  const vector<int>& getBeams() const
+  {
+    return beams_;
+  }
+
+  int getNumBeams() const
+  {
+    return beams_.size();
+  }
+
+  int getFirstBeam() const
+  {
+    return beams_.empty() ? 0 : beams_.front();
+  }
+
+  int getLastBeam() const
+  {
+    return beams_.empty() ? 0 : beams_.back();
+  }
+
+  /**
+   * Number of evenly spaced slots from the first to the last selected beam
+   */
+  int getNumSlots() const
+  {
+    return beams_.empty() ? 0 : (beams_.back() - beams_.front()) / decimation_ + 1;
+  }
+
+  /**
+   * Slot of a selected beam
+   * @param i Index of the beam in report order
+   */
+  int getSlot(size_t i) const
+  {
+    return (beams_[i] - beams_.front()) / decimation_;
+  }
+
+  /**
+   * True if every slot has a measured beam, so reports need no expansion
+   */
+  bool isContiguous() const
+  {
+    return getNumSlots() == getNumBeams();
+  }
+
+  /**
+   * Fill in the bitmap to send to the device
+   * @param mask Holder for the mask data. Must be 88 bytes
+   */
+  void getMask(EIP_BYTE mask[]) const;
+
+  /**
+   * Spread per-beam values out to their slots, in place. Values must have one
+   * entry per selected beam in report order. Slots without a beam are set to fill.
+   * @param values Values to expand
+   * @param fill Value for slots without a measurement
+   */
+  void expand(vector<float>& values, float fill) const;
+
+  /**
+   * Check that a sector is within the scan area and not empty
+   * @throw std::invalid_argument if not
+   */
+  static void validateSector(double start_angle, double end_angle);
+
+private:
+  int decimation_;
+  vector<bool> sectors_;
+  vector<bool> excluded_;
+  vector<int> beams_;
+
+  void update();
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_BEAM_SELECTION_H
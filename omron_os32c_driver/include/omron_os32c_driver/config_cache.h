@@ -0,0 +1,115 @@
+/**
+Software License Agreement (BSD)
+
+\file      config_cache.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_CONFIG_CACHE_H
+#define OMRON_OS32C_DRIVER_CONFIG_CACHE_H
+
+#include <cstring>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/serialization/reader.h"
+#include "odva_ethernetip/serialization/writer.h"
+#include "odva_ethernetip/serialization/serializable.h"
+
+using eip::serialization::Serializable;
+using eip::serialization::Reader;
+using eip::serialization::Writer;
+
+namespace omron_os32c_driver {
+
+/**
+ * Measurement configuration last applied to the sensor by the driver, keyed by
+ * the non-safety config checksum that the sensor reported with it applied.
+ * If a sensor reports the same checksum, formats and number of beams on connect,
+ * nothing needs to be written. Serializable so that it can be kept across restarts.
+ */
+class ConfigCache : public Serializable
+{
+public:
+  bool valid;
+  EIP_UINT checksum;
+  EIP_UINT range_report_format;
+  EIP_UINT reflectivity_report_format;
+  EIP_UINT num_beams;
+  EIP_BYTE beam_selection_mask[88];
+
+  ConfigCache() : valid(false), checksum(0), range_report_format(0), reflectivity_report_format(0), num_beams(0)
+  {
+    memset(beam_selection_mask, 0, sizeof(beam_selection_mask));
+  }
+
+  /**
+   * Four words of config plus the beam selection mask
+   */
+  virtual size_t getLength() const
+  {
+    return 96;
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the cache data
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    writer.write(checksum);
+    writer.write(range_report_format);
+    writer.write(reflectivity_report_format);
+    writer.write(num_beams);
+    writer.writeBytes(beam_selection_mask, sizeof(beam_selection_mask));
+    return writer;
+  }
+
+  /**
+   * Extra length information is not relevant in this context. Same as deserialize(reader)
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    return deserialize(reader);
+  }
+
+  /**
+   * Deserialize data from the given reader without length information. The
+   * cache is valid afterwards.
+   * @param reader Reader to use for deserialization
+   * @return the reader again
+   * @throw std::length_error if the buffer is overrun while deserializing
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    reader.read(checksum);
+    reader.read(range_report_format);
+    reader.read(reflectivity_report_format);
+    reader.read(num_beams);
+    reader.readBytes(beam_selection_mask, sizeof(beam_selection_mask));
+    valid = true;
+    return reader;
+  }
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_CONFIG_CACHE_H
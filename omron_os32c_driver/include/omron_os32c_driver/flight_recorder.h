@@ -0,0 +1,213 @@
+/**
+Software License Agreement (BSD)
+
+\file      flight_recorder.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_FLIGHT_RECORDER_H
+#define OMRON_OS32C_DRIVER_FLIGHT_RECORDER_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/scan_observer.h"
+#include "omron_os32c_driver/scan_view.h"
+
+using std::string;
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * One scan as kept by the FlightRecorder, and as written to its files
+ */
+struct FlightRecord
+{
+  /// Seconds on CLOCK_REALTIME when the scan was received
+  double stamp;
+  EIP_UDINT num_beams;
+  EIP_UDINT has_reflectance;
+  /// MeasurementReportHeader as serialized by the sensor
+  EIP_BYTE header[56];
+  EIP_UINT ranges[BeamSelection::NUM_BEAMS];
+  EIP_UINT reflectance[BeamSelection::NUM_BEAMS];
+};
+
+/**
+ * Start of a flight recorder file. It is followed by num_records FlightRecords,
+ * oldest first, so the file can be mapped and used in place on the same
+ * architecture.
+ */
+struct FlightRecorderFileHeader
+{
+  /// "OS32CFR" and a terminating zero
+  char magic[8];
+  EIP_UDINT version;
+  /// sizeof(FlightRecord) of the writer, to check the layout matches
+  EIP_UDINT record_size;
+  EIP_UDINT num_records;
+  /// Index of the record that triggered the dump, or num_records if requested
+  EIP_UDINT trigger_record;
+};
+
+/**
+ * Always-on recorder of the last scans received, for finding out what the
+ * sensor saw around a protective stop. Scans are copied into a preallocated
+ * ring of fixed size records, overwriting the oldest. When the machine stop
+ * reasons or the detection zone status change, the recorder waits for a few
+ * more scans and then writes the whole ring to a file.
+ *
+ * Scans are recorded and dumps are started on the thread that delivers the
+ * scans, without any locking. A dump copies the ring into a preallocated
+ * snapshot, which a writer thread then writes out, so that the file system
+ * never holds up acquisition. Dumps made while the previous snapshot is still
+ * being written are dropped.
+ */
+class FlightRecorder : public ScanObserver
+{
+public:
+  /**
+   * @param num_scans Number of scans to keep
+   * @param post_trigger_scans Number of scans to record after a trigger before
+   *  dumping, which must be less than num_scans
+   * @param directory Directory to write the files to
+   * @param max_files Number of flight recorder files to keep in the directory,
+   *  removing the oldest after each dump, or 0 to keep them all
+   * @throw std::invalid_argument if the number of scans is not usable
+   * @throw std::runtime_error if the writer thread cannot be started
+   */
+  FlightRecorder(size_t num_scans, size_t post_trigger_scans, const string& directory, size_t max_files = 0);
+
+  /**
+   * Waits for the file being written, if any
+   */
+  ~FlightRecorder();
+
+  /**
+   * Record a scan received from acquisition, stamped with the current time, and
+   * dump the ring once a trigger has been followed by enough scans. Problems
+   * writing the file are logged rather than thrown.
+   */
+  virtual void scanReceived(const ScanView& scan);
+
+  /**
+   * Record a scan, checking it for a trigger
+   * @param scan Scan to copy into the ring
+   * @param stamp Time the scan was received
+   */
+  void record(const ScanView& scan, double stamp);
+
+  /**
+   * True if a trigger is waiting for its post trigger scans
+   */
+  bool isDumpPending() const
+  {
+    return dump_pending_;
+  }
+
+  /**
+   * Forget the state the last scan was in, such as after reconnecting, so that
+   * the first scan afterwards does not look like a change. Recorded scans are kept.
+   */
+  void reset()
+  {
+    has_previous_ = false;
+  }
+
+  /**
+   * Start writing the recorded scans to a new file in the directory. The file
+   * is complete once flush() returns.
+   * @return Path of the file being written
+   * @throw std::runtime_error if the directory is not writable or the previous
+   *  file is still being written
+   */
+  string dump();
+
+  /**
+   * Wait until the file being written, if any, is complete
+   */
+  void flush();
+
+  size_t getNumRecorded() const
+  {
+    return num_recorded_;
+  }
+
+private:
+  vector<FlightRecord> records_;
+  size_t post_trigger_scans_;
+  string directory_;
+  size_t max_files_;
+  /// Next record to overwrite
+  size_t next_;
+  size_t num_recorded_;
+  bool has_previous_;
+  EIP_UINT previous_stop_reasons_;
+  EIP_WORD previous_zone_status_;
+  bool dump_pending_;
+  size_t scans_until_dump_;
+
+  // Copy of the ring, oldest first, handed to the writer thread. Only touched
+  // by the writer while writing_ is set.
+  vector<FlightRecord> snapshot_;
+  FlightRecorderFileHeader snapshot_header_;
+  string snapshot_filename_;
+  pthread_t writer_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  bool writing_;
+  bool stopping_;
+
+  // the writer thread and the snapshot are not copyable
+  FlightRecorder(const FlightRecorder&);
+  FlightRecorder& operator=(const FlightRecorder&);
+
+  /**
+   * Copy the recorded scans into the snapshot and wake the writer thread
+   * @param trigger_record Index in the file of the scan that triggered the dump
+   */
+  string dump(EIP_UDINT trigger_record);
+
+  static void* runWriter(void* arg);
+
+  /**
+   * Body of the writer thread, writing each snapshot handed to it
+   */
+  void writeSnapshots();
+
+  /**
+   * Write the snapshot to its file
+   * @throw std::runtime_error if the file cannot be written
+   */
+  void writeSnapshot();
+
+  /**
+   * Remove the oldest flight recorder files in the directory beyond max_files_
+   */
+  void removeOldFiles();
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_FLIGHT_RECORDER_H
@@ -0,0 +1,123 @@
+/**
+Software License Agreement (BSD)
+
+\file      latest_scan_buffer.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_LATEST_SCAN_BUFFER_H
+#define OMRON_OS32C_DRIVER_LATEST_SCAN_BUFFER_H
+
+#include <vector>
+#include <boost/atomic.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+#include "omron_os32c_driver/scan_observer.h"
+#include "omron_os32c_driver/scan_view.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Copy of a scan held by a LatestScanBuffer
+ */
+struct LatestScan
+{
+  LatestScan() : stamp(0)
+  {
+  }
+
+  /// Header as reported, including the scan_count of the scan
+  MeasurementReportHeader header;
+  /// Seconds on CLOCK_MONOTONIC when the scan was received, or 0 if none yet
+  double stamp;
+  /// Range codes in device units
+  vector<EIP_UINT> ranges;
+  /// Reflectance of each beam, or empty if the scan had none
+  vector<EIP_UINT> reflectance;
+};
+
+/**
+ * Triple buffer holding the newest scan, for a consumer that polls at its own
+ * rate and only wants the latest data. The writer fills a back slot and swaps it
+ * with the middle one, and the reader swaps the middle slot for its front one
+ * when a newer scan is there. Both swaps are a single atomic exchange of slot
+ * indices, so neither side ever waits on the other, and the reader never sees
+ * a slot while it is being written.
+ *
+ * Supports one writer thread, normally the acquisition thread through the
+ * ScanObserver interface, and one reader thread.
+ */
+class LatestScanBuffer : public ScanObserver
+{
+public:
+  /**
+   * Create the buffer with every slot sized for a full scan, so that writing
+   * does not allocate.
+   */
+  LatestScanBuffer();
+
+  /**
+   * Store a scan received from acquisition, stamped with the current time
+   */
+  virtual void scanReceived(const ScanView& scan);
+
+  /**
+   * Store a scan as the newest one. Writer side only.
+   * @param scan Scan to copy
+   * @param stamp Time the scan was received
+   */
+  void write(const ScanView& scan, double stamp);
+
+  /**
+   * Take the newest scan, if one has been written since the last update. Reader
+   * side only.
+   * @return true if getLatest() now refers to a newer scan
+   */
+  bool update();
+
+  /**
+   * Latest scan taken by update(). Reader side only. The reference stays valid
+   * and unchanged until the next call to update().
+   */
+  const LatestScan& getLatest() const
+  {
+    return slots_[front_];
+  }
+
+private:
+  /// Set in state_ when the middle slot holds a scan the reader has not taken
+  static const unsigned int FRESH = 4;
+  static const unsigned int INDEX_MASK = 3;
+
+  LatestScan slots_[3];
+  /// Index of the middle slot, plus the FRESH flag
+  boost::atomic<unsigned int> state_;
+  /// Slot owned by the writer
+  unsigned int back_;
+  /// Slot owned by the reader
+  unsigned int front_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_LATEST_SCAN_BUFFER_H
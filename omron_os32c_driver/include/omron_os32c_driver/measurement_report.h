@@ -45,13 +45,16 @@ namespace omron_os32c_driver {
 /**
  * Data structure and operators for OS32C specific Measurement Report data
  * as defined in the OS32C-DM Ethernet/IP Addendum. Used for both range and
- * reflectance data.
+ * reflectance data. A report sent over UDP carries either the ranges, the
+ * reflectance, or both when they fit in one packet, so either vector may be
+ * empty. Serialization only covers the ranges.
  */
 class MeasurementReport : public Serializable
 {
 public:
   MeasurementReportHeader header;
   vector<EIP_UINT> measurement_data;
+  vector<EIP_UINT> reflectance_data;
 
   /**
    * Size of this message including all measurement data
@@ -94,6 +97,7 @@ public:
     header.deserialize(reader);
     measurement_data.resize(header.num_beams);
     reader.readBytes(&measurement_data[0], measurement_data.size() * sizeof(EIP_UINT));
+    reflectance_data.clear();
     return reader;
   }
 };
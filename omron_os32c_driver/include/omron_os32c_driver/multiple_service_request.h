@@ -0,0 +1,145 @@
+/**
+Software License Agreement (BSD)
+
+\file      multiple_service_request.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_REQUEST_H
+#define OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_REQUEST_H
+
+#include <stdexcept>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/message_router_request.h"
+#include "odva_ethernetip/serialization/reader.h"
+#include "odva_ethernetip/serialization/writer.h"
+#include "odva_ethernetip/serialization/serializable.h"
+
+using std::vector;
+using boost::shared_ptr;
+using eip::MessageRouterRequest;
+using eip::serialization::Serializable;
+using eip::serialization::Reader;
+using eip::serialization::Writer;
+
+namespace omron_os32c_driver {
+
+/**
+ * Data for a CIP Multiple Service Packet request (service 0x0A to the Message
+ * Router), bundling several explicit requests so that they are sent and answered
+ * in a single round trip. The data is the number of services, the offset of each
+ * service request from the start of the data, then the requests themselves.
+ */
+class MultipleServiceRequest : public Serializable
+{
+public:
+  /**
+   * Add a Get_Attribute_Single request
+   * @return Index of the reply for this request
+   */
+  size_t addGetAttribute(EIP_USINT class_id, EIP_USINT instance_id, EIP_USINT attribute_id)
+  {
+    requests_.push_back(MessageRouterRequest(0x0E));
+    requests_.back().getPath() = eip::Path(class_id, instance_id, attribute_id);
+    return requests_.size() - 1;
+  }
+
+  /**
+   * Add a Set_Attribute_Single request
+   * @return Index of the reply for this request
+   */
+  size_t addSetAttribute(EIP_USINT class_id, EIP_USINT instance_id, EIP_USINT attribute_id,
+                         shared_ptr<Serializable> data)
+  {
+    requests_.push_back(MessageRouterRequest(0x10));
+    requests_.back().getPath() = eip::Path(class_id, instance_id, attribute_id);
+    requests_.back().setData(data);
+    return requests_.size() - 1;
+  }
+
+  size_t getCount() const
+  {
+    return requests_.size();
+  }
+
+  /**
+   * Length of the count and offset table plus all of the requests
+   */
+  virtual size_t getLength() const
+  {
+    size_t length = sizeof(EIP_UINT) * (1 + requests_.size());
+    for (size_t i = 0; i < requests_.size(); ++i)
+    {
+      length += requests_[i].getLength();
+    }
+    return length;
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the request data
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    EIP_UINT count = requests_.size();
+    writer.write(count);
+    EIP_UINT offset = sizeof(EIP_UINT) * (1 + requests_.size());
+    for (size_t i = 0; i < requests_.size(); ++i)
+    {
+      writer.write(offset);
+      offset += requests_[i].getLength();
+    }
+    for (size_t i = 0; i < requests_.size(); ++i)
+    {
+      requests_[i].serialize(writer);
+    }
+    return writer;
+  }
+
+  /**
+   * Requests are only ever sent, not received
+   * @throw std::logic_error always
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    throw std::logic_error("Not implemented");
+  }
+
+  /**
+   * Requests are only ever sent, not received
+   * @throw std::logic_error always
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    throw std::logic_error("Not implemented");
+  }
+
+private:
+  vector<MessageRouterRequest> requests_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_REQUEST_H
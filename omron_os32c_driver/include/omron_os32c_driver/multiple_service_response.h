@@ -0,0 +1,219 @@
+/**
+Software License Agreement (BSD)
+
+\file      multiple_service_response.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_RESPONSE_H
+#define OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_RESPONSE_H
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/reader.h"
+#include "odva_ethernetip/serialization/writer.h"
+#include "odva_ethernetip/serialization/serializable.h"
+
+using std::vector;
+using eip::serialization::BufferReader;
+using eip::serialization::Serializable;
+using eip::serialization::Reader;
+using eip::serialization::Writer;
+
+namespace omron_os32c_driver {
+
+/**
+ * Data for a CIP Multiple Service Packet response. Holds the reply to each of
+ * the bundled requests, in the order the requests were made.
+ */
+class MultipleServiceResponse : public Serializable
+{
+public:
+  /**
+   * Reply to one of the bundled requests
+   */
+  struct Reply
+  {
+    EIP_USINT service;
+    EIP_USINT general_status;
+    vector<EIP_BYTE> data;
+  };
+
+  size_t getCount() const
+  {
+    return replies_.size();
+  }
+
+  const Reply& getReply(size_t i) const
+  {
+    return replies_.at(i);
+  }
+
+  /**
+   * Decode the data of a reply
+   * @param i Index of the reply
+   * @param result Holder for the decoded data
+   * @return the result again
+   * @throw std::runtime_error if the request failed on the device
+   * @throw std::length_error if the reply is too short for the result
+   */
+  template <typename T>
+  T& getReplyDataAs(size_t i, T& result) const
+  {
+    checkReply(i);
+    const Reply& reply = getReply(i);
+    BufferReader reader(boost::asio::buffer(reply.data));
+    result.deserialize(reader, reply.data.size());
+    return result;
+  }
+
+  /**
+   * Check that a reply, such as to a set request, succeeded
+   * @param i Index of the reply
+   * @throw std::runtime_error if the request failed on the device
+   */
+  void checkReply(size_t i) const
+  {
+    const Reply& reply = getReply(i);
+    if (reply.general_status)
+    {
+      std::ostringstream msg;
+      msg << "Service 0x" << std::hex << (int)(reply.service & 0x7F) << " failed with status 0x"
+          << (int)reply.general_status;
+      throw std::runtime_error(msg.str());
+    }
+  }
+
+  /**
+   * Length of the count and offset table plus all of the replies
+   */
+  virtual size_t getLength() const
+  {
+    size_t length = sizeof(EIP_UINT) * (1 + replies_.size());
+    for (size_t i = 0; i < replies_.size(); ++i)
+    {
+      length += 4 + replies_[i].data.size();
+    }
+    return length;
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the response data
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    EIP_UINT count = replies_.size();
+    writer.write(count);
+    EIP_UINT offset = sizeof(EIP_UINT) * (1 + replies_.size());
+    for (size_t i = 0; i < replies_.size(); ++i)
+    {
+      writer.write(offset);
+      offset += 4 + replies_[i].data.size();
+    }
+    for (size_t i = 0; i < replies_.size(); ++i)
+    {
+      EIP_USINT reserved = 0;
+      writer.write(replies_[i].service);
+      writer.write(reserved);
+      writer.write(replies_[i].general_status);
+      writer.write(reserved);
+      if (!replies_[i].data.empty())
+      {
+        writer.writeBytes(&replies_[i].data[0], replies_[i].data.size());
+      }
+    }
+    return writer;
+  }
+
+  /**
+   * Deserialize the replies. The total length is needed to find the end of the
+   * last reply.
+   * @param reader Reader to use for deserialization
+   * @param length Length of the response data
+   * @return the reader again
+   * @throw std::length_error if the buffer is overrun while deserializing
+   * @throw std::logic_error if the offsets are inconsistent
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    size_t start = reader.getByteCount();
+    EIP_UINT count;
+    reader.read(count);
+    vector<EIP_UINT> offsets(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      reader.read(offsets[i]);
+    }
+
+    replies_.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      size_t position = reader.getByteCount() - start;
+      size_t end = (i + 1 < count) ? offsets[i + 1] : length;
+      if (offsets[i] < position || end > length || end < offsets[i] + 4u)
+      {
+        throw std::logic_error("Invalid reply offsets in multiple service response");
+      }
+      reader.skip(offsets[i] - position);
+
+      EIP_USINT reserved, additional_status_size;
+      reader.read(replies_[i].service);
+      reader.read(reserved);
+      reader.read(replies_[i].general_status);
+      reader.read(additional_status_size);
+      size_t header_length = 4 + additional_status_size * sizeof(EIP_UINT);
+      if (end < offsets[i] + header_length)
+      {
+        throw std::logic_error("Invalid reply length in multiple service response");
+      }
+      reader.skip(additional_status_size * sizeof(EIP_UINT));
+      replies_[i].data.resize(end - offsets[i] - header_length);
+      if (!replies_[i].data.empty())
+      {
+        reader.readBytes(&replies_[i].data[0], replies_[i].data.size());
+      }
+    }
+    return reader;
+  }
+
+  /**
+   * The length of the data is needed to decode the replies
+   * @throw std::logic_error always
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    throw std::logic_error("Length required to deserialize multiple service response");
+  }
+
+private:
+  vector<Reply> replies_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_RESPONSE_H
@@ -27,20 +27,32 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 #define OMRON_OS32C_DRIVER_OS32C_H
 
 #include <gtest/gtest_prod.h>
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 #include <boost/shared_ptr.hpp>
-#include <sensor_msgs/LaserScan.h>
 
 #include "odva_ethernetip/session.h"
 #include "odva_ethernetip/socket/socket.h"
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/config_cache.h"
 #include "omron_os32c_driver/measurement_report.h"
 #include "omron_os32c_driver/measurement_report_config.h"
+#include "omron_os32c_driver/multiple_service_request.h"
+#include "omron_os32c_driver/multiple_service_response.h"
 #include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/report_decoder.h"
+
+// declared here so that the deprecated ROS conversions below do not pull the
+// message headers into the core library, see scan_conversions.h
+namespace sensor_msgs {
+template <class ContainerAllocator> struct LaserScan_;
+typedef LaserScan_<std::allocator<void> > LaserScan;
+}  // namespace sensor_msgs
 
 using std::vector;
 using boost::shared_ptr;
-using sensor_msgs::LaserScan;
 using eip::Session;
 using eip::socket::Socket;
 
@@ -83,9 +95,12 @@ public:
     : Session(socket, io_socket)
     , start_angle_(ANGLE_MAX)
     , end_angle_(ANGLE_MIN)
+    , selection_pending_(false)
+    , checksum_pending_(false)
     , connection_num_(-1)
     , mrc_sequence_num_(1)
   {
+    report_selection_.addSector(ANGLE_MAX, ANGLE_MIN);
   }
 
   static const double ANGLE_MIN;
@@ -93,6 +108,8 @@ public:
   static const double ANGLE_INC;
   static const double DISTANCE_MIN;
   static const double DISTANCE_MAX;
+  /// Size of the data of a UDP measurement report: the sequence count, the header and 677 ranges
+  static const EIP_UINT UDP_REPORT_SIZE = 0x0584;
 
   /**
    * Get the range format code. Does a Get Single Attribute to the scanner
@@ -136,6 +153,106 @@ public:
    */
   void selectBeams(double start_angle, double end_angle);
 
+  /**
+   * Select an arbitrary set of beams to be measured, such as several sectors or
+   * every Nth beam. Only the selected beams are transferred in each report.
+   * @param selection Beams to measure
+   * @throw std::invalid_argument if no beams are selected
+   */
+  void selectBeams(const BeamSelection& selection);
+
+  /**
+   * Change the beam selection without writing it to the device. In implicit
+   * mode the new mask is sent with the next sendMeasurmentReportConfigUDP().
+   * @param selection Beams to measure
+   * @throw std::invalid_argument if no beams are selected
+   */
+  void setBeamSelection(const BeamSelection& selection);
+
+  /**
+   * Get the beams most recently selected for measurement. Reports may still
+   * be using the previous selection until updateReportSelection() switches over.
+   */
+  const BeamSelection& getBeamSelection() const
+  {
+    return selection_;
+  }
+
+  /**
+   * Beams the latest reports are converted for, as switched by updateReportSelection()
+   */
+  const BeamSelection& getReportSelection() const
+  {
+    return report_selection_;
+  }
+
+  /**
+   * Switch the conversion of reports over to a newly selected set of beams once
+   * reports with the new number of beams arrive. Should be called with every
+   * report received. If the previous selection had the same number of beams, the
+   * switch happens with the first report after the selection was made.
+   * @param num_beams Number of beams in the latest report
+   * @return true if the selection changed, and any static config based on it
+   *  (such as the angles of converted scans) needs to be refreshed
+   */
+  bool updateReportSelection(EIP_UINT num_beams);
+
+  /**
+   * Send a batch of explicit requests as a single CIP Multiple Service Packet
+   * @param request Requests to send
+   * @return Replies to the requests, in the same order
+   * @throw std::runtime_error if the packet as a whole is rejected, which
+   *  includes any of the bundled requests failing
+   * @throw std::logic_error if the number of replies does not match
+   */
+  MultipleServiceResponse sendMultipleServices(const MultipleServiceRequest& request);
+
+  /**
+   * Apply the measurement configuration, only writing what the sensor does not
+   * already have. If the config cache holds the requested configuration, a single
+   * report header is read, and nothing else is done if the sensor still reports
+   * the cached checksum, formats and number of beams. Otherwise the current
+   * formats and beam mask are read in one Multiple Service Packet, then whatever
+   * differs is written in a second one. The checksum of the next report then
+   * completes the cache entry.
+   * @param range_format The range format code to set
+   * @param reflectivity_format The reflectivity format code to set
+   * @param selection Beams to measure
+   * @return Number of attributes written to the sensor
+   * @throw std::invalid_argument if no beams are selected
+   */
+  int applyConfiguration(EIP_UINT range_format, EIP_UINT reflectivity_format, const BeamSelection& selection);
+
+  /**
+   * Check the config checksum of a received report against the config cache. The
+   * first report after applyConfiguration() read the configuration completes the
+   * cache entry.
+   * @param header Header of the latest report
+   * @return false if the configuration of the sensor was changed by something
+   *  else, in which case the cache is invalidated
+   */
+  bool checkConfigChecksum(const MeasurementReportHeader& header);
+
+  const ConfigCache& getConfigCache() const
+  {
+    return config_cache_;
+  }
+
+  /**
+   * Seed the config cache, such as with one saved by a previous run
+   */
+  void setConfigCache(const ConfigCache& cache)
+  {
+    config_cache_ = cache;
+    checksum_pending_ = false;
+  }
+
+  /**
+   * Make an explicit request for a single report, only decoding the header
+   * @return Header of the report received
+   */
+  MeasurementReportHeader getMeasurementReportHeader();
+
   /**
    * Make an explicit request for a single Range and Reflectance scan
    * @return Range and reflectance data received
@@ -143,6 +260,32 @@ public:
    */
   RangeAndReflectanceMeasurement getSingleRRScan();
 
+  /**
+   * Make an explicit request for a single Range and Reflectance scan, reusing
+   * the storage of the given measurement to avoid allocation on every scan.
+   * @param rr Measurement to fill with the data received
+   * @throw std::logic_error if data not received
+   */
+  void getSingleRRScan(RangeAndReflectanceMeasurement& rr);
+
+  /**
+   * Make an explicit request for a single Range and Reflectance scan, returning
+   * rather than throwing if the report cannot be decoded. The outcome is also
+   * added to the report counters.
+   * @param rr Measurement to fill with the data received
+   * @return REPORT_OK, or what was wrong with the report
+   * @throw std::runtime_error if the request itself fails, such as on a timeout
+   */
+  ReportStatus tryGetSingleRRScan(RangeAndReflectanceMeasurement& rr);
+
+  /**
+   * Get the counts of reports decoded and of each kind of malformed report
+   */
+  const ReportCounters& getReportCounters() const
+  {
+    return report_counters_;
+  }
+
   /**
    * Calculate the beam number on the lidar for a given ROS angle. Note that
    * in ROS angles are given as radians CCW with zero being straight ahead,
@@ -171,23 +314,39 @@ public:
   }
 
   /**
-   * Populate the unchanging parts of a ROS LaserScan, including the start_angle and stop_angle,
-   * which are configured by the user but ultimately reported by the device.
+   * Get the most beams whose measurements fit in one UDP measurement report.
+   * With more beams selected, a report with both ranges and reflectance
+   * requested only holds the ranges.
+   * @param with_reflectance True for the reflectance to be sent along with the ranges
+   * @return Number of beams
+   */
+  static inline size_t getMaxUDPBeams(bool with_reflectance)
+  {
+    size_t beams = (UDP_REPORT_SIZE - sizeof(EIP_UINT) - 56) / (with_reflectance ? 4 : 2);
+    return std::min(beams, static_cast<size_t>(BeamSelection::NUM_BEAMS));
+  }
+
+  /**
+   * Populate the unchanging parts of a ROS LaserScan for the report selection.
+   * Defined in the omron_os32c library, which must be linked to use it.
+   * @deprecated Use the free fillLaserScanStaticConfig() in scan_conversions.h
    * @param ls Laserscan message to populate.
    */
   void fillLaserScanStaticConfig(sensor_msgs::LaserScan* ls);
 
   /**
-   * Helper to convert a Range and Reflectance Measurement to a ROS LaserScan. LaserScan
-   * is passed as a pointer to avoid a bunch of memory allocation associated with resizing a vector
-   * on each scan.
+   * Helper to convert a Range and Reflectance Measurement to a ROS LaserScan.
+   * Defined in the omron_os32c library, which must be linked to use it.
+   * @deprecated Use the free convertToLaserScan() in scan_conversions.h
    * @param rr Measurement to convert
    * @param ls Laserscan message to populate.
    */
   static void convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls);
 
   /**
-   * Helper to convert a Measurement Report to a ROS LaserScan
+   * Helper to convert a Measurement Report to a ROS LaserScan.
+   * Defined in the omron_os32c library, which must be linked to use it.
+   * @deprecated Use the free convertToLaserScan() in scan_conversions.h
    * @param mr Measurement to convert
    * @param ls Laserscan message to populate.
    */
@@ -197,6 +356,18 @@ public:
 
   MeasurementReport receiveMeasurementReportUDP();
 
+  /**
+   * Receive a measurement report over UDP, returning rather than throwing if
+   * the packet cannot be decoded. Packets that are not newer than the last one
+   * accepted on the connection are dropped before their beams are decoded.
+   * The outcome is also added to the report counters. A report may hold the
+   * ranges, the reflectance or both, and a ReportAssembler makes scans of them.
+   * @param report Measurement to fill with the data received
+   * @return REPORT_OK, or what was wrong with the packet
+   * @throw std::runtime_error if receiving fails
+   */
+  ReportStatus tryReceiveMeasurementReportUDP(MeasurementReport& report);
+
   void startUDPIO();
 
   void closeActiveConnection();
@@ -211,12 +382,22 @@ private:
 
   double start_angle_;
   double end_angle_;
+  BeamSelection selection_;
+  BeamSelection report_selection_;
+  bool selection_pending_;
+  ConfigCache config_cache_;
+  bool checksum_pending_;
 
   // data for sending to lidar to keep UDP session alive
   int connection_num_;
   MeasurementReportConfig mrc_;
   EIP_UDINT mrc_sequence_num_;
 
+  // undecoded bytes of the last report, and the outcomes of decoding so far
+  ReportBuffer report_buffer_;
+  ReportCounters report_counters_;
+  SequenceTracker io_sequence_;
+
   /**
    * Helper to calculate the mask for a given start and end beam angle
    * @param start_angle Angle of the first beam in the scan
@@ -224,6 +405,16 @@ private:
    * @param mask Holder for the mask data. Must be 88 bytes
    */
   void calcBeamMask(double start_angle, double end_angle, EIP_BYTE mask[]);
+
+  /**
+   * Send the beam mask in the measurement report config to the device
+   */
+  void sendBeamMask();
+
+  /**
+   * Forget the cached configuration after writing to the sensor directly
+   */
+  void invalidateConfigCache();
 };
 
 }  // namespace omron_os32c_driver
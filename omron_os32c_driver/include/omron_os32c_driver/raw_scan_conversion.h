@@ -0,0 +1,93 @@
+/**
+Software License Agreement (BSD)
+
+\file      raw_scan_conversion.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_RAW_SCAN_CONVERSION_H
+#define OMRON_OS32C_DRIVER_RAW_SCAN_CONVERSION_H
+
+#include <limits>
+#include <stdexcept>
+#include <sensor_msgs/LaserScan.h>
+
+#include "omron_os32c_driver/RawScan.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Expand a RawScan back into the LaserScan the driver would have published.
+ * Header only, so that consumers need nothing but the message definitions.
+ * Indices without a measurement get a NaN range and zero intensity.
+ * @param raw Scan to convert
+ * @param ls Laserscan message to populate. Passed as a pointer so that its
+ *  vectors can be reused between scans.
+ * @throw std::invalid_argument if the vectors of the scan are inconsistent
+ */
+inline void convertRawScanToLaserScan(const RawScan& raw, sensor_msgs::LaserScan* ls)
+{
+  if ((!raw.indices.empty() && raw.indices.size() != raw.ranges.size()) ||
+      (!raw.intensities.empty() && raw.intensities.size() != raw.ranges.size()))
+  {
+    throw std::invalid_argument("Number of beams does not match vector size");
+  }
+
+  ls->header = raw.header;
+  ls->angle_min = raw.angle_min;
+  ls->angle_max = raw.angle_max;
+  ls->angle_increment = raw.angle_increment;
+  ls->time_increment = raw.time_increment;
+  ls->scan_time = raw.scan_time;
+  ls->range_min = raw.range_min;
+  ls->range_max = raw.range_max;
+
+  size_t num_indices = raw.indices.empty() ? raw.ranges.size() : raw.indices.back() + 1;
+  ls->ranges.assign(num_indices, std::numeric_limits<float>::quiet_NaN());
+  ls->intensities.assign(raw.intensities.empty() ? 0 : num_indices, 0);
+  for (size_t i = 0; i < raw.ranges.size(); ++i)
+  {
+    size_t index = raw.indices.empty() ? i : raw.indices[i];
+    if (index >= num_indices)
+    {
+      throw std::invalid_argument("Indices are not in ascending order");
+    }
+    if (raw.ranges[i] == RawScan::RANGE_NOISY)
+    {
+      ls->ranges[index] = 0;
+    }
+    else if (raw.ranges[i] == RawScan::RANGE_NO_RETURN)
+    {
+      ls->ranges[index] = raw.range_max;
+    }
+    else
+    {
+      ls->ranges[index] = raw.ranges[i] / 1000.0;
+    }
+    if (!raw.intensities.empty())
+    {
+      ls->intensities[index] = raw.intensities[i];
+    }
+  }
+}
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_RAW_SCAN_CONVERSION_H
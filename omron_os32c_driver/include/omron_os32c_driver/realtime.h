@@ -0,0 +1,92 @@
+/**
+Software License Agreement (BSD)
+
+\file      realtime.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_REALTIME_H
+#define OMRON_OS32C_DRIVER_REALTIME_H
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Real-time options requested for the thread that talks to the sensor
+ */
+struct RealtimeSettings
+{
+  RealtimeSettings() : priority(0), lock_memory(false)
+  {
+  }
+
+  /// SCHED_FIFO priority, or 0 to keep the default scheduler
+  int priority;
+  /// CPUs to run on, or empty to keep the inherited affinity
+  vector<int> cpus;
+  /// Lock current and future memory with mlockall()
+  bool lock_memory;
+};
+
+/**
+ * Settings actually in effect after applying RealtimeSettings, with the reason
+ * for anything that could not be applied.
+ */
+struct RealtimeStatus
+{
+  RealtimeStatus() : priority(0), lock_memory(false)
+  {
+  }
+
+  /// Effective SCHED_FIFO priority, or 0 if running with the default scheduler
+  int priority;
+  /// CPUs the thread may run on
+  vector<int> cpus;
+  /// Whether memory is locked
+  bool lock_memory;
+  /// One message per setting that could not be applied
+  vector<string> errors;
+};
+
+/**
+ * Apply real-time settings to the calling thread. Settings the process is not
+ * permitted to use, such as SCHED_FIFO without CAP_SYS_NICE or an rtprio limit,
+ * are left as they were and reported in the errors of the status.
+ * @param settings Settings to apply
+ * @return Effective settings
+ * @throw std::invalid_argument if the priority or a CPU number is out of range
+ */
+RealtimeStatus applyRealtimeSettings(const RealtimeSettings& settings);
+
+/**
+ * Touch the given amount of stack so that it is mapped, and locked if memory
+ * is locked, before it is needed in the acquisition loop
+ * @param size Number of bytes of stack to prefault
+ */
+void prefaultStack(size_t size);
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_REALTIME_H
@@ -0,0 +1,99 @@
+/**
+Software License Agreement (BSD)
+
+\file      reconnect_backoff.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_RECONNECT_BACKOFF_H
+#define OMRON_OS32C_DRIVER_RECONNECT_BACKOFF_H
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace omron_os32c_driver {
+
+/**
+ * Delay schedule for reconnecting to the sensor. The first attempt after a
+ * loss of connection is immediate, since most outages are short network blips.
+ * After that the delay starts at initial_delay and doubles with each failed
+ * attempt, up to max_delay.
+ */
+class ReconnectBackoff
+{
+public:
+  /**
+   * @param initial_delay Delay after the first failed attempt, in seconds
+   * @param max_delay Longest delay between attempts, in seconds
+   */
+  ReconnectBackoff(double initial_delay, double max_delay)
+    : initial_delay_(initial_delay), max_delay_(max_delay), delay_(0), attempts_(0)
+  {
+    if (initial_delay <= 0 || max_delay < initial_delay)
+    {
+      throw std::invalid_argument("Backoff delays must be positive and max_delay at least initial_delay");
+    }
+  }
+
+  /**
+   * Delay to wait before the next attempt, in seconds
+   */
+  double getDelay() const
+  {
+    return delay_;
+  }
+
+  /**
+   * Number of failed attempts since the last reset
+   */
+  int getAttempts() const
+  {
+    return attempts_;
+  }
+
+  /**
+   * Record a failed attempt, increasing the delay before the next one
+   */
+  void failed()
+  {
+    delay_ = attempts_ ? std::min(delay_ * 2, max_delay_) : std::min(initial_delay_, max_delay_);
+    ++attempts_;
+  }
+
+  /**
+   * Record a successful connection, so that the next loss of connection is
+   * retried immediately
+   */
+  void reset()
+  {
+    delay_ = 0;
+    attempts_ = 0;
+  }
+
+private:
+  double initial_delay_;
+  double max_delay_;
+  double delay_;
+  int attempts_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_RECONNECT_BACKOFF_H
@@ -0,0 +1,284 @@
+/**
+Software License Agreement (BSD)
+
+\file      report_decoder.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_REPORT_DECODER_H
+#define OMRON_OS32C_DRIVER_REPORT_DECODER_H
+
+#include <boost/cstdint.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/serialization/reader.h"
+#include "odva_ethernetip/serialization/serializable.h"
+#include "odva_ethernetip/serialization/writer.h"
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+
+using eip::serialization::Serializable;
+using eip::serialization::Reader;
+using eip::serialization::Writer;
+
+namespace omron_os32c_driver {
+
+/**
+ * Outcome of decoding a report. Malformed, duplicated and reordered reports are
+ * expected now and then on a busy network, so they are returned and counted
+ * rather than thrown.
+ */
+enum ReportStatus
+{
+  REPORT_OK = 0,
+  /// The response carried no data at all
+  REPORT_NO_DATA,
+  /// Shorter than the header, or than the beams the header announces
+  REPORT_TOO_SHORT,
+  /// Longer than the beams the header announces, or than any valid report
+  REPORT_TOO_LONG,
+  /// The header announces more beams than the sensor has
+  REPORT_TOO_MANY_BEAMS,
+  /// An IO packet that cannot be parsed, or without the expected items
+  REPORT_BAD_PACKET,
+  /// An IO packet with the same sequence number as the last one accepted
+  REPORT_DUPLICATE,
+  /// An IO packet older than the last one accepted
+  REPORT_STALE,
+  /// An IO packet for another connection than the open one, such as an earlier one
+  REPORT_WRONG_CONNECTION,
+  NUM_REPORT_STATUSES
+};
+
+/**
+ * Get a short description of a status for logs and diagnostics
+ */
+const char* getReportStatusName(ReportStatus status);
+
+/**
+ * Holder for the undecoded bytes of a report, so that their length can be
+ * checked once before anything is decoded. Holds a full scan with ranges and
+ * reflectances without allocating; anything longer is noted but not read.
+ */
+class ReportBuffer : public Serializable
+{
+public:
+  static const size_t CAPACITY = 56 + 2 * BeamSelection::NUM_BEAMS * sizeof(EIP_UINT);
+
+  ReportBuffer() : length_(0)
+  {
+  }
+
+  /**
+   * Number of bytes received, which may be more than were kept
+   */
+  virtual size_t getLength() const
+  {
+    return length_;
+  }
+
+  const EIP_BYTE* getData() const
+  {
+    return data_;
+  }
+
+  bool isOverflowed() const
+  {
+    return length_ > CAPACITY;
+  }
+
+  virtual Writer& serialize(Writer& writer) const
+  {
+    writer.writeBytes(data_, isOverflowed() ? CAPACITY : length_);
+    return writer;
+  }
+
+  /**
+   * Keep the given number of bytes, or only note the length if they do not fit
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    length_ = length;
+    if (length > 0 && !isOverflowed())
+    {
+      reader.readBytes(data_, length);
+    }
+    return reader;
+  }
+
+  /**
+   * Reports are only ever read with the length of the packet. Without it,
+   * nothing is read and the buffer is empty.
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    length_ = 0;
+    return reader;
+  }
+
+private:
+  EIP_BYTE data_[CAPACITY];
+  size_t length_;
+};
+
+/**
+ * Decode a Range and Reflectance Measurement, checking the length against the
+ * number of beams in the header before any beam data is copied. The storage of
+ * the measurement is reused. A report taken without reflectivity measurements
+ * carries only ranges, and leaves the reflectance empty.
+ * @param report Bytes of the report
+ * @param rr Measurement to fill. Only the header is valid if decoding fails.
+ * @return REPORT_OK, or what was wrong with the report
+ */
+ReportStatus decodeRangeAndReflectance(const ReportBuffer& report, RangeAndReflectanceMeasurement* rr);
+
+/**
+ * Decode a Measurement Report, as sent over UDP, in the same way. The formats
+ * in the header and the length tell whether the report holds the ranges, the
+ * reflectance, or both, and the vectors of what it does not hold are left empty.
+ * @param report Bytes of the report, after the sequence number of the data item
+ * @param mr Measurement to fill. Only the header is valid if decoding fails.
+ * @return REPORT_OK, or what was wrong with the report
+ */
+ReportStatus decodeMeasurementReport(const ReportBuffer& report, MeasurementReport* mr);
+
+/**
+ * Orders the IO packets of one connection by the sequence number of their
+ * address item, which counts up by one per packet and wraps around. Only
+ * packets newer than every packet accepted so far are accepted, so that a
+ * datagram the network delayed or duplicated is dropped before its beams are
+ * decoded.
+ */
+class SequenceTracker
+{
+public:
+  /// A packet further behind than this is taken as the sender starting over
+  static const EIP_UDINT MAX_REORDER = 64;
+
+  SequenceTracker() : valid_(false), last_(0)
+  {
+  }
+
+  /**
+   * Check a packet and, if it is accepted, remember its sequence number
+   * @param sequence Sequence number of the packet
+   * @return REPORT_OK if the packet is newer than the last one accepted, or
+   *  the first since a reset, otherwise REPORT_DUPLICATE or REPORT_STALE
+   */
+  ReportStatus check(EIP_UDINT sequence);
+
+  /**
+   * Accept whatever packet comes next, such as on a new connection
+   */
+  void reset()
+  {
+    valid_ = false;
+  }
+
+private:
+  bool valid_;
+  EIP_UDINT last_;
+};
+
+/**
+ * Turns the Measurement Reports of a UDP connection into whole scans. A report
+ * with the ranges, and the reflectance if it fits, is a scan on its own. A
+ * report with only the reflectance has no ranges to go with and is dropped.
+ *
+ * Only this primitive is provided for users of the implicit messaging path.
+ * The driver itself polls scans over explicit messaging, and nothing sets the
+ * sensor up to split the ranges and the reflectance of a scan over reports.
+ */
+class ReportAssembler
+{
+public:
+  ReportAssembler();
+
+  /**
+   * Add a decoded report
+   * @param report Report received
+   * @return true if the report is a scan, which getScan() then returns
+   */
+  bool add(const MeasurementReport& report);
+
+  /**
+   * Get the latest complete scan. Its storage is reused by the next scan.
+   */
+  const RangeAndReflectanceMeasurement& getScan() const
+  {
+    return scan_;
+  }
+
+  /**
+   * Get the number of reports dropped for having no ranges
+   */
+  boost::uint64_t getDropped() const
+  {
+    return dropped_;
+  }
+
+private:
+  RangeAndReflectanceMeasurement scan_;
+  boost::uint64_t dropped_;
+};
+
+/**
+ * Counts of decoded reports by status, for diagnostics in place of a log
+ * message per bad packet
+ */
+class ReportCounters
+{
+public:
+  ReportCounters()
+  {
+    reset();
+  }
+
+  /**
+   * Count a report
+   * @return The status again, so that a report can be counted and returned
+   *  in one statement
+   */
+  ReportStatus count(ReportStatus status)
+  {
+    ++counts_[status];
+    return status;
+  }
+
+  boost::uint64_t get(ReportStatus status) const
+  {
+    return counts_[status];
+  }
+
+  /**
+   * Get the number of reports that were dropped, for any reason
+   */
+  boost::uint64_t getErrors() const;
+
+  void reset();
+
+private:
+  boost::uint64_t counts_[NUM_REPORT_STATUSES];
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_REPORT_DECODER_H
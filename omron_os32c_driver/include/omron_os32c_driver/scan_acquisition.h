@@ -0,0 +1,139 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_acquisition.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_ACQUISITION_H
+#define OMRON_OS32C_DRIVER_SCAN_ACQUISITION_H
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/scan_filter_chain.h"
+#include "omron_os32c_driver/scan_observer.h"
+#include "omron_os32c_driver/temporal_median_filter.h"
+
+using std::vector;
+using boost::shared_ptr;
+
+namespace omron_os32c_driver {
+
+/**
+ * Polls scans from an OS32C, runs them through the optional median filter and
+ * filter chain, and hands each one to the registered observers. Raw observers,
+ * such as recorders, see each scan as the sensor sent it, before any filter.
+ * Nothing here depends on ROS, so the same acquisition can feed any front end.
+ *
+ * The measurement buffers are sized for a full scan up front and reused, so
+ * polling does not allocate once the first scan has been received.
+ */
+class ScanAcquisition
+{
+public:
+  /**
+   * @param os32c Sensor to poll. Must outlive this object.
+   */
+  ScanAcquisition(OS32C* os32c);
+
+  /**
+   * Register an observer to be called with each scan, in order of registration.
+   * @param observer Observer to add. Must stay valid until removed.
+   */
+  void addObserver(ScanObserver* observer);
+
+  void removeObserver(ScanObserver* observer);
+
+  /**
+   * Register an observer to be called with each scan before the median filter
+   * and the filter chain are applied. Raw observers are called before the
+   * others, in order of registration.
+   * @param observer Observer to add. Must stay valid until removed.
+   */
+  void addRawObserver(ScanObserver* observer);
+
+  void removeRawObserver(ScanObserver* observer);
+
+  /**
+   * Set the median filter to apply to the ranges, or an empty pointer for none
+   */
+  void setMedianFilter(shared_ptr<TemporalMedianFilter> median_filter)
+  {
+    median_filter_ = median_filter;
+  }
+
+  /**
+   * Set the filter chain to apply to the ranges, or an empty pointer for none.
+   * The chain is configured whenever the report selection changes.
+   */
+  void setFilterChain(shared_ptr<ScanFilterChain> filter_chain)
+  {
+    filter_chain_ = filter_chain;
+  }
+
+  /**
+   * Start over after connecting. Filter history is dropped and the next scan
+   * is flagged as having a changed selection.
+   */
+  void reset();
+
+  /**
+   * Request a single scan from the sensor and deliver it to the observers on
+   * the calling thread.
+   * @return The measurement, valid until the next poll
+   * @throw std::runtime_error if the request fails
+   * @throw std::logic_error if the data cannot be decoded
+   */
+  const RangeAndReflectanceMeasurement& poll();
+
+  /**
+   * Request a single scan as poll() does, but return rather than throw if the
+   * report cannot be decoded. Observers are only called for decoded scans.
+   * @return REPORT_OK, with the measurement available from getReport(), or
+   *  what was wrong with the report
+   * @throw std::runtime_error if the request fails
+   */
+  ReportStatus tryPoll();
+
+  /**
+   * Get the measurement of the last successful poll
+   */
+  const RangeAndReflectanceMeasurement& getReport() const
+  {
+    return report_;
+  }
+
+private:
+  OS32C* os32c_;
+  vector<ScanObserver*> raw_observers_;
+  vector<ScanObserver*> observers_;
+  shared_ptr<TemporalMedianFilter> median_filter_;
+  shared_ptr<ScanFilterChain> filter_chain_;
+  RangeAndReflectanceMeasurement report_;
+  RangeAndReflectanceMeasurement spare_report_;
+  bool selection_changed_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_ACQUISITION_H
@@ -0,0 +1,145 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_codec.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_CODEC_H
+#define OMRON_OS32C_DRIVER_SCAN_CODEC_H
+
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/*
+ * Lossless encoding of the ranges and reflectances of consecutive scans. Beams
+ * change little from one scan to the next, so each value is stored as the
+ * difference from the same beam in the previous scan, zigzag mapped so that
+ * small negative differences are small numbers, as a base 128 varint. Most
+ * beams of a static scene then take one byte instead of two.
+ *
+ * A block is a flags byte, the number of beams as a varint, the ranges and,
+ * if the flags say so, the reflectances. A keyframe stores differences from
+ * the previous beam of the same scan instead, so that it can be decoded on its
+ * own and a reader can start at it.
+ */
+
+/**
+ * Encodes scans as blocks that depend on the blocks before them, back to the
+ * last keyframe
+ */
+class ScanEncoder
+{
+public:
+  /**
+   * @param keyframe_interval Number of scans from one keyframe to the next,
+   *  or 1 to make every scan a keyframe
+   * @throw std::invalid_argument if the interval is zero
+   */
+  ScanEncoder(size_t keyframe_interval);
+
+  /**
+   * Append the block of a scan. A keyframe is written when the interval is
+   * up, after forceKeyframe(), and whenever the number of beams or the
+   * presence of reflectances differs from the previous scan.
+   * @param ranges Range codes of each beam
+   * @param reflectance Reflectance of each beam, or NULL if there is none
+   * @param num_beams Number of beams in the scan
+   * @param out Buffer to append the block to
+   * @return true if the block is a keyframe
+   */
+  bool encode(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams, vector<EIP_BYTE>* out);
+
+  /**
+   * Make the next block a keyframe, such as at the start of a log chunk
+   */
+  void forceKeyframe()
+  {
+    since_keyframe_ = keyframe_interval_;
+  }
+
+private:
+  size_t keyframe_interval_;
+  size_t since_keyframe_;
+  bool has_reflectance_;
+  vector<EIP_UINT> ranges_;
+  vector<EIP_UINT> reflectance_;
+};
+
+/**
+ * Decodes the blocks written by a ScanEncoder, which must be given in order
+ * starting at a keyframe
+ */
+class ScanDecoder
+{
+public:
+  ScanDecoder();
+
+  /**
+   * Check whether a block is a keyframe without decoding it
+   * @param data Start of the block
+   */
+  static bool isKeyframe(const EIP_BYTE* data);
+
+  /**
+   * Decode one block
+   * @param data Start of the block
+   * @param size Number of bytes available from the start of the block
+   * @return Number of bytes in the block
+   * @throw std::runtime_error if the block is truncated or malformed, has more
+   *  beams than the sensor, or is not a keyframe and does not follow one
+   */
+  size_t decode(const EIP_BYTE* data, size_t size);
+
+  /**
+   * Forget the previous scan, so that only a keyframe is accepted next
+   */
+  void reset()
+  {
+    valid_ = false;
+  }
+
+  const vector<EIP_UINT>& getRanges() const
+  {
+    return ranges_;
+  }
+
+  /**
+   * Get the reflectances of the last block, which is empty if it had none
+   */
+  const vector<EIP_UINT>& getReflectance() const
+  {
+    return reflectance_;
+  }
+
+private:
+  bool valid_;
+  vector<EIP_UINT> ranges_;
+  vector<EIP_UINT> reflectance_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_CODEC_H
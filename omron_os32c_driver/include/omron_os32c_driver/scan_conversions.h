@@ -0,0 +1,135 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_conversions.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_CONVERSIONS_H
+#define OMRON_OS32C_DRIVER_SCAN_CONVERSIONS_H
+
+#include <sensor_msgs/LaserScan.h>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/RawScan.h"
+#include "omron_os32c_driver/scan_view.h"
+#include "omron_os32c_driver/sector_minima.h"
+#include "omron_os32c_driver/SectorRanges.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Populate the unchanging parts of a ROS LaserScan for a beam selection, including
+ * the angles of the first and last beams.
+ * @param selection Beams the scans are measured with
+ * @param ls Laserscan message to populate.
+ */
+void fillLaserScanStaticConfig(const BeamSelection& selection, sensor_msgs::LaserScan* ls);
+
+/**
+ * Helper to convert a decoded scan to a ROS LaserScan. LaserScan is passed as a
+ * pointer to avoid a bunch of memory allocation associated with resizing a vector
+ * on each scan. Intensities are cleared if the scan has no reflectance.
+ * @param scan Scan to convert
+ * @param ls Laserscan message to populate.
+ */
+void convertToLaserScan(const ScanView& scan, sensor_msgs::LaserScan* ls);
+
+/**
+ * Helper to convert a Range and Reflectance Measurement to a ROS LaserScan
+ * @param rr Measurement to convert
+ * @param ls Laserscan message to populate.
+ * @throw std::invalid_argument if the number of beams does not match the data
+ */
+void convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls);
+
+/**
+ * Helper to convert a Measurement Report to a ROS LaserScan
+ * @param mr Measurement to convert
+ * @param ls Laserscan message to populate.
+ * @throw std::invalid_argument if the number of beams does not match the data
+ */
+void convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls);
+
+/**
+ * Spread the ranges and intensities of a converted scan out so that each beam is
+ * at its angle for the beam selection. Angles without a measured beam get a NaN
+ * range. Does nothing if the selected beams are contiguous.
+ * @param selection Beams the scan was measured with
+ * @param ls Laserscan message converted from a measurement with the selection
+ */
+void expandToBeamSelection(const BeamSelection& selection, sensor_msgs::LaserScan* ls);
+
+/**
+ * Populate the unchanging parts of a RawScan, matching fillLaserScanStaticConfig
+ * and expandToBeamSelection for the beam selection.
+ * @param selection Beams the scans are measured with
+ * @param raw RawScan message to populate.
+ */
+void fillRawScanStaticConfig(const BeamSelection& selection, RawScan* raw);
+
+/**
+ * Helper to copy a decoded scan into a RawScan, keeping the sensor units. The
+ * vectors of the message are reused between scans.
+ * @param scan Scan to convert
+ * @param raw RawScan message to populate.
+ */
+void convertToRawScan(const ScanView& scan, RawScan* raw);
+
+/**
+ * Reverse the beams of a converted LaserScan, ranges and intensities alike, for
+ * a sensor mounted upside down. The angles are left as they are.
+ * @param ls Laserscan message to invert, after expandToBeamSelection()
+ */
+void invertLaserScan(sensor_msgs::LaserScan* ls);
+
+/**
+ * Flip the indices of a RawScan for a sensor mounted upside down, so that
+ * expanding the inverted scan gives the inverted LaserScan.
+ * @param raw RawScan message populated by fillRawScanStaticConfig()
+ */
+void invertRawScanStaticConfig(RawScan* raw);
+
+/**
+ * Reverse the beams of a converted RawScan, matching invertLaserScan().
+ * @param raw RawScan message to invert
+ */
+void invertRawScan(RawScan* raw);
+
+/**
+ * Helper to convert the nearest returns of a scan, as found by SectorMinima::reduce(),
+ * to a SectorRanges message. The angles are those of the same beams in the
+ * LaserScan published for the scan, and the bounds of a sector are the angles
+ * of its first and last measured beams. The vectors of the message are reused
+ * between scans.
+ * @param minima Sectors with the scan reduced
+ * @param ls Laserscan message with the static config of the selection the
+ *  minima were configured with, from fillLaserScanStaticConfig()
+ * @param invert_scan True if the LaserScan is reversed by invertLaserScan()
+ * @param sectors SectorRanges message to populate.
+ */
+void convertToSectorRanges(const SectorMinima& minima, const sensor_msgs::LaserScan& ls, bool invert_scan,
+                           SectorRanges* sectors);
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_CONVERSIONS_H
@@ -0,0 +1,80 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_deskewer.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_DESKEWER_H
+#define OMRON_OS32C_DRIVER_SCAN_DESKEWER_H
+
+#include <vector>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Removes the distortion caused by sensor motion during a scan. The OS32C
+ * measures its beams one after the other, scan_beam_period apart, so a full
+ * sweep takes about 40 ms. Assuming the planar velocity of the sensor is constant
+ * over a scan, the motion over the sweep is computed once per scan and each beam
+ * is moved into the sensor frame at the time of the last beam.
+ */
+class ScanDeskewer
+{
+public:
+  ScanDeskewer();
+
+  /**
+   * Set up the per-beam tables for the geometry of the given scan. Only does work
+   * if the geometry has changed since the last call.
+   * @param ls Scan with the angle and beam count to expect
+   * @param reverse_time True if the beams are stored in the opposite order from
+   *  which they were measured, such as when the scan is inverted
+   */
+  void configure(const sensor_msgs::LaserScan& ls, bool reverse_time);
+
+  /**
+   * Convert a scan to a point cloud, correcting for the motion of the sensor.
+   * The velocities are in the frame of the sensor. Beams without a valid range
+   * are reported as NaN points, so the cloud keeps one point per beam.
+   * @param ls Scan to convert. Must match the last call to configure
+   * @param vx Linear velocity along the x axis of the sensor in m/s
+   * @param vy Linear velocity along the y axis of the sensor in m/s
+   * @param wz Angular velocity around the z axis of the sensor in rad/s
+   * @param cloud Cloud to populate with x, y, z and intensity fields
+   */
+  void deskew(const sensor_msgs::LaserScan& ls, double vx, double vy, double wz,
+              sensor_msgs::PointCloud2* cloud) const;
+
+private:
+  float angle_min_;
+  float angle_increment_;
+  bool reverse_time_;
+  vector<float> cos_table_;
+  vector<float> sin_table_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_DESKEWER_H
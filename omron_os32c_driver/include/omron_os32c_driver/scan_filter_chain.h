@@ -0,0 +1,133 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_filter_chain.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_FILTER_CHAIN_H
+#define OMRON_OS32C_DRIVER_SCAN_FILTER_CHAIN_H
+
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/beam_selection.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Spatial filters applied to the raw ranges of a report, before conversion:
+ * range clipping, per-beam minimum ranges to mask out the robot itself, and
+ * removal of the shadow (veiling) points seen at object edges, where a beam
+ * partly hits both the edge and the background.
+ *
+ * Everything that depends on which beams are reported is computed into
+ * per-beam tables by configure(), so filtering a scan is one pass to find the
+ * shadows and one to apply them along with the range limits. Removed beams are
+ * set to FILTERED, which converts like a noisy beam.
+ */
+class ScanFilterChain
+{
+public:
+  static const EIP_UINT FILTERED = 0x0001;
+
+  ScanFilterChain();
+
+  /**
+   * Remove beams outside of a range band
+   * @param min_range Minimum range to keep in meters
+   * @param max_range Maximum range to keep in meters
+   * @throw std::invalid_argument if the band is empty or negative
+   */
+  void setRangeLimits(double min_range, double max_range);
+
+  /**
+   * Remove beams in a sector that are closer than a minimum range, such as
+   * where the chassis of the robot is in view. Overlapping masks use the
+   * largest minimum range.
+   * @param start_angle Most CCW angle of the sector
+   * @param end_angle Most CW angle of the sector
+   * @param min_range Minimum range to keep in meters
+   * @throw std::invalid_argument if the sector is out of range or empty
+   */
+  void addSelfMask(double start_angle, double end_angle, double min_range);
+
+  /**
+   * Remove the farther of two neighbouring beams if the line between their
+   * points is within an angle of the farther beam, which is what veiling points
+   * look like. Typical values are around 0.1 to 0.2 rad.
+   * @param min_angle Minimum angle between the beam and the surface in radians.
+   *  0 turns the shadow filter off
+   * @throw std::invalid_argument if the angle is negative or not below pi/2
+   */
+  void setShadowAngle(double min_angle);
+
+  /**
+   * True if any filter is set, so there is something to do
+   */
+  bool isEnabled() const;
+
+  /**
+   * Build the per-beam tables for a beam selection. Must be called again
+   * whenever the reported beams change, and after changing any filter.
+   * @param selection Beams that are being reported
+   */
+  void configure(const BeamSelection& selection);
+
+  /**
+   * Number of beams the tables were built for
+   */
+  size_t getNumBeams() const
+  {
+    return min_range_table_.size();
+  }
+
+  /**
+   * Filter the ranges of a scan in place
+   * @param ranges Ranges in device units, one per reported beam
+   * @throw std::invalid_argument if the number of ranges does not match the
+   *  beam selection the tables were built for
+   */
+  void filter(vector<EIP_UINT>& ranges);
+
+private:
+  struct SelfMask
+  {
+    double start_angle;
+    double end_angle;
+    double min_range;
+  };
+
+  double min_range_;
+  double max_range_;
+  double shadow_angle_;
+  vector<SelfMask> self_masks_;
+
+  vector<EIP_UINT> min_range_table_;
+  EIP_UINT max_range_mm_;
+  vector<float> shadow_factor_;
+  vector<EIP_BYTE> shadows_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_FILTER_CHAIN_H
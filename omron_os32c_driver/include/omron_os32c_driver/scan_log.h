@@ -0,0 +1,348 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_log.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_LOG_H
+#define OMRON_OS32C_DRIVER_SCAN_LOG_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+#include "omron_os32c_driver/scan_codec.h"
+#include "omron_os32c_driver/scan_observer.h"
+#include "omron_os32c_driver/scan_view.h"
+
+using std::string;
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/*
+ * A scan log is a file header followed by chunks of scans and, once the log is
+ * closed, an index of the chunks and a footer pointing at it. Every structure
+ * is in host byte order, and the writer starts each of them, and each scan, at
+ * a multiple of 8 bytes from the start of the file, zero padding the scan data
+ * as needed. A mapped log can then be used in place.
+ *
+ * Each chunk starts with a ScanLogChunkHeader, followed by one ScanLogIndexEntry
+ * per scan and then the scans themselves. A scan is a ScanLogRecordHeader
+ * followed by its ranges and, if it has them, its reflectances. In a log with
+ * the compressed flag set, they are instead a ScanEncoder block. The first
+ * scan of each chunk is a keyframe, so chunks can still be decoded on their own.
+ *
+ * A log that was not closed, such as after a crash, has no footer. Readers then
+ * find the chunks by walking the chunk headers, which skips the scan data.
+ */
+
+struct ScanLogFileHeader
+{
+  /// "OS32CLOG", without a terminating zero
+  char magic[8];
+  EIP_UDINT version;
+  /// SCAN_LOG_COMPRESSED if the scans are ScanEncoder blocks
+  EIP_UDINT flags;
+};
+
+const EIP_UDINT SCAN_LOG_COMPRESSED = 1;
+
+struct ScanLogChunkHeader
+{
+  EIP_UDINT magic;
+  EIP_UDINT num_scans;
+  /// Size of the scans following the index entries
+  EIP_UDINT data_size;
+  EIP_UDINT reserved;
+  double first_stamp;
+  double last_stamp;
+  EIP_UDINT first_scan_count;
+  EIP_UDINT last_scan_count;
+};
+
+struct ScanLogIndexEntry
+{
+  /// Seconds on CLOCK_REALTIME when the scan was received
+  double stamp;
+  EIP_UDINT scan_count;
+  /// Offset of the scan from the end of the index entries of the chunk
+  EIP_UDINT offset;
+};
+
+struct ScanLogRecordHeader
+{
+  EIP_UINT num_beams;
+  EIP_UINT has_reflectance;
+  /// MeasurementReportHeader as serialized by the sensor
+  EIP_BYTE header[56];
+};
+
+/**
+ * Entry of the chunk index at the end of a closed log
+ */
+struct ScanLogChunkInfo
+{
+  boost::uint64_t offset;
+  double first_stamp;
+  double last_stamp;
+  EIP_UDINT first_scan_count;
+  EIP_UDINT last_scan_count;
+  EIP_UDINT num_scans;
+  EIP_UDINT reserved;
+};
+
+struct ScanLogFooter
+{
+  boost::uint64_t index_offset;
+  EIP_UDINT num_chunks;
+  EIP_UDINT magic;
+};
+
+/**
+ * Scan read from a log. The ranges and reflectances point into the mapped log
+ * and stay valid for as long as the reader is open, except in a compressed log
+ * where they point into the reader and are replaced by the next read.
+ */
+struct ScanLogEntry
+{
+  ScanLogEntry() : stamp(0), num_beams(0), ranges(NULL), reflectance(NULL)
+  {
+  }
+
+  double stamp;
+  MeasurementReportHeader header;
+  size_t num_beams;
+  const EIP_UINT* ranges;
+  /// Reflectance of each beam, or NULL if the scan has none
+  const EIP_UINT* reflectance;
+};
+
+/**
+ * Appends scans to a new scan log. Scans are collected in memory and written
+ * a chunk at a time. Writing blocks on the file, so for logging from a running
+ * driver it is better done in another process reading the shared memory ring.
+ */
+class ScanLogWriter : public ScanObserver
+{
+public:
+  /**
+   * Create a new log, replacing any file with the same name
+   * @param filename Log to write
+   * @param chunk_scans Number of scans in each chunk
+   * @param compress Store the scans as ScanEncoder blocks, which roughly
+   *  halves noisy scans and does better on static scenes
+   * @param keyframe_interval Scans from one keyframe to the next in a
+   *  compressed log, which bounds how many scans a seek has to decode
+   * @throw std::runtime_error if the file cannot be created
+   * @throw std::invalid_argument if chunk_scans or keyframe_interval is zero
+   */
+  ScanLogWriter(const string& filename, size_t chunk_scans = 256, bool compress = false,
+                size_t keyframe_interval = 25);
+
+  /**
+   * Close the log, if not closed already
+   */
+  ~ScanLogWriter();
+
+  /**
+   * Append a scan received from acquisition, stamped with the current time
+   */
+  virtual void scanReceived(const ScanView& scan);
+
+  /**
+   * Append a scan
+   * @param scan Scan to append
+   * @param stamp Seconds on CLOCK_REALTIME when it was received
+   * @throw std::runtime_error if the file cannot be written
+   */
+  void write(const ScanView& scan, double stamp);
+
+  /**
+   * Append a scan given as its parts
+   * @param header Header of the scan
+   * @param stamp Seconds on CLOCK_REALTIME when it was received
+   * @param ranges Range codes of each beam
+   * @param reflectance Reflectance of each beam, or NULL if there is none
+   * @param num_beams Number of beams in the scan
+   * @throw std::runtime_error if the file cannot be written
+   */
+  void write(const MeasurementReportHeader& header, double stamp, const EIP_UINT* ranges,
+             const EIP_UINT* reflectance, size_t num_beams);
+
+  /**
+   * Write the scans collected so far as a chunk, even if it is not full
+   * @throw std::runtime_error if the file cannot be written
+   */
+  void flush();
+
+  /**
+   * Flush, then write the chunk index and close the file
+   * @throw std::runtime_error if the file cannot be written
+   */
+  void close();
+
+private:
+  std::ofstream file_;
+  string filename_;
+  size_t chunk_scans_;
+  bool compress_;
+  ScanEncoder encoder_;
+  boost::uint64_t offset_;
+  ScanLogChunkHeader chunk_;
+  vector<ScanLogIndexEntry> entries_;
+  vector<EIP_BYTE> data_;
+  vector<ScanLogChunkInfo> chunks_;
+
+  void appendValues(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams);
+  void writeBytes(const void* data, size_t size);
+
+  ScanLogWriter(const ScanLogWriter&);
+  ScanLogWriter& operator=(const ScanLogWriter&);
+};
+
+/**
+ * Reads a scan log through a read only mapping, so that only the chunks that
+ * are read are paged in. Seeking is a binary search over the chunks and then
+ * over the index of one chunk. In a compressed log, the first read after a
+ * seek also decodes the scans back to the last keyframe.
+ */
+class ScanLogReader
+{
+public:
+  /**
+   * Open and map a log
+   * @param filename Log to read
+   * @throw std::runtime_error if the file cannot be mapped or is not a scan log
+   */
+  ScanLogReader(const string& filename);
+
+  ~ScanLogReader();
+
+  size_t getNumChunks() const
+  {
+    return chunks_.size();
+  }
+
+  size_t getNumScans() const
+  {
+    return num_scans_;
+  }
+
+  bool isCompressed() const
+  {
+    return compressed_;
+  }
+
+  /**
+   * Get the index entry of a chunk, to summarize a log without reading any scans
+   * @param chunk Chunk number, less than getNumChunks()
+   */
+  const ScanLogChunkInfo& getChunk(size_t chunk) const
+  {
+    return chunks_[chunk];
+  }
+
+  /**
+   * Move to the first scan of a chunk, so that chunks can be shared out
+   * between readers of the same log
+   * @param chunk Chunk number, less than getNumChunks()
+   */
+  void seekChunk(size_t chunk)
+  {
+    chunk_ = chunk;
+    scan_ = 0;
+  }
+
+  /**
+   * Move to the first scan received at or after a time
+   * @param stamp Seconds on CLOCK_REALTIME
+   * @return false if every scan is older, leaving the reader at the end
+   */
+  bool seekTime(double stamp);
+
+  /**
+   * Move to the first scan with a scan_count at or after the given one. The scan
+   * count restarts when the sensor is power cycled and wraps around at 2^32, so
+   * the log is searched as runs of scans over which the count does not go down.
+   * The first run, in log order, that spans the count is searched, or failing
+   * that, the reader moves to the start of the first run beginning after it.
+   * The runs are found on the first call, which reads the whole scan index.
+   * @param scan_count Scan count to find
+   * @return false if no run reaches the count, leaving the reader at the end
+   */
+  bool seekScanCount(EIP_UDINT scan_count);
+
+  /**
+   * Read the scan at the current position and move past it
+   * @param entry Scan read
+   * @return false at the end of the log
+   */
+  bool next(ScanLogEntry* entry);
+
+private:
+  /**
+   * Scans from the first to the last position over which the scan count does
+   * not go down
+   */
+  struct ScanCountRun
+  {
+    size_t first_chunk;
+    size_t first_scan;
+    size_t last_chunk;
+    size_t last_scan;
+    EIP_UDINT first_scan_count;
+    EIP_UDINT last_scan_count;
+  };
+
+  const EIP_BYTE* data_;
+  size_t size_;
+  vector<ScanLogChunkInfo> chunks_;
+  /// Runs of the scan count, empty until the first seekScanCount()
+  vector<ScanCountRun> runs_;
+  size_t num_scans_;
+  size_t chunk_;
+  size_t scan_;
+  bool compressed_;
+  ScanDecoder decoder_;
+  /// Position the decoder can continue from without going back to a keyframe
+  size_t decoded_chunk_;
+  size_t decoded_scan_;
+
+  bool readFooter();
+  void walkChunks();
+  void findScanCountRuns();
+  void seekInRun(const ScanCountRun& run, EIP_UDINT scan_count);
+  const ScanLogChunkHeader* getChunkHeader(size_t chunk) const;
+  const ScanLogIndexEntry* getIndex(size_t chunk) const;
+  const ScanLogRecordHeader* getRecord(size_t chunk, size_t scan, size_t* available) const;
+  void decodeRecord(size_t chunk, size_t scan);
+
+  ScanLogReader(const ScanLogReader&);
+  ScanLogReader& operator=(const ScanLogReader&);
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_LOG_H
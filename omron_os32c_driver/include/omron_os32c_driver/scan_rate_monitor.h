@@ -0,0 +1,99 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_rate_monitor.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_RATE_MONITOR_H
+#define OMRON_OS32C_DRIVER_SCAN_RATE_MONITOR_H
+
+#include <cmath>
+
+#include "odva_ethernetip/eip_types.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Tracks the scan rate the sensor reports in each header, so that acquisition
+ * can follow what the device is actually configured to do. The rate is taken
+ * from the first header after a reset, and a change is reported when a later
+ * header differs by more than the tolerance, such as after the response time
+ * of the sensor is reconfigured.
+ */
+class ScanRateMonitor
+{
+public:
+  /**
+   * @param tolerance Relative change in scan period that counts as a new rate
+   */
+  ScanRateMonitor(double tolerance = 0.01) : tolerance_(tolerance), scan_rate_(0)
+  {
+  }
+
+  /**
+   * Forget the rate, such as after connecting, so the next header sets it
+   */
+  void reset()
+  {
+    scan_rate_ = 0;
+  }
+
+  /**
+   * Check the scan rate of a received header
+   * @param scan_rate Scan period from the header, in microseconds
+   * @return true if this is the first rate since the last reset, or the rate
+   *  has changed
+   */
+  bool update(EIP_UDINT scan_rate)
+  {
+    if (scan_rate == 0)
+    {
+      return false;
+    }
+    if (scan_rate_ && fabs(static_cast<double>(scan_rate) - scan_rate_) <= tolerance_ * scan_rate_)
+    {
+      return false;
+    }
+    scan_rate_ = scan_rate;
+    return true;
+  }
+
+  bool hasRate() const
+  {
+    return scan_rate_ != 0;
+  }
+
+  /**
+   * Scan frequency of the sensor in Hz, or 0 if not known yet
+   */
+  double getFrequency() const
+  {
+    return scan_rate_ ? 1000000.0 / scan_rate_ : 0;
+  }
+
+private:
+  double tolerance_;
+  EIP_UDINT scan_rate_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_RATE_MONITOR_H
@@ -0,0 +1,186 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_view.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_VIEW_H
+#define OMRON_OS32C_DRIVER_SCAN_VIEW_H
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Read only view of one decoded scan, in sensor units. It refers to the buffers
+ * of the measurement it was made from, so it is only valid for as long as that
+ * measurement is unchanged, which for scans handed to a ScanObserver is the
+ * duration of the callback.
+ */
+class ScanView
+{
+public:
+  /**
+   * View a Range and Reflectance Measurement
+   * @param rr Measurement to view, whose reflectance is empty if it was not measured
+   * @param selection Beams the measurement was taken with, or NULL if not known
+   * @param selection_changed True if the selection differs from the previous scan
+   * @throw std::invalid_argument if the number of beams does not match the data
+   */
+  ScanView(const RangeAndReflectanceMeasurement& rr, const BeamSelection* selection = NULL,
+           bool selection_changed = false)
+    : header_(rr.header)
+    , ranges_(rr.range_data.empty() ? NULL : &rr.range_data[0])
+    , reflectance_(rr.reflectance_data.empty() ? NULL : &rr.reflectance_data[0])
+    , num_beams_(rr.header.num_beams)
+    , selection_(selection)
+    , selection_changed_(selection_changed)
+  {
+    if (rr.range_data.size() != num_beams_ ||
+        (!rr.reflectance_data.empty() && rr.reflectance_data.size() != num_beams_))
+    {
+      throw std::invalid_argument("Number of beams does not match vector size");
+    }
+  }
+
+  /**
+   * View a Measurement Report, which carries the ranges and, if they fit in
+   * the packet, the reflectance
+   * @param mr Measurement to view
+   * @param selection Beams the measurement was taken with, or NULL if not known
+   * @param selection_changed True if the selection differs from the previous scan
+   * @throw std::invalid_argument if the number of beams does not match the data,
+   *  such as for a report with only the reflectance
+   */
+  ScanView(const MeasurementReport& mr, const BeamSelection* selection = NULL, bool selection_changed = false)
+    : header_(mr.header)
+    , ranges_(mr.measurement_data.empty() ? NULL : &mr.measurement_data[0])
+    , reflectance_(mr.reflectance_data.empty() ? NULL : &mr.reflectance_data[0])
+    , num_beams_(mr.header.num_beams)
+    , selection_(selection)
+    , selection_changed_(selection_changed)
+  {
+    if (mr.measurement_data.size() != num_beams_ ||
+        (!mr.reflectance_data.empty() && mr.reflectance_data.size() != num_beams_))
+    {
+      throw std::invalid_argument("Number of beams does not match vector size");
+    }
+  }
+
+  /**
+   * View a scan given as its parts, such as one read back from a log
+   * @param header Header of the scan, whose num_beams is not used
+   * @param ranges Range codes of each beam
+   * @param reflectance Reflectance of each beam, or NULL if there is none
+   * @param num_beams Number of beams in the scan
+   * @param selection Beams the scan was taken with, or NULL if not known
+   * @param selection_changed True if the selection differs from the previous scan
+   */
+  ScanView(const MeasurementReportHeader& header, const EIP_UINT* ranges, const EIP_UINT* reflectance,
+           size_t num_beams, const BeamSelection* selection = NULL, bool selection_changed = false)
+    : header_(header)
+    , ranges_(ranges)
+    , reflectance_(reflectance)
+    , num_beams_(num_beams)
+    , selection_(selection)
+    , selection_changed_(selection_changed)
+  {
+  }
+
+  const MeasurementReportHeader& getHeader() const
+  {
+    return header_;
+  }
+
+  size_t getNumBeams() const
+  {
+    return num_beams_;
+  }
+
+  /**
+   * Range codes of each beam in mm, with 0x0001 for a noisy beam and 0xFFFF
+   * for no return
+   */
+  const EIP_UINT* getRanges() const
+  {
+    return ranges_;
+  }
+
+  /**
+   * Reflectance of each beam, or NULL if the scan has none
+   */
+  const EIP_UINT* getReflectance() const
+  {
+    return reflectance_;
+  }
+
+  /**
+   * Beams the scan was taken with, or NULL if not known
+   */
+  const BeamSelection* getSelection() const
+  {
+    return selection_;
+  }
+
+  /**
+   * True for the first scan taken with a new beam selection, including the first
+   * scan after connecting, so that anything derived from it can be recalculated
+   */
+  bool isSelectionChanged() const
+  {
+    return selection_changed_;
+  }
+
+  /**
+   * Time between beams in seconds. The header gives it in ns.
+   */
+  double getBeamPeriod() const
+  {
+    return header_.scan_beam_period / 1000000000.0;
+  }
+
+  /**
+   * Time between scans in seconds. The header gives it in microseconds.
+   */
+  double getScanPeriod() const
+  {
+    return header_.scan_rate / 1000000.0;
+  }
+
+private:
+  const MeasurementReportHeader& header_;
+  const EIP_UINT* ranges_;
+  const EIP_UINT* reflectance_;
+  size_t num_beams_;
+  const BeamSelection* selection_;
+  bool selection_changed_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_VIEW_H
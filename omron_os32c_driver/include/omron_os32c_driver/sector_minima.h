@@ -0,0 +1,182 @@
+/**
+Software License Agreement (BSD)
+
+\file      sector_minima.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SECTOR_MINIMA_H
+#define OMRON_OS32C_DRIVER_SECTOR_MINIMA_H
+
+#include <cstddef>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/beam_selection.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Nearest return in each of a few angular sectors, for consumers such as a
+ * speed governor that need far less than the whole scan. Sectors are mapped to
+ * a span of report indices once per beam selection, so reducing a scan is a
+ * minimum over contiguous raw ranges that the compiler can vectorize, followed
+ * by a search for the first beam at that minimum. Noisy beams (0x0001) are not
+ * counted as returns.
+ */
+class SectorMinima
+{
+public:
+  /// Range of a sector without any return
+  static const EIP_UINT NO_RETURN = 0xFFFF;
+
+  SectorMinima() : num_slots_(0)
+  {
+  }
+
+  /**
+   * Add a sector. Angles are in ROS conventions, with zero straight ahead and
+   * positive numbers CCW, in radians. Sectors may overlap.
+   * @param start_angle Most CCW angle of the sector
+   * @param end_angle Most CW angle of the sector
+   * @throw std::invalid_argument if the sector is out of range or empty
+   */
+  void addSector(double start_angle, double end_angle);
+
+  size_t getNumSectors() const
+  {
+    return sectors_.size();
+  }
+
+  double getStartAngle(size_t sector) const
+  {
+    return sectors_[sector].start_angle;
+  }
+
+  double getEndAngle(size_t sector) const
+  {
+    return sectors_[sector].end_angle;
+  }
+
+  /**
+   * Map the sectors onto the beams of a selection, for the scans that follow.
+   * Must be called before the first scan and whenever the selection changes.
+   * @param selection Beams the scans are measured with
+   */
+  void configure(const BeamSelection& selection);
+
+  /**
+   * Find the nearest return of each sector in a scan
+   * @param ranges Ranges in device units, one per selected beam in report order
+   * @param num_beams Number of ranges. Beams beyond what the selection had are ignored.
+   */
+  void reduce(const EIP_UINT* ranges, size_t num_beams);
+
+  /**
+   * Get the smallest range in a sector of the last scan reduced
+   * @return Range in device units, or NO_RETURN if no beam of the sector had a return
+   */
+  EIP_UINT getRange(size_t sector) const
+  {
+    return sectors_[sector].range;
+  }
+
+  /**
+   * Get the beam with the smallest range in a sector of the last scan reduced
+   * @return OS32C beam number, or -1 if no beam of the sector had a return
+   */
+  int getBeam(size_t sector) const
+  {
+    return sectors_[sector].beam;
+  }
+
+  /**
+   * Get the slot in the beam selection of the beam with the smallest range in a
+   * sector of the last scan reduced, which is its index in a LaserScan expanded
+   * to the selection
+   * @return Slot, or -1 if no beam of the sector had a return
+   */
+  int getSlot(size_t sector) const
+  {
+    return sectors_[sector].index < 0 ? -1 : slots_[sectors_[sector].index];
+  }
+
+  /**
+   * Get the slot of the first beam of a sector that is measured
+   * @param sector Sector with isMeasured() true
+   */
+  int getFirstSlot(size_t sector) const
+  {
+    return slots_[sectors_[sector].begin];
+  }
+
+  /**
+   * Get the slot of the last beam of a sector that is measured
+   * @param sector Sector with isMeasured() true
+   */
+  int getLastSlot(size_t sector) const
+  {
+    return slots_[sectors_[sector].end - 1];
+  }
+
+  /**
+   * Number of slots in the configured selection, as in BeamSelection::getNumSlots()
+   */
+  int getNumSlots() const
+  {
+    return num_slots_;
+  }
+
+  /**
+   * Check whether any beam of a sector is measured with the configured selection
+   */
+  bool isMeasured(size_t sector) const
+  {
+    return sectors_[sector].end > sectors_[sector].begin;
+  }
+
+private:
+  struct Sector
+  {
+    double start_angle;
+    double end_angle;
+    // beam numbers covered, inclusive
+    int first_beam;
+    int last_beam;
+    // report indices covered, end exclusive
+    size_t begin;
+    size_t end;
+    EIP_UINT range;
+    int beam;
+    // report index of the beam, or -1
+    int index;
+  };
+
+  vector<Sector> sectors_;
+  vector<int> beams_;
+  vector<int> slots_;
+  int num_slots_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SECTOR_MINIMA_H
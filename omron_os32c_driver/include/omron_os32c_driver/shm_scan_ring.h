@@ -0,0 +1,180 @@
+/**
+Software License Agreement (BSD)
+
+\file      shm_scan_ring.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SHM_SCAN_RING_H
+#define OMRON_OS32C_DRIVER_SHM_SCAN_RING_H
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+#include "omron_os32c_driver/scan_observer.h"
+#include "omron_os32c_driver/scan_view.h"
+
+using std::string;
+using std::vector;
+
+namespace omron_os32c_driver {
+
+struct ShmRingHeader;
+struct ShmSlot;
+
+/**
+ * Scan as read back from a shared memory ring
+ */
+struct ShmScan
+{
+  ShmScan() : index(0), stamp(0), monotonic_stamp(0)
+  {
+  }
+
+  /// Header as reported by the sensor, including the scan_count
+  MeasurementReportHeader header;
+  /// Position of the scan in the ring, counting every scan written
+  boost::uint64_t index;
+  /// Seconds on CLOCK_REALTIME when the scan was written
+  double stamp;
+  /// Seconds on CLOCK_MONOTONIC when the scan was written, to measure latency
+  double monotonic_stamp;
+  /// Range codes in device units
+  vector<EIP_UINT> ranges;
+  /// Reflectance of each beam, or empty if the scan had none
+  vector<EIP_UINT> reflectance;
+};
+
+/**
+ * Writes every scan into a ring of slots in POSIX shared memory, so that other
+ * processes on the host can read them without serialization or a ROS master.
+ * Each slot is protected by a sequence lock: the writer never waits, and a
+ * reader that races with the writer retries the copy of that slot.
+ *
+ * The shared memory object is created when the writer is constructed, replacing
+ * any left by a previous run, and removed when it is destroyed.
+ */
+class ShmScanWriter : public ScanObserver
+{
+public:
+  /**
+   * @param name Name of the shared memory object, such as "/os32c_scans"
+   * @param num_slots Number of scans kept in the ring
+   * @throw std::invalid_argument if the name or number of slots is not usable
+   * @throw std::runtime_error if the shared memory cannot be created
+   */
+  ShmScanWriter(const string& name, int num_slots = 16);
+
+  ~ShmScanWriter();
+
+  /**
+   * Write a scan received from acquisition, stamped with the current time
+   */
+  virtual void scanReceived(const ScanView& scan);
+
+  /**
+   * Write a scan into the next slot of the ring
+   * @param scan Scan to copy
+   * @param stamp Seconds on CLOCK_REALTIME to give the scan
+   * @param monotonic_stamp Seconds on CLOCK_MONOTONIC to give the scan
+   */
+  void write(const ScanView& scan, double stamp, double monotonic_stamp);
+
+private:
+  string name_;
+  size_t size_;
+  ShmRingHeader* ring_;
+  ShmSlot* slots_;
+  boost::uint64_t write_count_;
+
+  // not copyable, as it owns the mapping
+  ShmScanWriter(const ShmScanWriter&);
+  ShmScanWriter& operator=(const ShmScanWriter&);
+};
+
+/**
+ * Reads scans from a ring created by ShmScanWriter. Any number of readers, in
+ * any number of processes, can read the same ring, each at its own pace.
+ */
+class ShmScanReader
+{
+public:
+  /**
+   * Open the ring read only. Reading starts from the oldest scan in the ring.
+   * @param name Name the writer was given
+   * @throw std::runtime_error if the ring does not exist or has a different layout
+   */
+  ShmScanReader(const string& name);
+
+  ~ShmScanReader();
+
+  /**
+   * Read the next scan in order. If the writer has gone round the ring since the
+   * last read, the scans that were overwritten are skipped and counted as dropped.
+   * @param scan Scan to fill. Its vectors are reused between reads.
+   * @return true if a scan was read, false if there is no new scan
+   */
+  bool readNext(ShmScan* scan);
+
+  /**
+   * Read the newest scan, skipping any older ones that have not been read. Skipped
+   * scans do not count as dropped.
+   * @param scan Scan to fill. Its vectors are reused between reads.
+   * @return true if a scan was read, false if there is no new scan
+   */
+  bool readLatest(ShmScan* scan);
+
+  /**
+   * Number of scans overwritten before readNext() got to them
+   */
+  boost::uint64_t getDropped() const
+  {
+    return dropped_;
+  }
+
+  /**
+   * True once the writer has shut down. A new writer creates a new ring, which
+   * needs a new reader.
+   */
+  bool isClosed() const;
+
+private:
+  size_t size_;
+  const ShmRingHeader* ring_;
+  const ShmSlot* slots_;
+  boost::uint64_t next_;
+  boost::uint64_t dropped_;
+
+  /**
+   * Copy the scan with the given index out of its slot
+   * @return false if the slot has already been reused for a newer scan
+   */
+  bool readSlot(boost::uint64_t index, ShmScan* scan);
+
+  ShmScanReader(const ShmScanReader&);
+  ShmScanReader& operator=(const ShmScanReader&);
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SHM_SCAN_RING_H
@@ -0,0 +1,163 @@
+/**
+Software License Agreement (BSD)
+
+\file      stall_detector.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_STALL_DETECTOR_H
+#define OMRON_OS32C_DRIVER_STALL_DETECTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace omron_os32c_driver {
+
+/**
+ * Watchdog for scans that stop arriving. Rather than a fixed timeout, the
+ * deadline follows the scan period the sensor reports and the measured time
+ * between received scans: a number of missed periods, or the mean interval plus
+ * a margin for the observed jitter if that is longer, kept between a floor and a
+ * ceiling. Until enough scans have been received to know the interval, the
+ * ceiling is used.
+ */
+class StallDetector
+{
+public:
+  /**
+   * @param missed_periods Number of scan periods without a scan that is a stall
+   * @param min_deadline Shortest deadline, in seconds
+   * @param max_deadline Longest deadline, used until intervals are known, in seconds
+   */
+  StallDetector(double missed_periods, double min_deadline, double max_deadline)
+    : missed_periods_(missed_periods), min_deadline_(min_deadline), max_deadline_(max_deadline)
+  {
+    if (missed_periods <= 1 || min_deadline <= 0 || max_deadline < min_deadline)
+    {
+      throw std::invalid_argument("Stall detection needs more than one missed period and 0 < min <= max deadline");
+    }
+    reset(0);
+  }
+
+  /**
+   * Start over, such as after connecting, without any interval statistics
+   * @param now Current time, in seconds
+   */
+  void reset(double now)
+  {
+    last_scan_ = now;
+    scans_ = 0;
+    scan_period_ = 0;
+    mean_interval_ = 0;
+    interval_variance_ = 0;
+    deadline_ = max_deadline_;
+  }
+
+  /**
+   * Record a received scan
+   * @param now Time the scan was received, in seconds
+   * @param scan_period Scan period reported by the sensor, in seconds
+   */
+  void scanReceived(double now, double scan_period)
+  {
+    // weight of the newest interval in the running mean and variance
+    const double interval_weight = 0.05;
+    // number of standard deviations of jitter to allow for
+    const double jitter_sigmas = 6;
+
+    double interval = now - last_scan_;
+    last_scan_ = now;
+    scan_period_ = scan_period;
+    if (scans_++ == 0)
+    {
+      // the interval from connecting to the first scan says nothing about the rate
+      return;
+    }
+    if (scans_ == 2)
+    {
+      mean_interval_ = interval;
+    }
+    else
+    {
+      double diff = interval - mean_interval_;
+      mean_interval_ += interval_weight * diff;
+      interval_variance_ = (1 - interval_weight) * (interval_variance_ + interval_weight * diff * diff);
+    }
+
+    double period = std::max(scan_period_, mean_interval_);
+    double deadline = std::max(missed_periods_ * period, mean_interval_ + jitter_sigmas * sqrt(interval_variance_));
+    deadline_ = std::min(std::max(deadline, min_deadline_), max_deadline_);
+  }
+
+  /**
+   * Time without a scan after which the sensor is taken to have stalled, in seconds
+   */
+  double getDeadline() const
+  {
+    return deadline_;
+  }
+
+  double getMeanInterval() const
+  {
+    return mean_interval_;
+  }
+
+  double getLastScanTime() const
+  {
+    return last_scan_;
+  }
+
+  /**
+   * Time left until the sensor is taken to have stalled, which bounds how long
+   * a request for the next scan may wait
+   * @param now Current time, in seconds
+   * @return Seconds until the deadline, or zero if it has passed
+   */
+  double getTimeRemaining(double now) const
+  {
+    return std::max(last_scan_ + deadline_ - now, 0.0);
+  }
+
+  /**
+   * @param now Current time, in seconds
+   * @return true if no scan has been received within the deadline
+   */
+  bool isStalled(double now) const
+  {
+    return now - last_scan_ > deadline_;
+  }
+
+private:
+  double missed_periods_;
+  double min_deadline_;
+  double max_deadline_;
+
+  double last_scan_;
+  int scans_;
+  double scan_period_;
+  double mean_interval_;
+  double interval_variance_;
+  double deadline_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_STALL_DETECTOR_H
@@ -0,0 +1,82 @@
+/**
+Software License Agreement (BSD)
+
+\file      temporal_median_filter.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_TEMPORAL_MEDIAN_FILTER_H
+#define OMRON_OS32C_DRIVER_TEMPORAL_MEDIAN_FILTER_H
+
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Per-beam median over the last few scans, applied to the raw ranges as
+ * reported by the device. Noisy beams (0x0001) sort below every range and
+ * missing returns (0xFFFF) above, so isolated ones are replaced by the range
+ * the beam had in neighbouring scans, as are single scan spikes.
+ *
+ * The history is kept as one row of ranges per scan, so each step of the
+ * sorting network is a min or max across two contiguous rows that the
+ * compiler can vectorize over all of the beams.
+ */
+class TemporalMedianFilter
+{
+public:
+  /**
+   * @param window Number of scans to take the median over. Must be 3 or 5
+   * @throw std::invalid_argument if the window is not supported
+   */
+  TemporalMedianFilter(int window);
+
+  int getWindow() const
+  {
+    return window_;
+  }
+
+  /**
+   * Forget the history, such as after a reconnect. The next scan passes through
+   * unchanged and starts a new history.
+   */
+  void reset();
+
+  /**
+   * Add a scan to the history and replace its ranges with the median of the
+   * window. The history restarts if the number of beams changes.
+   * @param ranges Ranges in device units, filtered in place
+   */
+  void filter(vector<EIP_UINT>& ranges);
+
+private:
+  int window_;
+  size_t num_beams_;
+  int newest_;
+  vector<EIP_UINT> history_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_TEMPORAL_MEDIAN_FILTER_H
@@ -0,0 +1,130 @@
+/**
+Software License Agreement (BSD)
+
+\file      timeout_tcp_socket.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef OMRON_OS32C_DRIVER_TIMEOUT_TCP_SOCKET_H
+#define OMRON_OS32C_DRIVER_TIMEOUT_TCP_SOCKET_H
+
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+
+#include "odva_ethernetip/socket/socket.h"
+
+using std::string;
+
+namespace omron_os32c_driver {
+
+/**
+ * TCP socket for the explicit messaging session that gives up on a sensor that
+ * stops answering. Connecting, sending and receiving each wait at most for
+ * their timeout and then throw, so a request to a silent sensor fails instead
+ * of blocking the caller forever.
+ *
+ * A blocked call can also be woken from another thread with abort(), which
+ * shuts the connection down. The socket then has to be closed and opened again.
+ */
+class TimeoutTCPSocket : public eip::socket::Socket
+{
+public:
+  /**
+   * @param connect_timeout Seconds to wait for the connection to be set up
+   * @param request_timeout Seconds to wait for each send or receive, or zero to wait forever
+   * @throw std::invalid_argument if a timeout is negative or the connect timeout is zero
+   */
+  TimeoutTCPSocket(double connect_timeout, double request_timeout);
+
+  virtual ~TimeoutTCPSocket();
+
+  /**
+   * Connect to the given host and port, closing any previous connection first
+   * @throw std::runtime_error if the host cannot be resolved, or the connection
+   *  fails or is not made within the connect timeout
+   */
+  virtual void open(string hostname, string port);
+
+  virtual void close();
+
+  /**
+   * Send the whole buffer
+   * @throw std::runtime_error if not connected, or on error or timeout
+   */
+  virtual size_t send(const boost::asio::const_buffer& buf);
+
+  /**
+   * Receive whatever data is available, up to the size of the buffer, waiting
+   * for some to arrive
+   * @throw std::runtime_error if not connected, if the connection is closed,
+   *  or on error or timeout
+   */
+  virtual size_t receive(const boost::asio::mutable_buffer& buf);
+
+  /**
+   * Shut the connection down, so that a send or receive blocked in another
+   * thread returns with an error. Safe to call from any thread while another
+   * uses the socket, but not once it has been destroyed.
+   */
+  void abort();
+
+  double getConnectTimeout() const
+  {
+    return connect_timeout_;
+  }
+
+  double getRequestTimeout() const
+  {
+    return request_timeout_;
+  }
+
+  /**
+   * Set the time to wait for each following send or receive. Used to keep a
+   * request within a deadline, such as that of the stall detector.
+   * @param timeout Seconds, or zero to wait forever
+   * @throw std::invalid_argument if the timeout is negative
+   */
+  void setRequestTimeout(double timeout);
+
+  bool isOpen() const
+  {
+    return fd_ >= 0;
+  }
+
+private:
+  /**
+   * Wait until the socket is ready for the given poll events
+   * @param events POLLIN or POLLOUT
+   * @param timeout Seconds to wait, or zero to wait forever
+   * @param what Operation waited for, for the error message
+   */
+  void wait(short events, double timeout, const string& what);
+
+  /// Descriptor of the connection, or -1. Atomic so that abort() can read it from another thread.
+  boost::atomic<int> fd_;
+  double connect_timeout_;
+  double request_timeout_;
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_TIMEOUT_TCP_SOCKET_H
@@ -0,0 +1,121 @@
+/**
+Software License Agreement (BSD)
+
+\file      work_stealing_pool.h
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_WORK_STEALING_POOL_H
+#define OMRON_OS32C_DRIVER_WORK_STEALING_POOL_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Work to be shared out by a WorkStealingPool, as a number of tasks that can
+ * run in any order and at the same time as each other
+ */
+class ParallelTask
+{
+public:
+  virtual ~ParallelTask()
+  {
+  }
+
+  /**
+   * Run one task
+   * @param task Number of the task, from zero
+   * @param worker Number of the worker running it, from zero, for selecting
+   *  per worker state such as a file reader
+   */
+  virtual void run(size_t task, size_t worker) = 0;
+};
+
+/**
+ * Runs the tasks of a ParallelTask on a fixed number of threads. Each worker
+ * starts with an equal, contiguous share of the tasks and runs them in order.
+ * A worker that runs out takes the second half of what is left to the worker
+ * with the most remaining, so uneven tasks still keep every core busy while
+ * each worker mostly runs neighbouring tasks.
+ */
+class WorkStealingPool
+{
+public:
+  /**
+   * @param num_workers Number of threads to run tasks on, including the one
+   *  calling run(), or 0 for one per online CPU
+   */
+  WorkStealingPool(size_t num_workers = 0);
+
+  size_t getNumWorkers() const
+  {
+    return num_workers_;
+  }
+
+  /**
+   * Run every task once and wait for them to finish
+   * @param num_tasks Number of tasks
+   * @param task Work to run
+   * @throw std::runtime_error with the message of the first task that threw,
+   *  after the tasks already running have finished. Tasks not yet started
+   *  are skipped.
+   */
+  void run(size_t num_tasks, ParallelTask* task);
+
+private:
+  /// Tasks [begin, end) still to be run by one worker
+  struct Range
+  {
+    pthread_mutex_t mutex;
+    size_t begin;
+    size_t end;
+  };
+
+  struct Worker
+  {
+    WorkStealingPool* pool;
+    size_t index;
+  };
+
+  size_t num_workers_;
+  ParallelTask* task_;
+  vector<Range> ranges_;
+  pthread_mutex_t error_mutex_;
+  bool failed_;
+  string error_;
+
+  static void* runWorker(void* arg);
+  void work(size_t worker);
+  bool take(size_t worker, size_t* task);
+  bool steal(size_t worker);
+
+  WorkStealingPool(const WorkStealingPool&);
+  WorkStealingPool& operator=(const WorkStealingPool&);
+};
+
+}  // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_WORK_STEALING_POOL_H
@@ -0,0 +1,168 @@
+/**
+Software License Agreement (BSD)
+
+\file      async_os32c.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <algorithm>
+#include <utility>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include "omron_os32c_driver/async_os32c.h"
+
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+using boost::system::error_code;
+using boost::system::system_error;
+
+namespace omron_os32c_driver {
+
+/**
+ * Shared between a call waiting on the executor and the function running on
+ * the pool. The timer doubles as the signal that the function is done.
+ */
+struct AsyncOS32C::CallState
+{
+  explicit CallState(const boost::asio::any_io_executor& executor) : timer(executor), done(false), cancelled(false)
+  {
+  }
+
+  boost::asio::steady_timer timer;
+  std::exception_ptr error;
+  bool done;
+  bool cancelled;
+};
+
+AsyncOS32C::AsyncOS32C(const boost::asio::any_io_executor& executor, boost::asio::thread_pool& pool,
+                       boost::shared_ptr<OS32C> os32c, Duration timeout, boost::shared_ptr<TimeoutTCPSocket> socket)
+  : executor_(executor)
+  , strand_(boost::asio::make_strand(pool.get_executor()))
+  , os32c_(os32c)
+  , timeout_(timeout)
+  , socket_(socket)
+  , report_timer_(executor)
+  , scan_period_(Duration::zero())
+{
+}
+
+awaitable<void> AsyncOS32C::open(std::string host)
+{
+  co_await run([host](OS32C& os32c) { os32c.open(host); });
+}
+
+awaitable<void> AsyncOS32C::selectBeams(BeamSelection selection)
+{
+  co_await run([selection](OS32C& os32c) { os32c.selectBeams(selection); });
+}
+
+awaitable<RangeAndReflectanceMeasurement> AsyncOS32C::getSingleRRScan()
+{
+  co_return co_await call<RangeAndReflectanceMeasurement>([](OS32C& os32c) { return os32c.getSingleRRScan(); });
+}
+
+awaitable<RangeAndReflectanceMeasurement> AsyncOS32C::nextReport()
+{
+  if (scan_period_ > Duration::zero())
+  {
+    report_timer_.expires_at(last_report_ + scan_period_);
+    co_await report_timer_.async_wait(use_awaitable);
+  }
+  last_report_ = std::chrono::steady_clock::now();
+
+  RangeAndReflectanceMeasurement rr = co_await call<RangeAndReflectanceMeasurement>([](OS32C& os32c) {
+    RangeAndReflectanceMeasurement rr = os32c.getSingleRRScan();
+    os32c.updateReportSelection(rr.header.num_beams);
+    return rr;
+  });
+  scan_period_ = std::chrono::microseconds(rr.header.scan_rate);
+  co_return rr;
+}
+
+void AsyncOS32C::cancel()
+{
+  report_timer_.cancel();
+  for (size_t i = 0; i < calls_.size(); ++i)
+  {
+    std::shared_ptr<CallState> state = calls_[i].lock();
+    if (state)
+    {
+      state->cancelled = true;
+      state->timer.cancel();
+    }
+  }
+  calls_.clear();
+}
+
+awaitable<void> AsyncOS32C::run(std::function<void(OS32C&)> fn)
+{
+  std::shared_ptr<CallState> state = std::make_shared<CallState>(executor_);
+  calls_.erase(std::remove_if(calls_.begin(), calls_.end(),
+                              [](const std::weak_ptr<CallState>& call) { return call.expired(); }),
+               calls_.end());
+  calls_.push_back(state);
+  if (timeout_ > Duration::zero())
+  {
+    state->timer.expires_after(timeout_);
+  }
+  else
+  {
+    state->timer.expires_at(std::chrono::steady_clock::time_point::max());
+  }
+
+  // Run the function on the strand of this sensor, then wake the waiting call
+  // back up on its own executor
+  boost::shared_ptr<OS32C> os32c = os32c_;
+  boost::asio::post(strand_, [state, os32c, fn]() {
+    try
+    {
+      fn(*os32c);
+    }
+    catch (...)
+    {
+      state->error = std::current_exception();
+    }
+    boost::asio::post(state->timer.get_executor(), [state]() {
+      state->done = true;
+      state->timer.cancel();
+    });
+  });
+
+  error_code ec;
+  co_await state->timer.async_wait(boost::asio::redirect_error(use_awaitable, ec));
+  if (!state->done)
+  {
+    // Wake the request up if it is stuck on the socket, rather than leaving it
+    // to hold up the strand of this sensor for as long as the sensor is silent
+    if (socket_)
+    {
+      socket_->abort();
+    }
+    throw system_error(state->cancelled ? boost::asio::error::operation_aborted : boost::asio::error::timed_out);
+  }
+  if (state->error)
+  {
+    std::rethrow_exception(state->error);
+  }
+}
+
+}  // namespace omron_os32c_driver
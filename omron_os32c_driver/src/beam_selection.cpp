@@ -0,0 +1,157 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_selection.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <cstring>
+#include <stdexcept>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/os32c.h"
+
+namespace omron_os32c_driver {
+
+const int BeamSelection::NUM_BEAMS;
+const size_t BeamSelection::MASK_SIZE;
+
+BeamSelection::BeamSelection() : decimation_(1), sectors_(NUM_BEAMS, false), excluded_(NUM_BEAMS, false)
+{
+}
+
+void BeamSelection::validateSector(double start_angle, double end_angle)
+{
+  if (start_angle > (OS32C::ANGLE_MAX + OS32C::ANGLE_INC / 2))
+  {
+    throw std::invalid_argument("Start angle is greater than max");
+  }
+  if (end_angle < (OS32C::ANGLE_MIN - OS32C::ANGLE_INC / 2))
+  {
+    throw std::invalid_argument("End angle is greater than max");
+  }
+  if (start_angle - end_angle <= OS32C::ANGLE_INC)
+  {
+    throw std::invalid_argument("Starting angle is less than ending angle");
+  }
+}
+
+void BeamSelection::addSector(double start_angle, double end_angle)
+{
+  validateSector(start_angle, end_angle);
+  int start_beam = OS32C::calcBeamNumber(start_angle);
+  int end_beam = OS32C::calcBeamNumber(end_angle);
+  for (int i = start_beam; i <= end_beam; ++i)
+  {
+    sectors_[i] = true;
+  }
+  update();
+}
+
+void BeamSelection::excludeSector(double start_angle, double end_angle)
+{
+  validateSector(start_angle, end_angle);
+  int start_beam = OS32C::calcBeamNumber(start_angle);
+  int end_beam = OS32C::calcBeamNumber(end_angle);
+  for (int i = start_beam; i <= end_beam; ++i)
+  {
+    excluded_[i] = true;
+  }
+  update();
+}
+
+void BeamSelection::excludeBeam(int beam_num)
+{
+  if (beam_num < 0 || beam_num >= NUM_BEAMS)
+  {
+    throw std::invalid_argument("Beam number out of range");
+  }
+  excluded_[beam_num] = true;
+  update();
+}
+
+void BeamSelection::setDecimation(int decimation)
+{
+  if (decimation < 1)
+  {
+    throw std::invalid_argument("Decimation must be at least 1");
+  }
+  decimation_ = decimation;
+  update();
+}
+
+void BeamSelection::update()
+{
+  beams_.clear();
+  int first_beam = -1;
+  for (int i = 0; i < NUM_BEAMS; ++i)
+  {
+    if (!sectors_[i] || excluded_[i])
+    {
+      continue;
+    }
+    if (first_beam < 0)
+    {
+      first_beam = i;
+    }
+    if ((i - first_beam) % decimation_ == 0)
+    {
+      beams_.push_back(i);
+    }
+  }
+}
+
+void BeamSelection::getMask(EIP_BYTE mask[]) const
+{
+  memset(mask, 0, MASK_SIZE);
+  for (size_t i = 0; i < beams_.size(); ++i)
+  {
+    mask[beams_[i] / 8] |= 1 << (beams_[i] % 8);
+  }
+}
+
+void BeamSelection::expand(vector<float>& values, float fill) const
+{
+  if (values.size() != beams_.size())
+  {
+    throw std::invalid_argument("Number of values does not match number of beams");
+  }
+  if (isContiguous())
+  {
+    return;
+  }
+
+  // Work backwards so that every value is moved before its position is overwritten.
+  // Slots are never before the index of their beam, so this works in place.
+  int slot = getNumSlots() - 1;
+  values.resize(slot + 1);
+  for (int i = beams_.size() - 1; i >= 0; --i)
+  {
+    int beam_slot = getSlot(i);
+    for (; slot > beam_slot; --slot)
+    {
+      values[slot] = fill;
+    }
+    values[slot--] = values[i];
+  }
+}
+
+}  // namespace omron_os32c_driver
@@ -0,0 +1,289 @@
+/**
+Software License Agreement (BSD)
+
+\file      flight_recorder.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "omron_os32c_driver/flight_recorder.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+
+using eip::serialization::BufferWriter;
+
+namespace omron_os32c_driver {
+
+const EIP_UDINT FLIGHT_RECORDER_VERSION = 1;
+
+FlightRecorder::FlightRecorder(size_t num_scans, size_t post_trigger_scans, const string& directory,
+                               size_t max_files)
+  : post_trigger_scans_(post_trigger_scans)
+  , directory_(directory)
+  , max_files_(max_files)
+  , next_(0)
+  , num_recorded_(0)
+  , has_previous_(false)
+  , previous_stop_reasons_(0)
+  , previous_zone_status_(0)
+  , dump_pending_(false)
+  , scans_until_dump_(0)
+  , writing_(false)
+  , stopping_(false)
+{
+  if (num_scans == 0 || post_trigger_scans >= num_scans)
+  {
+    throw std::invalid_argument("Flight recorder must keep more scans than it records after a trigger");
+  }
+  // zero fill now, so that neither recording nor dumping ever page faults
+  records_.resize(num_scans);
+  memset(&records_[0], 0, records_.size() * sizeof(FlightRecord));
+  snapshot_.resize(num_scans);
+  memset(&snapshot_[0], 0, snapshot_.size() * sizeof(FlightRecord));
+  memset(&snapshot_header_, 0, sizeof(snapshot_header_));
+
+  // started before any realtime settings are applied to the acquisition
+  // thread, so that the writer keeps the default scheduling
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+  if (pthread_create(&writer_, NULL, runWriter, this) != 0)
+  {
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mutex_);
+    throw std::runtime_error("Cannot start flight recorder writer thread");
+  }
+}
+
+FlightRecorder::~FlightRecorder()
+{
+  pthread_mutex_lock(&mutex_);
+  stopping_ = true;
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&mutex_);
+  pthread_join(writer_, NULL);
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void FlightRecorder::scanReceived(const ScanView& scan)
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  record(scan, now.tv_sec + now.tv_nsec / 1000000000.0);
+  if (dump_pending_ && scans_until_dump_ == 0)
+  {
+    dump_pending_ = false;
+    try
+    {
+      string filename = dump(num_recorded_ - 1 - post_trigger_scans_);
+      CONSOLE_BRIDGE_logWarn("Scans around a change of machine stop reasons or detection zones being written to %s",
+                             filename.c_str());
+    }
+    catch (std::runtime_error& ex)
+    {
+      CONSOLE_BRIDGE_logError("Unable to write flight recorder: %s", ex.what());
+    }
+  }
+}
+
+void FlightRecorder::record(const ScanView& scan, double stamp)
+{
+  FlightRecord& record = records_[next_];
+  size_t num_beams = std::min(scan.getNumBeams(), static_cast<size_t>(BeamSelection::NUM_BEAMS));
+  record.stamp = stamp;
+  record.num_beams = num_beams;
+  record.has_reflectance = scan.getReflectance() != NULL;
+  BufferWriter writer(boost::asio::buffer(record.header));
+  scan.getHeader().serialize(writer);
+  std::copy(scan.getRanges(), scan.getRanges() + num_beams, record.ranges);
+  if (record.has_reflectance)
+  {
+    std::copy(scan.getReflectance(), scan.getReflectance() + num_beams, record.reflectance);
+  }
+  next_ = (next_ + 1) % records_.size();
+  num_recorded_ = std::min(num_recorded_ + 1, records_.size());
+
+  if (dump_pending_)
+  {
+    --scans_until_dump_;
+  }
+  const MeasurementReportHeader& header = scan.getHeader();
+  if (has_previous_ && !dump_pending_ && (header.machine_stop_reasons != previous_stop_reasons_ ||
+                                          header.detection_zone_status != previous_zone_status_))
+  {
+    dump_pending_ = true;
+    scans_until_dump_ = post_trigger_scans_;
+  }
+  has_previous_ = true;
+  previous_stop_reasons_ = header.machine_stop_reasons;
+  previous_zone_status_ = header.detection_zone_status;
+}
+
+string FlightRecorder::dump()
+{
+  return dump(num_recorded_);
+}
+
+void FlightRecorder::flush()
+{
+  pthread_mutex_lock(&mutex_);
+  while (writing_)
+  {
+    pthread_cond_wait(&cond_, &mutex_);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+string FlightRecorder::dump(EIP_UDINT trigger_record)
+{
+  pthread_mutex_lock(&mutex_);
+  bool writing = writing_;
+  pthread_mutex_unlock(&mutex_);
+  if (writing)
+  {
+    throw std::runtime_error("Still writing " + snapshot_filename_);
+  }
+  if (access(directory_.c_str(), W_OK) != 0)
+  {
+    throw std::runtime_error("Cannot write to " + directory_);
+  }
+
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  tm local;
+  localtime_r(&now.tv_sec, &local);
+  char name[128];
+  snprintf(name, sizeof(name), "/os32c_flight_%04d%02d%02d_%02d%02d%02d_%03ld.bin", local.tm_year + 1900,
+           local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec, now.tv_nsec / 1000000);
+  snapshot_filename_ = directory_ + name;
+
+  memset(&snapshot_header_, 0, sizeof(snapshot_header_));
+  strncpy(snapshot_header_.magic, "OS32CFR", sizeof(snapshot_header_.magic));
+  snapshot_header_.version = FLIGHT_RECORDER_VERSION;
+  snapshot_header_.record_size = sizeof(FlightRecord);
+  snapshot_header_.num_records = num_recorded_;
+  snapshot_header_.trigger_record = trigger_record;
+
+  // oldest first, which is the next record to overwrite once the ring is full
+  size_t oldest = num_recorded_ < records_.size() ? 0 : next_;
+  size_t num_wrapped = std::min(num_recorded_, records_.size() - oldest);
+  std::copy(records_.begin() + oldest, records_.begin() + oldest + num_wrapped, snapshot_.begin());
+  std::copy(records_.begin(), records_.begin() + (num_recorded_ - num_wrapped), snapshot_.begin() + num_wrapped);
+
+  pthread_mutex_lock(&mutex_);
+  writing_ = true;
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&mutex_);
+  return snapshot_filename_;
+}
+
+void* FlightRecorder::runWriter(void* arg)
+{
+  static_cast<FlightRecorder*>(arg)->writeSnapshots();
+  return NULL;
+}
+
+void FlightRecorder::writeSnapshots()
+{
+  pthread_mutex_lock(&mutex_);
+  while (true)
+  {
+    while (!writing_ && !stopping_)
+    {
+      pthread_cond_wait(&cond_, &mutex_);
+    }
+    if (!writing_)
+    {
+      break;
+    }
+    pthread_mutex_unlock(&mutex_);
+
+    try
+    {
+      writeSnapshot();
+    }
+    catch (std::runtime_error& ex)
+    {
+      CONSOLE_BRIDGE_logError("Unable to write flight recorder: %s", ex.what());
+    }
+    removeOldFiles();
+
+    pthread_mutex_lock(&mutex_);
+    writing_ = false;
+    pthread_cond_broadcast(&cond_);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+void FlightRecorder::writeSnapshot()
+{
+  std::ofstream file(snapshot_filename_.c_str(), std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&snapshot_header_), sizeof(snapshot_header_));
+  file.write(reinterpret_cast<const char*>(&snapshot_[0]), snapshot_header_.num_records * sizeof(FlightRecord));
+  if (!file)
+  {
+    throw std::runtime_error("Cannot write " + snapshot_filename_);
+  }
+}
+
+void FlightRecorder::removeOldFiles()
+{
+  if (max_files_ == 0)
+  {
+    return;
+  }
+  DIR* dir = opendir(directory_.c_str());
+  if (!dir)
+  {
+    return;
+  }
+  // the names start with the time they were written, so sort oldest first
+  vector<string> files;
+  for (dirent* entry = readdir(dir); entry; entry = readdir(dir))
+  {
+    string name = entry->d_name;
+    if (name.compare(0, 13, "os32c_flight_") == 0 && name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0)
+    {
+      files.push_back(name);
+    }
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+  for (size_t i = 0; i + max_files_ < files.size(); ++i)
+  {
+    string filename = directory_ + "/" + files[i];
+    if (unlink(filename.c_str()) != 0)
+    {
+      CONSOLE_BRIDGE_logWarn("Unable to remove old flight recorder file %s", filename.c_str());
+    }
+  }
+}
+
+}  // namespace omron_os32c_driver
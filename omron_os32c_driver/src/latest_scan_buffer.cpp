@@ -0,0 +1,80 @@
+/**
+Software License Agreement (BSD)
+
+\file      latest_scan_buffer.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <time.h>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/latest_scan_buffer.h"
+
+namespace omron_os32c_driver {
+
+LatestScanBuffer::LatestScanBuffer() : state_(1), back_(2), front_(0)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    slots_[i].ranges.assign(BeamSelection::NUM_BEAMS, 0);
+    slots_[i].reflectance.assign(BeamSelection::NUM_BEAMS, 0);
+    slots_[i].ranges.clear();
+    slots_[i].reflectance.clear();
+  }
+}
+
+void LatestScanBuffer::scanReceived(const ScanView& scan)
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  write(scan, now.tv_sec + now.tv_nsec / 1000000000.0);
+}
+
+void LatestScanBuffer::write(const ScanView& scan, double stamp)
+{
+  LatestScan& slot = slots_[back_];
+  slot.header = scan.getHeader();
+  slot.stamp = stamp;
+  slot.ranges.assign(scan.getRanges(), scan.getRanges() + scan.getNumBeams());
+  if (scan.getReflectance())
+  {
+    slot.reflectance.assign(scan.getReflectance(), scan.getReflectance() + scan.getNumBeams());
+  }
+  else
+  {
+    slot.reflectance.clear();
+  }
+
+  // publish the slot and take back whichever one the reader is not using
+  back_ = state_.exchange(back_ | FRESH, boost::memory_order_acq_rel) & INDEX_MASK;
+}
+
+bool LatestScanBuffer::update()
+{
+  if (!(state_.load(boost::memory_order_relaxed) & FRESH))
+  {
+    return false;
+  }
+  front_ = state_.exchange(front_, boost::memory_order_acq_rel) & INDEX_MASK;
+  return true;
+}
+
+}  // namespace omron_os32c_driver
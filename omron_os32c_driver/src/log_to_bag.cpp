@@ -0,0 +1,324 @@
+/**
+Software License Agreement (BSD)
+
+\file      log_to_bag.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <rosbag/bag.h>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_conversions.h"
+#include "omron_os32c_driver/scan_deskewer.h"
+#include "omron_os32c_driver/scan_log.h"
+#include "omron_os32c_driver/scan_view.h"
+#include "omron_os32c_driver/work_stealing_pool.h"
+
+using std::string;
+using std::vector;
+using boost::shared_ptr;
+using sensor_msgs::LaserScan;
+using sensor_msgs::PointCloud2;
+using namespace omron_os32c_driver;
+
+/**
+ * Options of the conversion, matching the node parameters of the same names
+ */
+struct ConversionOptions
+{
+  ConversionOptions()
+    : topic("scan")
+    , cloud_topic("cloud")
+    , frame_id("laser")
+    , start_angle(OS32C::ANGLE_MAX)
+    , end_angle(OS32C::ANGLE_MIN)
+    , beam_decimation(1)
+    , publish_intensities(false)
+    , invert_scan(false)
+    , cloud(false)
+    , jobs(0)
+  {
+  }
+
+  string topic;
+  string cloud_topic;
+  string frame_id;
+  double start_angle;
+  double end_angle;
+  int beam_decimation;
+  bool publish_intensities;
+  bool invert_scan;
+  bool cloud;
+  size_t jobs;
+};
+
+/**
+ * Converts a batch of chunks of a log, one chunk per task. Each worker reads
+ * through its own mapping of the log, and each task writes only to the results
+ * of its own chunk, so the tasks share nothing that changes.
+ */
+class ChunkConverter : public ParallelTask
+{
+public:
+  ChunkConverter(const string& filename, const BeamSelection& selection, const ConversionOptions& options,
+                 size_t num_workers)
+    : selection_(selection), options_(options), deskewers_(num_workers), first_chunk_(0)
+  {
+    for (size_t i = 0; i < num_workers; ++i)
+    {
+      readers_.push_back(shared_ptr<ScanLogReader>(new ScanLogReader(filename)));
+    }
+    fillLaserScanStaticConfig(selection, &config_);
+    config_.header.frame_id = options.frame_id;
+  }
+
+  void setBatch(size_t first_chunk, size_t num_chunks)
+  {
+    first_chunk_ = first_chunk;
+    scans_.resize(num_chunks);
+    clouds_.resize(num_chunks);
+    skipped_.assign(num_chunks, 0);
+  }
+
+  virtual void run(size_t task, size_t worker)
+  {
+    ScanLogReader& reader = *readers_[worker];
+    size_t chunk = first_chunk_ + task;
+    size_t num_scans = reader.getChunk(chunk).num_scans;
+    vector<LaserScan>& scans = scans_[task];
+    vector<PointCloud2>& clouds = clouds_[task];
+    scans.clear();
+    clouds.clear();
+    scans.reserve(num_scans);
+
+    reader.seekChunk(chunk);
+    ScanLogEntry entry;
+    for (size_t i = 0; i < num_scans && reader.next(&entry); ++i)
+    {
+      // scans taken with another beam selection would come out at the wrong angles
+      if (entry.num_beams != static_cast<size_t>(selection_.getNumBeams()))
+      {
+        ++skipped_[task];
+        continue;
+      }
+      scans.push_back(config_);
+      LaserScan& ls = scans.back();
+      convertToLaserScan(ScanView(entry.header, entry.ranges, entry.reflectance, entry.num_beams, &selection_), &ls);
+      expandToBeamSelection(selection_, &ls);
+      if (options_.invert_scan)
+      {
+        invertLaserScan(&ls);
+      }
+      if (!options_.publish_intensities)
+      {
+        ls.intensities.clear();
+      }
+      ls.header.stamp = ros::Time(entry.stamp);
+
+      if (options_.cloud)
+      {
+        // there is no odometry offline, so the cloud is the scan without deskewing
+        deskewers_[worker].configure(ls, options_.invert_scan);
+        clouds.push_back(PointCloud2());
+        deskewers_[worker].deskew(ls, 0, 0, 0, &clouds.back());
+      }
+    }
+  }
+
+  vector<LaserScan>& getScans(size_t task)
+  {
+    return scans_[task];
+  }
+
+  vector<PointCloud2>& getClouds(size_t task)
+  {
+    return clouds_[task];
+  }
+
+  size_t getSkipped(size_t task) const
+  {
+    return skipped_[task];
+  }
+
+private:
+  BeamSelection selection_;
+  ConversionOptions options_;
+  LaserScan config_;
+  vector<shared_ptr<ScanLogReader> > readers_;
+  vector<ScanDeskewer> deskewers_;
+  size_t first_chunk_;
+  vector<vector<LaserScan> > scans_;
+  vector<vector<PointCloud2> > clouds_;
+  vector<size_t> skipped_;
+};
+
+static int usage()
+{
+  fprintf(stderr,
+          "Usage: os32c_log_to_bag <log> <bag> [options]\n"
+          "\n"
+          "Convert a scan log to LaserScan messages, and optionally point clouds, in a bag.\n"
+          "Chunks of the log are converted in parallel and written in order.\n"
+          "\n"
+          "  --topic <name>            LaserScan topic, default scan\n"
+          "  --cloud                   Also write PointCloud2 messages\n"
+          "  --cloud-topic <name>      PointCloud2 topic, default cloud\n"
+          "  --frame-id <frame>        Frame of the messages, default laser\n"
+          "  --start-angle <rad>       Beams the log was recorded with, as for the driver\n"
+          "  --end-angle <rad>\n"
+          "  --beam-decimation <n>\n"
+          "  --publish-intensities     Keep the reflectances as intensities\n"
+          "  --invert-scan             Reverse the scans, as for a sensor mounted upside down\n"
+          "  --jobs <n>                Number of threads, default one per CPU\n");
+  return 2;
+}
+
+static bool parseOptions(int argc, char** argv, ConversionOptions* options)
+{
+  for (int i = 0; i < argc; ++i)
+  {
+    bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--cloud"))
+    {
+      options->cloud = true;
+    }
+    else if (!strcmp(argv[i], "--publish-intensities"))
+    {
+      options->publish_intensities = true;
+    }
+    else if (!strcmp(argv[i], "--invert-scan"))
+    {
+      options->invert_scan = true;
+    }
+    else if (!strcmp(argv[i], "--topic") && has_value)
+    {
+      options->topic = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--cloud-topic") && has_value)
+    {
+      options->cloud_topic = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--frame-id") && has_value)
+    {
+      options->frame_id = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--start-angle") && has_value)
+    {
+      options->start_angle = strtod(argv[++i], NULL);
+    }
+    else if (!strcmp(argv[i], "--end-angle") && has_value)
+    {
+      options->end_angle = strtod(argv[++i], NULL);
+    }
+    else if (!strcmp(argv[i], "--beam-decimation") && has_value)
+    {
+      options->beam_decimation = atoi(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "--jobs") && has_value)
+    {
+      options->jobs = strtoul(argv[++i], NULL, 0);
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  ConversionOptions options;
+  if (argc < 3 || !parseOptions(argc - 3, argv + 3, &options))
+  {
+    return usage();
+  }
+  string log_filename = argv[1];
+  string bag_filename = argv[2];
+
+  try
+  {
+    BeamSelection selection;
+    selection.addSector(options.start_angle, options.end_angle);
+    selection.setDecimation(options.beam_decimation);
+
+    WorkStealingPool pool(options.jobs);
+    ChunkConverter converter(log_filename, selection, options, pool.getNumWorkers());
+    ScanLogReader log(log_filename);
+    rosbag::Bag bag(bag_filename, rosbag::bagmode::Write);
+
+    // convert a few chunks per worker at a time, so that stealing can even out the
+    // work while the converted messages waiting to be written stay bounded
+    size_t batch_size = 4 * pool.getNumWorkers();
+    size_t num_chunks = log.getNumChunks();
+    size_t written = 0;
+    size_t skipped = 0;
+    for (size_t first = 0; first < num_chunks; first += batch_size)
+    {
+      size_t num_tasks = std::min(batch_size, num_chunks - first);
+      converter.setBatch(first, num_tasks);
+      pool.run(num_tasks, &converter);
+
+      // the bag is written from this thread only, in the order of the log
+      for (size_t task = 0; task < num_tasks; ++task)
+      {
+        vector<LaserScan>& scans = converter.getScans(task);
+        vector<PointCloud2>& clouds = converter.getClouds(task);
+        for (size_t i = 0; i < scans.size(); ++i)
+        {
+          scans[i].header.seq = written + i;
+          bag.write(options.topic, scans[i].header.stamp, scans[i]);
+          if (options.cloud)
+          {
+            clouds[i].header.seq = written + i;
+            bag.write(options.cloud_topic, clouds[i].header.stamp, clouds[i]);
+          }
+        }
+        written += scans.size();
+        skipped += converter.getSkipped(task);
+      }
+      fprintf(stderr, "\r%zu of %zu chunks, %zu scans", first + num_tasks, num_chunks, written);
+    }
+    bag.close();
+    fprintf(stderr, "\n");
+    if (skipped)
+    {
+      fprintf(stderr, "Skipped %zu scans whose beam count does not match the beam selection\n", skipped);
+    }
+  }
+  catch (std::exception& ex)
+  {
+    fprintf(stderr, "%s\n", ex.what());
+    return 1;
+  }
+  return 0;
+}
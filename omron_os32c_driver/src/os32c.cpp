@@ -24,34 +24,67 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 */
 
 
-#include <ros/ros.h>
+#include <console_bridge/console.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/asio.hpp>
 
 #include "omron_os32c_driver/os32c.h"
 #include "odva_ethernetip/serialization/serializable_buffer.h"
+#include "odva_ethernetip/serialization/serializable_primitive.h"
 #include "odva_ethernetip/cpf_packet.h"
 #include "odva_ethernetip/cpf_item.h"
 #include "odva_ethernetip/sequenced_address_item.h"
 #include "odva_ethernetip/sequenced_data_item.h"
 
-using std::cout;
-using std::endl;
 using boost::shared_ptr;
 using boost::make_shared;
 using boost::asio::buffer;
 using eip::Session;
 using eip::serialization::SerializableBuffer;
+using eip::serialization::SerializablePrimitive;
+using eip::Path;
 using eip::RRDataResponse;
 using eip::CPFItem;
 using eip::CPFPacket;
 using eip::SequencedAddressItem;
 using eip::SequencedDataItem;
+using eip::serialization::Serializable;
 using omron_os32c_driver::RangeAndReflectanceMeasurement;
 
 namespace omron_os32c_driver {
 
+/**
+ * Holder for reading the beam selection mask back from the sensor
+ */
+class BeamMaskBuffer : public Serializable
+{
+public:
+  EIP_BYTE mask[88];
+
+  virtual size_t getLength() const
+  {
+    return sizeof(mask);
+  }
+
+  virtual Writer& serialize(Writer& writer) const
+  {
+    writer.writeBytes(mask, sizeof(mask));
+    return writer;
+  }
+
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    return deserialize(reader);
+  }
+
+  virtual Reader& deserialize(Reader& reader)
+  {
+    reader.readBytes(mask, sizeof(mask));
+    return reader;
+  }
+};
+
 const double OS32C::ANGLE_MIN = DEG2RAD(-135.2);
 const double OS32C::ANGLE_MAX = DEG2RAD(135.2);
 const double OS32C::ANGLE_INC = DEG2RAD(0.4);
@@ -68,6 +101,7 @@ void OS32C::setRangeFormat(EIP_UINT format)
 {
   setSingleAttribute(0x73, 1, 4, format);
   mrc_.range_report_format = format;
+  invalidateConfigCache();
 }
 
 EIP_UINT OS32C::getReflectivityFormat()
@@ -80,22 +114,12 @@ void OS32C::setReflectivityFormat(EIP_UINT format)
 {
   setSingleAttribute(0x73, 1, 5, format);
   mrc_.reflectivity_report_format = format;
+  invalidateConfigCache();
 }
 
 void OS32C::calcBeamMask(double start_angle, double end_angle, EIP_BYTE mask[])
 {
-  if (start_angle > (ANGLE_MAX + ANGLE_INC / 2))
-  {
-    throw std::invalid_argument("Start angle is greater than max");
-  }
-  if (end_angle < (ANGLE_MIN - ANGLE_INC / 2))
-  {
-    throw std::invalid_argument("End angle is greater than max");
-  }
-  if (start_angle - end_angle <= ANGLE_INC)
-  {
-    throw std::invalid_argument("Starting angle is less than ending angle");
-  }
+  BeamSelection::validateSector(start_angle, end_angle);
 
   int start_beam = calcBeamNumber(start_angle);
   int end_beam = calcBeamNumber(end_angle);
@@ -138,94 +162,187 @@ void OS32C::calcBeamMask(double start_angle, double end_angle, EIP_BYTE mask[])
 void OS32C::selectBeams(double start_angle, double end_angle)
 {
   calcBeamMask(start_angle, end_angle, mrc_.beam_selection_mask);
-  shared_ptr<SerializableBuffer> sb = make_shared<SerializableBuffer>(buffer(mrc_.beam_selection_mask));
-  setSingleAttributeSerializable(0x73, 1, 12, sb);
+  selection_ = BeamSelection();
+  selection_.addSector(start_angle, end_angle);
+  selection_pending_ = true;
+  sendBeamMask();
 }
 
-RangeAndReflectanceMeasurement OS32C::getSingleRRScan()
+void OS32C::selectBeams(const BeamSelection& selection)
 {
-  RangeAndReflectanceMeasurement rr;
-  getSingleAttributeSerializable(0x75, 1, 3, rr);
-  return rr;
+  setBeamSelection(selection);
+  sendBeamMask();
 }
 
-void OS32C::fillLaserScanStaticConfig(sensor_msgs::LaserScan* ls)
+void OS32C::setBeamSelection(const BeamSelection& selection)
 {
-  ls->angle_max = start_angle_;
-  ls->angle_min = end_angle_;
-  ls->angle_increment = ANGLE_INC;
-  ls->range_min = DISTANCE_MIN;
-  ls->range_max = DISTANCE_MAX;
+  if (selection.getNumBeams() == 0)
+  {
+    throw std::invalid_argument("No beams selected");
+  }
+  selection_ = selection;
+  selection_.getMask(mrc_.beam_selection_mask);
+  selection_pending_ = true;
 }
 
-void OS32C::convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls)
+bool OS32C::updateReportSelection(EIP_UINT num_beams)
 {
-  if (rr.range_data.size() != rr.header.num_beams || rr.reflectance_data.size() != rr.header.num_beams)
+  if (!selection_pending_ || num_beams != selection_.getNumBeams())
   {
-    throw std::invalid_argument("Number of beams does not match vector size");
+    return false;
   }
+  report_selection_ = selection_;
+  start_angle_ = calcBeamCentre(report_selection_.getFirstBeam());
+  end_angle_ = calcBeamCentre(report_selection_.getLastBeam());
+  selection_pending_ = false;
+  return true;
+}
 
-  // Beam period is in ns
-  ls->time_increment = rr.header.scan_beam_period / 1000000000.0;
-  // Scan period is in microseconds.
-  ls->scan_time = rr.header.scan_rate / 1000000.0;
+void OS32C::sendBeamMask()
+{
+  shared_ptr<SerializableBuffer> sb = make_shared<SerializableBuffer>(buffer(mrc_.beam_selection_mask));
+  setSingleAttributeSerializable(0x73, 1, 12, sb);
+  invalidateConfigCache();
+}
 
-  // TODO: this currently makes assumptions of the report format. Should likely
-  // accomodate all of them, or at least anything reasonable.
-  ls->ranges.resize(rr.header.num_beams);
-  ls->intensities.resize(rr.header.num_beams);
-  for (int i = 0; i < rr.header.num_beams; ++i)
+MultipleServiceResponse OS32C::sendMultipleServices(const MultipleServiceRequest& request)
+{
+  shared_ptr<MultipleServiceRequest> req = make_shared<MultipleServiceRequest>(request);
+  RRDataResponse resp_data = sendRRDataCommand(0x0A, Path(0x02, 1), req);
+  MultipleServiceResponse result;
+  resp_data.getResponseDataAs(result);
+  if (result.getCount() != request.getCount())
   {
-    if (rr.range_data[i] == 0x0001)
-    {
-      // noisy beam detected
-      ls->ranges[i] = 0;
-    }
-    else if (rr.range_data[i] == 0xFFFF)
+    throw std::logic_error("Number of replies does not match number of requests");
+  }
+  return result;
+}
+
+int OS32C::applyConfiguration(EIP_UINT range_format, EIP_UINT reflectivity_format, const BeamSelection& selection)
+{
+  setBeamSelection(selection);
+  const size_t mask_size = sizeof(mrc_.beam_selection_mask);
+
+  // a cached configuration only needs the checksum of the sensor to confirm it
+  if (config_cache_.valid && config_cache_.range_report_format == range_format &&
+      config_cache_.reflectivity_report_format == reflectivity_format &&
+      config_cache_.num_beams == static_cast<EIP_UINT>(selection.getNumBeams()) &&
+      !memcmp(config_cache_.beam_selection_mask, mrc_.beam_selection_mask, mask_size))
+  {
+    MeasurementReportHeader header = getMeasurementReportHeader();
+    if (header.non_safety_config_checksum == config_cache_.checksum && header.range_report_format == range_format &&
+        header.refletivity_report_format == reflectivity_format && header.num_beams == config_cache_.num_beams)
     {
-      // no return
-      ls->ranges[i] = DISTANCE_MAX;
+      mrc_.range_report_format = range_format;
+      mrc_.reflectivity_report_format = reflectivity_format;
+      checksum_pending_ = false;
+      return 0;
     }
-    else
+  }
+
+  // otherwise read everything back in one round trip
+  MultipleServiceRequest read_req;
+  size_t range_idx = read_req.addGetAttribute(0x73, 1, 4);
+  size_t refl_idx = read_req.addGetAttribute(0x73, 1, 5);
+  size_t mask_idx = read_req.addGetAttribute(0x73, 1, 12);
+  MultipleServiceResponse read_resp = sendMultipleServices(read_req);
+
+  SerializablePrimitive<EIP_UINT> current_range, current_refl;
+  BeamMaskBuffer current_mask;
+  read_resp.getReplyDataAs(range_idx, current_range);
+  read_resp.getReplyDataAs(refl_idx, current_refl);
+  read_resp.getReplyDataAs(mask_idx, current_mask);
+
+  // then write only what differs in a second one
+  MultipleServiceRequest write_req;
+  if (current_range.data != range_format)
+  {
+    write_req.addSetAttribute(0x73, 1, 4, make_shared<SerializablePrimitive<EIP_UINT> >(range_format));
+  }
+  if (current_refl.data != reflectivity_format)
+  {
+    write_req.addSetAttribute(0x73, 1, 5, make_shared<SerializablePrimitive<EIP_UINT> >(reflectivity_format));
+  }
+  if (memcmp(current_mask.mask, mrc_.beam_selection_mask, mask_size))
+  {
+    write_req.addSetAttribute(0x73, 1, 12, make_shared<SerializableBuffer>(buffer(mrc_.beam_selection_mask)));
+  }
+  if (write_req.getCount())
+  {
+    MultipleServiceResponse write_resp = sendMultipleServices(write_req);
+    for (size_t i = 0; i < write_resp.getCount(); ++i)
     {
-      ls->ranges[i] = rr.range_data[i] / 1000.0;
+      write_resp.checkReply(i);
     }
-    ls->intensities[i] = rr.reflectance_data[i];
   }
+  mrc_.range_report_format = range_format;
+  mrc_.reflectivity_report_format = reflectivity_format;
+
+  // the checksum of the configuration comes with the next report
+  config_cache_.valid = false;
+  config_cache_.range_report_format = range_format;
+  config_cache_.reflectivity_report_format = reflectivity_format;
+  config_cache_.num_beams = selection.getNumBeams();
+  memcpy(config_cache_.beam_selection_mask, mrc_.beam_selection_mask, mask_size);
+  checksum_pending_ = true;
+  return write_req.getCount();
+}
+
+void OS32C::invalidateConfigCache()
+{
+  config_cache_.valid = false;
+  checksum_pending_ = false;
 }
 
-void OS32C::convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls)
+bool OS32C::checkConfigChecksum(const MeasurementReportHeader& header)
 {
-  if (mr.measurement_data.size() != mr.header.num_beams)
+  if (checksum_pending_)
   {
-    throw std::invalid_argument("Number of beams does not match vector size");
+    config_cache_.checksum = header.non_safety_config_checksum;
+    config_cache_.valid = true;
+    checksum_pending_ = false;
+    return true;
   }
+  if (config_cache_.valid && config_cache_.checksum != header.non_safety_config_checksum)
+  {
+    config_cache_.valid = false;
+    return false;
+  }
+  return true;
+}
 
-  // Beam period is in ns.
-  ls->time_increment = mr.header.scan_beam_period / 1000000000.0;
-  // Scan period is in microseconds.
-  ls->scan_time = mr.header.scan_rate / 1000000.0;
+MeasurementReportHeader OS32C::getMeasurementReportHeader()
+{
+  MeasurementReportHeader header;
+  getSingleAttributeSerializable(0x75, 1, 3, header);
+  return header;
+}
 
-  // TODO: this currently makes assumptions of the report format. Should likely
-  // accomodate all of them, or at least anything reasonable.
-  ls->ranges.resize(mr.header.num_beams);
-  for (int i = 0; i < mr.header.num_beams; ++i)
+RangeAndReflectanceMeasurement OS32C::getSingleRRScan()
+{
+  RangeAndReflectanceMeasurement rr;
+  getSingleRRScan(rr);
+  return rr;
+}
+
+void OS32C::getSingleRRScan(RangeAndReflectanceMeasurement& rr)
+{
+  ReportStatus status = tryGetSingleRRScan(rr);
+  if (status != REPORT_OK)
   {
-    if (mr.measurement_data[i] == 0x0001)
-    {
-      // noisy beam detected
-      ls->ranges[i] = 0;
-    }
-    else if (mr.measurement_data[i] == 0xFFFF)
-    {
-      // no return
-      ls->ranges[i] = DISTANCE_MAX;
-    }
-    else
-    {
-      ls->ranges[i] = mr.measurement_data[i] / 1000.0;
-    }
+    throw std::logic_error(string("Range and reflectance report not decoded: ") + getReportStatusName(status));
+  }
+}
+
+ReportStatus OS32C::tryGetSingleRRScan(RangeAndReflectanceMeasurement& rr)
+{
+  RRDataResponse resp_data = sendRRDataCommand(0x0E, Path(0x75, 1, (EIP_USINT)3), shared_ptr<Serializable>());
+  if (!resp_data.getResponseData())
+  {
+    return report_counters_.count(REPORT_NO_DATA);
   }
+  resp_data.getResponseDataAs(report_buffer_);
+  return report_counters_.count(decodeRangeAndReflectance(report_buffer_, &rr));
 }
 
 void OS32C::sendMeasurmentReportConfigUDP()
@@ -243,19 +360,58 @@ void OS32C::sendMeasurmentReportConfigUDP()
 
 MeasurementReport OS32C::receiveMeasurementReportUDP()
 {
-  CPFPacket pkt = receiveIOPacket();
-  if (pkt.getItemCount() != 2)
+  MeasurementReport report;
+  ReportStatus status = tryReceiveMeasurementReportUDP(report);
+  if (status != REPORT_OK)
   {
-    throw std::logic_error("IO Packet received with wrong number of items");
+    throw std::logic_error(string("Measurement report not decoded: ") + getReportStatusName(status));
   }
-  if (pkt.getItems()[1].getItemType() != 0x00B1)
+  return report;
+}
+
+ReportStatus OS32C::tryReceiveMeasurementReportUDP(MeasurementReport& report)
+{
+  // Parsing the items throws on lengths that do not add up, which is what a
+  // malformed datagram looks like, so those are counted rather than thrown.
+  // Errors receiving are runtime errors and still go to the caller.
+  CPFPacket pkt;
+  SequencedAddressItem address;
+  try
   {
-    throw std::logic_error("IO Packet received with wrong data type");
+    pkt = receiveIOPacket();
+    if (pkt.getItemCount() != 2 || pkt.getItems()[0].getItemType() != 0x8002 ||
+        pkt.getItems()[1].getItemType() != 0x00B1)
+    {
+      return report_counters_.count(REPORT_BAD_PACKET);
+    }
+    pkt.getItems()[0].getDataAs(address);
+  }
+  catch (std::logic_error& ex)
+  {
+    return report_counters_.count(REPORT_BAD_PACKET);
   }
 
-  SequencedDataItem<MeasurementReport> data;
-  pkt.getItems()[1].getDataAs(data);
-  return data;
+  // order by the address item before touching the beam data
+  if (connection_num_ >= 0 && address.connection_id != getConnection(connection_num_).t_to_o_connection_id)
+  {
+    return report_counters_.count(REPORT_WRONG_CONNECTION);
+  }
+  ReportStatus status = io_sequence_.check(address.sequence_num);
+  if (status != REPORT_OK)
+  {
+    return report_counters_.count(status);
+  }
+
+  SequencedDataItem<ReportBuffer> data;
+  try
+  {
+    pkt.getItems()[1].getDataAs(data);
+  }
+  catch (std::logic_error& ex)
+  {
+    return report_counters_.count(REPORT_BAD_PACKET);
+  }
+  return report_counters_.count(decodeMeasurementReport(data, &report));
 }
 
 void OS32C::startUDPIO()
@@ -265,18 +421,19 @@ void OS32C::startUDPIO()
   o_to_t.buffer_size = 0x006E;
   o_to_t.rpi = 0x00177FA0;
   t_to_o.assembly_id = 0x66;
-  t_to_o.buffer_size = 0x0584;
+  t_to_o.buffer_size = UDP_REPORT_SIZE;
   t_to_o.rpi = 0x00013070;
 
   connection_num_ = createConnection(o_to_t, t_to_o);
-  ROS_INFO("Opened connection with id %d", connection_num_);
+  io_sequence_.reset();
+  CONSOLE_BRIDGE_logInform("Opened connection with id %d", connection_num_);
 }
 
 void OS32C::closeActiveConnection()
 {
   if (connection_num_ >= 0)
   {
-    ROS_INFO("Closing connection with id %d", connection_num_);
+    CONSOLE_BRIDGE_logInform("Closing connection with id %d", connection_num_);
     closeConnection(connection_num_);
   }
 }
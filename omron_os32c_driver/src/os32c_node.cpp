@@ -26,29 +26,658 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 
 #include <ros/ros.h>
 #include <boost/shared_ptr.hpp>
-#include <boost/range/algorithm.hpp>
 #include <diagnostic_updater/publisher.h>
+#include <nav_msgs/Odometry.h>
 #include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <std_srvs/Trigger.h>
+#include <tf2/LinearMath/Transform.h>
+#include <tf2_ros/transform_listener.h>
 
 #include <rosconsole_bridge/bridge.h>
+#include <fstream>
+#include <sstream>
+#include <limits>
 REGISTER_ROSCONSOLE_BRIDGE;
 
-#include "odva_ethernetip/socket/tcp_socket.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
 #include "odva_ethernetip/socket/udp_socket.h"
+#include "omron_os32c_driver/Configure.h"
+#include "omron_os32c_driver/flight_recorder.h"
 #include "omron_os32c_driver/os32c.h"
 #include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/RawScan.h"
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/reconnect_backoff.h"
+#include "omron_os32c_driver/report_decoder.h"
+#include "omron_os32c_driver/scan_acquisition.h"
+#include "omron_os32c_driver/scan_conversions.h"
+#include "omron_os32c_driver/scan_deskewer.h"
+#include "omron_os32c_driver/scan_filter_chain.h"
+#include "omron_os32c_driver/scan_rate_monitor.h"
+#include "omron_os32c_driver/sector_minima.h"
+#include "omron_os32c_driver/SectorRanges.h"
+#include "omron_os32c_driver/shm_scan_ring.h"
+#include "omron_os32c_driver/stall_detector.h"
+#include "omron_os32c_driver/temporal_median_filter.h"
+#include "omron_os32c_driver/timeout_tcp_socket.h"
 
 using std::cout;
 using std::endl;
 using boost::shared_ptr;
-using boost::range::reverse;
 using sensor_msgs::LaserScan;
-using eip::socket::TCPSocket;
+using sensor_msgs::PointCloud2;
 using eip::socket::UDPSocket;
+using eip::serialization::BufferReader;
+using eip::serialization::BufferWriter;
 using namespace omron_os32c_driver;
 using namespace diagnostic_updater;
 const double EPS = 1e-3;
+const double MAX_FREQUENCY = 25;
+const double ODOM_TIMEOUT = 0.5;
+const double RECONNECT_INITIAL_DELAY = 0.05;
+const size_t PREFAULT_STACK_SIZE = 64 * 1024;
+const double MIN_REQUEST_TIMEOUT = 0.001;
 
+/**
+ * Keeps the latest odometry twist, moved into the frame of the laser. The transform
+ * from the odometry child frame to the laser is static, so it is only looked up
+ * when the child frame changes.
+ */
+class VelocitySource
+{
+public:
+  VelocitySource(const std::string& frame_id) : frame_id_(frame_id), tf_listener_(tf_buffer_), has_transform_(false)
+  {
+  }
+
+  void odomCallback(const nav_msgs::Odometry::ConstPtr& odom)
+  {
+    if (!has_transform_ || odom->child_frame_id != child_frame_id_)
+    {
+      geometry_msgs::TransformStamped tf;
+      try
+      {
+        tf = tf_buffer_.lookupTransform(frame_id_, odom->child_frame_id, ros::Time(0));
+      }
+      catch (tf2::TransformException& ex)
+      {
+        ROS_WARN_THROTTLE(5.0, "Cannot deskew scans: %s", ex.what());
+        return;
+      }
+      const geometry_msgs::Transform& t = tf.transform;
+      laser_from_base_ = tf2::Transform(tf2::Quaternion(t.rotation.x, t.rotation.y, t.rotation.z, t.rotation.w),
+                                        tf2::Vector3(t.translation.x, t.translation.y, t.translation.z));
+      laser_in_base_ = laser_from_base_.inverse().getOrigin();
+      child_frame_id_ = odom->child_frame_id;
+      has_transform_ = true;
+    }
+
+    const geometry_msgs::Twist& twist = odom->twist.twist;
+    tf2::Vector3 v(twist.linear.x, twist.linear.y, twist.linear.z);
+    tf2::Vector3 w(twist.angular.x, twist.angular.y, twist.angular.z);
+    linear_ = laser_from_base_.getBasis() * (v + w.cross(laser_in_base_));
+    angular_ = laser_from_base_.getBasis() * w;
+    stamp_ = odom->header.stamp;
+  }
+
+  /**
+   * Get the planar velocity of the laser. Reports no motion if odometry has not
+   * been received recently.
+   */
+  void getVelocity(const ros::Time& now, double* vx, double* vy, double* wz) const
+  {
+    if (stamp_.isZero() || (now - stamp_).toSec() > ODOM_TIMEOUT)
+    {
+      *vx = *vy = *wz = 0;
+      return;
+    }
+    *vx = linear_.x();
+    *vy = linear_.y();
+    *wz = angular_.z();
+  }
+
+private:
+  std::string frame_id_;
+  std::string child_frame_id_;
+  tf2_ros::Buffer tf_buffer_;
+  tf2_ros::TransformListener tf_listener_;
+  bool has_transform_;
+  tf2::Transform laser_from_base_;
+  tf2::Vector3 laser_in_base_;
+  tf2::Vector3 linear_;
+  tf2::Vector3 angular_;
+  ros::Time stamp_;
+};
+
+
+/**
+ * Read a number from an XmlRpc value that may be either an integer or a double
+ */
+double xmlRpcToDouble(XmlRpc::XmlRpcValue& value)
+{
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+  {
+    return static_cast<int>(value);
+  }
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+  {
+    return static_cast<double>(value);
+  }
+  throw std::invalid_argument("Expected a number");
+}
+
+/**
+ * Read a list of [start_angle, end_angle] pairs from a parameter
+ * @return false if the parameter is not set
+ * @throw std::invalid_argument if the parameter is not a list of pairs
+ */
+bool getSectorsParam(const std::string& name, vector<std::pair<double, double> >* sectors)
+{
+  XmlRpc::XmlRpcValue list;
+  if (!ros::param::get(name, list))
+  {
+    return false;
+  }
+  if (list.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    throw std::invalid_argument(name + " must be a list of [start_angle, end_angle] pairs");
+  }
+  for (int i = 0; i < list.size(); ++i)
+  {
+    if (list[i].getType() != XmlRpc::XmlRpcValue::TypeArray || list[i].size() != 2)
+    {
+      throw std::invalid_argument(name + " must be a list of [start_angle, end_angle] pairs");
+    }
+    sectors->push_back(std::make_pair(xmlRpcToDouble(list[i][0]), xmlRpcToDouble(list[i][1])));
+  }
+  return true;
+}
+
+/**
+ * Load a config cache saved by a previous run
+ * @param filename File to load from
+ * @param cache Cache to fill
+ * @return false if the file does not exist or cannot be read
+ */
+bool loadConfigCache(const std::string& filename, ConfigCache* cache)
+{
+  vector<EIP_BYTE> d(cache->getLength());
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  file.read(reinterpret_cast<char*>(&d[0]), d.size());
+  if (file.gcount() != static_cast<std::streamsize>(d.size()))
+  {
+    return false;
+  }
+  BufferReader reader(boost::asio::buffer(d));
+  cache->deserialize(reader);
+  return true;
+}
+
+/**
+ * Save the config cache if it is valid and differs from what was last saved.
+ * Called for every scan, so the comparison is done on the fields and the cache
+ * is only serialized when it has actually changed.
+ * @param filename File to save to
+ * @param cache Cache to save
+ * @param saved Cache last saved, updated if the cache is saved again
+ */
+void saveConfigCache(const std::string& filename, const ConfigCache& cache, ConfigCache* saved)
+{
+  if (!cache.valid || (saved->valid && cache.checksum == saved->checksum &&
+                       cache.range_report_format == saved->range_report_format &&
+                       cache.reflectivity_report_format == saved->reflectivity_report_format &&
+                       cache.num_beams == saved->num_beams &&
+                       !memcmp(cache.beam_selection_mask, saved->beam_selection_mask, sizeof(cache.beam_selection_mask))))
+  {
+    return;
+  }
+  vector<EIP_BYTE> d(cache.getLength());
+  BufferWriter writer(boost::asio::buffer(d));
+  cache.serialize(writer);
+  std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&d[0]), d.size());
+  if (!file)
+  {
+    ROS_WARN("Unable to save sensor config cache to %s", filename.c_str());
+  }
+  *saved = cache;
+}
+
+/**
+ * Read a list of [start_angle, end_angle, min_range] self masks from a parameter
+ * into a filter chain
+ * @throw std::invalid_argument if the parameter is not a list of triples, or a
+ *  mask is invalid
+ */
+void getSelfMaskParam(const std::string& name, ScanFilterChain* chain)
+{
+  XmlRpc::XmlRpcValue list;
+  if (!ros::param::get(name, list))
+  {
+    return;
+  }
+  if (list.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    throw std::invalid_argument(name + " must be a list of [start_angle, end_angle, min_range] triples");
+  }
+  for (int i = 0; i < list.size(); ++i)
+  {
+    if (list[i].getType() != XmlRpc::XmlRpcValue::TypeArray || list[i].size() != 3)
+    {
+      throw std::invalid_argument(name + " must be a list of [start_angle, end_angle, min_range] triples");
+    }
+    chain->addSelfMask(xmlRpcToDouble(list[i][0]), xmlRpcToDouble(list[i][1]), xmlRpcToDouble(list[i][2]));
+  }
+}
+
+/**
+ * Sensor configuration that is applied on every connect, and can be changed while
+ * running through the ~configure service.
+ */
+struct SensorConfig
+{
+  EIP_UINT range_format;
+  EIP_UINT reflectivity_format;
+  BeamSelection beam_selection;
+};
+
+/**
+ * Handler for the ~configure service. Service calls are handled from spinOnce()
+ * in the acquisition loop, so changes are written to the sensor directly over
+ * the open session, without reconnecting.
+ */
+class ConfigureService
+{
+public:
+  ConfigureService(SensorConfig* config) : config_(config), os32c_(NULL)
+  {
+  }
+
+  /**
+   * Set the sensor to apply changes to, or NULL if not connected
+   */
+  void setSensor(OS32C* os32c)
+  {
+    os32c_ = os32c;
+  }
+
+  bool callback(Configure::Request& req, Configure::Response& res)
+  {
+    SensorConfig config = *config_;
+    bool select_beams = !req.start_angles.empty();
+    try
+    {
+      if (req.start_angles.size() != req.end_angles.size() ||
+          req.excluded_start_angles.size() != req.excluded_end_angles.size())
+      {
+        throw std::invalid_argument("Start and end angles must be given in pairs");
+      }
+      if (select_beams)
+      {
+        BeamSelection selection;
+        for (size_t i = 0; i < req.start_angles.size(); ++i)
+        {
+          selection.addSector(req.start_angles[i], req.end_angles[i]);
+        }
+        for (size_t i = 0; i < req.excluded_start_angles.size(); ++i)
+        {
+          selection.excludeSector(req.excluded_start_angles[i], req.excluded_end_angles[i]);
+        }
+        selection.setDecimation(std::max(1, req.beam_decimation));
+        config.beam_selection = selection;
+      }
+      if (req.set_formats)
+      {
+        config.range_format = req.range_format;
+        config.reflectivity_format = req.reflectivity_format;
+      }
+
+      if (os32c_)
+      {
+        os32c_->applyConfiguration(config.range_format, config.reflectivity_format, config.beam_selection);
+      }
+    }
+    catch (std::exception& ex)
+    {
+      res.success = false;
+      res.message = ex.what();
+      return true;
+    }
+
+    *config_ = config;
+    res.success = true;
+    return true;
+  }
+
+private:
+  SensorConfig* config_;
+  OS32C* os32c_;
+};
+
+/**
+ * Diagnostics for the connection to the sensor, including how long it took to
+ * get scans flowing again after the last outage.
+ */
+class ConnectionDiagnostics
+{
+public:
+  ConnectionDiagnostics() : connected_(false), connects_(0), last_recovery_time_(0), last_detection_latency_(0)
+  {
+  }
+
+  /**
+   * Record that scans are being received again
+   * @param recovery_time Seconds from the last received scan (or startup) to the first new scan
+   */
+  void connected(double recovery_time)
+  {
+    if (connects_ > 0)
+    {
+      ROS_INFO("Reconnected after %.3f seconds", recovery_time);
+    }
+    connected_ = true;
+    ++connects_;
+    last_recovery_time_ = recovery_time;
+  }
+
+  /**
+   * Record that scans have stopped
+   * @param detection_latency Seconds from the last received scan to noticing
+   */
+  void disconnected(double detection_latency)
+  {
+    connected_ = false;
+    last_detection_latency_ = detection_latency;
+  }
+
+  void produceDiagnostics(DiagnosticStatusWrapper& stat)
+  {
+    if (connected_)
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Connected");
+    }
+    else
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::ERROR, "Not connected");
+    }
+    stat.add("Reconnects", connects_ > 0 ? connects_ - 1 : 0);
+    stat.add("Last reconnect duration (s)", last_recovery_time_);
+    stat.add("Last stall detection latency (s)", last_detection_latency_);
+  }
+
+private:
+  bool connected_;
+  int connects_;
+  double last_recovery_time_;
+  double last_detection_latency_;
+};
+
+/**
+ * Reports the real-time settings in effect for the acquisition loop
+ */
+class RealtimeDiagnostics
+{
+public:
+  RealtimeDiagnostics(const RealtimeSettings& settings, const RealtimeStatus& status)
+    : settings_(settings), status_(status)
+  {
+  }
+
+  void produceDiagnostics(DiagnosticStatusWrapper& stat)
+  {
+    if (status_.errors.empty())
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Real-time settings applied");
+    }
+    else
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Some real-time settings could not be applied");
+    }
+    stat.add("Requested priority", settings_.priority);
+    stat.add("SCHED_FIFO priority", status_.priority);
+    std::ostringstream cpus;
+    for (size_t i = 0; i < status_.cpus.size(); ++i)
+    {
+      cpus << (i ? "," : "") << status_.cpus[i];
+    }
+    stat.add("CPU affinity", cpus.str());
+    stat.add("Memory locked", status_.lock_memory);
+    for (size_t i = 0; i < status_.errors.size(); ++i)
+    {
+      stat.add("Error", status_.errors[i]);
+    }
+  }
+
+private:
+  RealtimeSettings settings_;
+  RealtimeStatus status_;
+};
+
+/**
+ * Reports how many scan reports were dropped, by reason. The counts replace
+ * a log message per malformed or out of order report.
+ */
+class ReportDiagnostics
+{
+public:
+  ReportDiagnostics(const OS32C* os32c) : os32c_(os32c), last_errors_(0)
+  {
+  }
+
+  void produceDiagnostics(DiagnosticStatusWrapper& stat)
+  {
+    const ReportCounters& counters = os32c_->getReportCounters();
+    boost::uint64_t errors = counters.getErrors();
+    if (errors == last_errors_)
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Reports decoded");
+    }
+    else
+    {
+      stat.summaryf(diagnostic_msgs::DiagnosticStatus::WARN, "%llu reports dropped since the last update",
+                    static_cast<unsigned long long>(errors - last_errors_));
+    }
+    last_errors_ = errors;
+    for (int i = 0; i < NUM_REPORT_STATUSES; ++i)
+    {
+      ReportStatus status = static_cast<ReportStatus>(i);
+      stat.add(getReportStatusName(status), counters.get(status));
+    }
+  }
+
+private:
+  const OS32C* os32c_;
+  boost::uint64_t last_errors_;
+};
+
+/**
+ * Publishes the scans delivered by the acquisition as ROS messages: the LaserScan,
+ * plus the raw scan and the motion compensated cloud when enabled. Runs on the
+ * acquisition thread and reuses its messages between scans.
+ */
+class ScanPublisher : public ScanObserver
+{
+public:
+  ScanPublisher(const std::string& frame_id, bool publish_intensities, bool invert_scan,
+                DiagnosedPublisher<LaserScan>* diagnosed_publisher)
+    : publish_intensities_(publish_intensities), invert_scan_(invert_scan), diagnosed_publisher_(diagnosed_publisher)
+  {
+    laserscan_msg_.header.frame_id = frame_id;
+    raw_scan_msg_.header.frame_id = frame_id;
+
+    // Size the message buffers for a full scan up front and touch them, so that the
+    // loop neither allocates nor page faults on them. Vectors keep their capacity
+    // when they shrink for smaller beam selections.
+    laserscan_msg_.ranges.assign(BeamSelection::NUM_BEAMS, 0);
+    laserscan_msg_.intensities.assign(BeamSelection::NUM_BEAMS, 0);
+    raw_scan_msg_.indices.assign(BeamSelection::NUM_BEAMS, 0);
+    raw_scan_msg_.ranges.assign(BeamSelection::NUM_BEAMS, 0);
+    raw_scan_msg_.intensities.assign(BeamSelection::NUM_BEAMS, 0);
+    raw_scan_msg_.indices.clear();
+  }
+
+  /**
+   * Also publish each scan as a RawScan
+   */
+  void setRawScanPublisher(const ros::Publisher& raw_scan_pub)
+  {
+    raw_scan_pub_ = raw_scan_pub;
+  }
+
+  /**
+   * Also publish each scan as a point cloud, deskewed with the velocity from odometry
+   */
+  void setCloudPublisher(const ros::Publisher& cloud_pub, shared_ptr<VelocitySource> velocity_source)
+  {
+    cloud_pub_ = cloud_pub;
+    velocity_source_ = velocity_source;
+  }
+
+  /**
+   * Also publish the nearest return in each of the sectors of the given minima
+   */
+  void setSectorRangesPublisher(const ros::Publisher& sector_ranges_pub, shared_ptr<SectorMinima> sector_minima)
+  {
+    sector_ranges_pub_ = sector_ranges_pub;
+    sector_minima_ = sector_minima;
+  }
+
+  virtual void scanReceived(const ScanView& scan)
+  {
+    const BeamSelection* selection = scan.getSelection();
+    if (scan.isSelectionChanged() && selection)
+    {
+      fillLaserScanStaticConfig(*selection, &laserscan_msg_);
+      fillRawScanStaticConfig(*selection, &raw_scan_msg_);
+      if (invert_scan_)
+      {
+        invertRawScanStaticConfig(&raw_scan_msg_);
+      }
+      if (sector_minima_)
+      {
+        sector_minima_->configure(*selection);
+      }
+    }
+    ros::Time stamp = ros::Time::now();
+
+    // The sector ranges go out first, as they are the cheapest and the most
+    // urgent for the controllers that use them
+    if (sector_minima_ && sector_ranges_pub_.getNumSubscribers() > 0)
+    {
+      sector_minima_->reduce(scan.getRanges(), scan.getNumBeams());
+      convertToSectorRanges(*sector_minima_, laserscan_msg_, invert_scan_, &sector_ranges_msg_);
+      sector_ranges_msg_.header.frame_id = laserscan_msg_.header.frame_id;
+      sector_ranges_msg_.header.stamp = stamp;
+      sector_ranges_msg_.header.seq++;
+      sector_ranges_pub_.publish(sector_ranges_msg_);
+    }
+
+    // Only convert to the outputs that someone listens to. The point cloud is
+    // made from the laser scan, so it needs the laser scan too.
+    bool publish_scan = diagnosed_publisher_->getPublisher().getNumSubscribers() > 0;
+    bool publish_raw_scan = raw_scan_pub_ && raw_scan_pub_.getNumSubscribers() > 0;
+    bool publish_cloud = velocity_source_ && cloud_pub_.getNumSubscribers() > 0;
+
+    // In earlier versions reflectivity was not received. So to be backwards
+    // compatible leave it out of the messages, and skip converting it.
+    const ScanView scan_ranges(scan.getHeader(), scan.getRanges(), publish_intensities_ ? scan.getReflectance() : NULL,
+                               scan.getNumBeams(), selection, scan.isSelectionChanged());
+
+    laserscan_msg_.header.stamp = stamp;
+    laserscan_msg_.header.seq++;
+    if (!publish_scan && !publish_cloud)
+    {
+      // Still count the scan, so that the frequency diagnostics show the rate of
+      // the sensor rather than an error while nobody subscribes
+      diagnosed_publisher_->tick(laserscan_msg_.header.stamp);
+    }
+    else
+    {
+      convertToLaserScan(scan_ranges, &laserscan_msg_);
+      if (selection)
+      {
+        expandToBeamSelection(*selection, &laserscan_msg_);
+      }
+
+      // Invert range measurements if z-axis is needed to point upwards.
+      if (invert_scan_)
+      {
+        invertLaserScan(&laserscan_msg_);
+      }
+
+      // Publish message diagnosed
+      diagnosed_publisher_->publish(laserscan_msg_);
+    }
+
+    if (publish_raw_scan)
+    {
+      convertToRawScan(scan_ranges, &raw_scan_msg_);
+      if (invert_scan_)
+      {
+        invertRawScan(&raw_scan_msg_);
+      }
+      raw_scan_msg_.header.stamp = laserscan_msg_.header.stamp;
+      raw_scan_msg_.header.seq++;
+      raw_scan_pub_.publish(raw_scan_msg_);
+    }
+
+    if (publish_cloud)
+    {
+      double vx, vy, wz;
+      velocity_source_->getVelocity(laserscan_msg_.header.stamp, &vx, &vy, &wz);
+      deskewer_.configure(laserscan_msg_, invert_scan_);
+      deskewer_.deskew(laserscan_msg_, vx, vy, wz, &cloud_msg_);
+      cloud_pub_.publish(cloud_msg_);
+    }
+  }
+
+private:
+  bool publish_intensities_;
+  bool invert_scan_;
+  DiagnosedPublisher<LaserScan>* diagnosed_publisher_;
+  ros::Publisher raw_scan_pub_;
+  ros::Publisher cloud_pub_;
+  ros::Publisher sector_ranges_pub_;
+  shared_ptr<VelocitySource> velocity_source_;
+  shared_ptr<SectorMinima> sector_minima_;
+  ScanDeskewer deskewer_;
+  LaserScan laserscan_msg_;
+  RawScan raw_scan_msg_;
+  PointCloud2 cloud_msg_;
+  SectorRanges sector_ranges_msg_;
+};
+
+/**
+ * Service to write out the flight recorder on demand. Service callbacks run on
+ * the acquisition thread, between scans, as the recorder requires.
+ */
+class FlightRecorderService
+{
+public:
+  FlightRecorderService(FlightRecorder* recorder) : recorder_(recorder)
+  {
+  }
+
+  bool callback(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res)
+  {
+    try
+    {
+      res.message = recorder_->dump();
+      res.success = true;
+    }
+    catch (std::runtime_error& ex)
+    {
+      res.message = ex.what();
+      res.success = false;
+    }
+    return true;
+  }
+
+private:
+  FlightRecorder* recorder_;
+};
 
 int main(int argc, char* argv[])
 {
@@ -56,30 +685,186 @@ int main(int argc, char* argv[])
   ros::NodeHandle nh;
 
   // get sensor config from params
-  string host, frame_id, local_ip;
+  string host, frame_id, local_ip, shm_name, config_cache_file;
   double start_angle, end_angle, expected_frequency, frequency_tolerance, timestamp_min_acceptable,
-      timestamp_max_acceptable, frequency, reconnect_timeout;
+      timestamp_max_acceptable, frequency, reconnect_timeout, stall_missed_scans, stall_min_timeout, connect_timeout,
+      request_timeout;
   bool publish_intensities;
+  bool range_only;
+  bool publish_raw_scan;
   bool invert_scan;
+  bool deskew;
+  RealtimeSettings realtime_settings;
+  int beam_decimation;
+  int median_window;
+  double filter_min_range, filter_max_range, shadow_angle;
+  double flight_recorder_duration, flight_recorder_post_trigger;
+  int flight_recorder_max_files;
+  std::string flight_recorder_directory;
   ros::param::param<std::string>("~host", host, "192.168.1.1");
   ros::param::param<std::string>("~local_ip", local_ip, "0.0.0.0");
   ros::param::param<std::string>("~frame_id", frame_id, "laser");
   ros::param::param<double>("~start_angle", start_angle, OS32C::ANGLE_MAX);
   ros::param::param<double>("~end_angle", end_angle, OS32C::ANGLE_MIN);
+  // Without an explicit frequency, acquisition and the expected frequency follow
+  // the scan rate the sensor reports
+  bool auto_frequency = !ros::param::has("~frequency");
   ros::param::param<double>("~frequency", frequency, 12.856);
   ros::param::param<double>("~expected_frequency", expected_frequency, frequency);
   ros::param::param<double>("~frequency_tolerance", frequency_tolerance, 0.1);
   ros::param::param<double>("~timestamp_min_acceptable", timestamp_min_acceptable, -1);
   ros::param::param<double>("~timestamp_max_acceptable", timestamp_max_acceptable, -1);
   ros::param::param<double>("~reconnect_timeout", reconnect_timeout, 2.0);
+  ros::param::param<double>("~stall_missed_scans", stall_missed_scans, 3.0);
+  ros::param::param<double>("~stall_min_timeout", stall_min_timeout, 0.1);
+  // Limits on connecting and on each request, so that a silent sensor cannot block the node
+  ros::param::param<double>("~connect_timeout", connect_timeout, 1.0);
+  ros::param::param<double>("~request_timeout", request_timeout, 1.0);
   ros::param::param<bool>("~publish_intensities", publish_intensities, false);
+  // Request reports without reflectivity, which halves the beam data sent. This
+  // also leaves it out of the flight recorder and shared memory.
+  ros::param::param<bool>("~range_only", range_only, false);
+  if (range_only && publish_intensities)
+  {
+    ROS_WARN("Both range_only and publish_intensities are set, intensities will not be published");
+  }
+  ros::param::param<bool>("~publish_raw_scan", publish_raw_scan, false);
   ros::param::param<bool>("~invert_scan", invert_scan, false);
+  ros::param::param<bool>("~deskew", deskew, false);
+  ros::param::param<int>("~beam_decimation", beam_decimation, 1);
+  ros::param::param<int>("~median_window", median_window, 1);
+  // Keeps the configuration applied to the sensor across restarts, so that a
+  // sensor that still has it is not read back and written on connect
+  ros::param::param<std::string>("~config_cache_file", config_cache_file, "");
+  ros::param::param<double>("~filter_min_range", filter_min_range, 0);
+  ros::param::param<double>("~filter_max_range", filter_max_range, 0);
+  ros::param::param<double>("~shadow_angle", shadow_angle, 0);
+  ros::param::param<double>("~flight_recorder_duration", flight_recorder_duration, 10.0);
+  ros::param::param<double>("~flight_recorder_post_trigger", flight_recorder_post_trigger, 2.0);
+  ros::param::param<std::string>("~flight_recorder_directory", flight_recorder_directory,
+                                 ros::file_log::getLogDirectory());
+  ros::param::param<int>("~flight_recorder_max_files", flight_recorder_max_files, 10);
+  ros::param::param<std::string>("~shm_name", shm_name, "");
+  ros::param::param<int>("~rt_priority", realtime_settings.priority, 0);
+  ros::param::get("~cpu_affinity", realtime_settings.cpus);
+  ros::param::param<bool>("~lock_memory", realtime_settings.lock_memory, false);
+
+  // Beams to measure. Defaults to the single sector from start_angle to end_angle,
+  // but any number of sectors can be given, with sectors to exclude on top.
+  SensorConfig config;
+  config.range_format = RANGE_MEASURE_50M;
+  config.reflectivity_format = range_only ? NO_TOT_MEASUREMENTS : REFLECTIVITY_MEASURE_TOT_4PS;
+  BeamSelection& beam_selection = config.beam_selection;
+  try
+  {
+    vector<std::pair<double, double> > sectors, excluded_sectors;
+    if (!getSectorsParam("~sectors", &sectors))
+    {
+      sectors.push_back(std::make_pair(start_angle, end_angle));
+    }
+    getSectorsParam("~excluded_sectors", &excluded_sectors);
+    for (size_t i = 0; i < sectors.size(); ++i)
+    {
+      beam_selection.addSector(sectors[i].first, sectors[i].second);
+    }
+    for (size_t i = 0; i < excluded_sectors.size(); ++i)
+    {
+      beam_selection.excludeSector(excluded_sectors[i].first, excluded_sectors[i].second);
+    }
+    beam_selection.setDecimation(beam_decimation);
+  }
+  catch (std::invalid_argument& ex)
+  {
+    ROS_FATAL("Invalid beam selection: %s", ex.what());
+    return -1;
+  }
+
+  // optional per-beam median over the last few scans, to drop noisy beams and spikes
+  shared_ptr<TemporalMedianFilter> median_filter;
+  if (median_window > 1)
+  {
+    try
+    {
+      median_filter = shared_ptr<TemporalMedianFilter>(new TemporalMedianFilter(median_window));
+    }
+    catch (std::invalid_argument& ex)
+    {
+      ROS_FATAL("Invalid median_window: %s", ex.what());
+      return -1;
+    }
+  }
+
+  // optional range clipping, self masking and shadow removal on the raw ranges
+  shared_ptr<ScanFilterChain> filter_chain(new ScanFilterChain());
+  try
+  {
+    if (filter_min_range > 0 || filter_max_range > 0)
+    {
+      filter_chain->setRangeLimits(filter_min_range,
+                                   filter_max_range > 0 ? filter_max_range : std::numeric_limits<double>::infinity());
+    }
+    getSelfMaskParam("~self_mask", filter_chain.get());
+    filter_chain->setShadowAngle(shadow_angle);
+  }
+  catch (std::invalid_argument& ex)
+  {
+    ROS_FATAL("Invalid scan filter: %s", ex.what());
+    return -1;
+  }
+
+  // optional nearest return in a few sectors, for controllers that need no more than that
+  shared_ptr<SectorMinima> sector_minima;
+  try
+  {
+    vector<std::pair<double, double> > nearest_sectors;
+    if (getSectorsParam("~nearest_sectors", &nearest_sectors))
+    {
+      sector_minima = shared_ptr<SectorMinima>(new SectorMinima());
+      for (size_t i = 0; i < nearest_sectors.size(); ++i)
+      {
+        sector_minima->addSector(nearest_sectors[i].first, nearest_sectors[i].second);
+      }
+    }
+  }
+  catch (std::invalid_argument& ex)
+  {
+    ROS_FATAL("Invalid nearest_sectors: %s", ex.what());
+    return -1;
+  }
 
   // publisher for laserscans
   ros::Publisher laserscan_pub = nh.advertise<LaserScan>("scan", 1);
 
+  // service to change the configuration without reconnecting
+  ConfigureService configure_service(&config);
+  ros::ServiceServer configure_server =
+      nh.advertiseService("~configure", &ConfigureService::callback, &configure_service);
+
+  // optional motion compensated point cloud, using odometry for the sensor velocity
+  ros::Publisher cloud_pub;
+  ros::Subscriber odom_sub;
+  shared_ptr<VelocitySource> velocity_source;
+  if (deskew)
+  {
+    velocity_source = shared_ptr<VelocitySource>(new VelocitySource(frame_id));
+    cloud_pub = nh.advertise<PointCloud2>("cloud", 1);
+    odom_sub = nh.subscribe("odom", 1, &VelocitySource::odomCallback, velocity_source.get());
+  }
+
+  // optional compact scan in sensor units, for consumers on slow links
+  ros::Publisher raw_scan_pub;
+  if (publish_raw_scan)
+  {
+    raw_scan_pub = nh.advertise<RawScan>("scan_raw", 1);
+  }
+  ros::Publisher sector_ranges_pub;
+  if (sector_minima)
+  {
+    sector_ranges_pub = nh.advertise<SectorRanges>("sector_ranges", 1);
+  }
+
   // Validate frequency parameters
-  if (frequency > 25)
+  if (frequency > MAX_FREQUENCY)
   {
     ROS_FATAL("Frequency exceeds the limit of 25hz.");
     return -1;
@@ -105,68 +890,235 @@ int main(int argc, char* argv[])
       laserscan_pub, updater, FrequencyStatusParam(&expected_frequency, &expected_frequency, frequency_tolerance),
       TimeStampStatusParam(timestamp_min_acceptable, timestamp_max_acceptable));
 
-  while (ros::ok())
+  // The sockets, session and message buffers live for the whole run. Reconnecting
+  // only opens a new session on the same socket objects and reapplies the config.
+  boost::asio::io_service io_service;
+  shared_ptr<TimeoutTCPSocket> socket;
+  try
+  {
+    socket = shared_ptr<TimeoutTCPSocket>(new TimeoutTCPSocket(connect_timeout, request_timeout));
+  }
+  catch (std::invalid_argument& ex)
   {
-    boost::asio::io_service io_service;
-    shared_ptr<TCPSocket> socket = shared_ptr<TCPSocket>(new TCPSocket(io_service));
-    shared_ptr<UDPSocket> io_socket = shared_ptr<UDPSocket>(new UDPSocket(io_service, 2222, local_ip));
-    OS32C os32c(socket, io_socket);
+    ROS_FATAL("Invalid connection timeouts: %s", ex.what());
+    return -1;
+  }
+  shared_ptr<UDPSocket> io_socket = shared_ptr<UDPSocket>(new UDPSocket(io_service, 2222, local_ip));
+  OS32C os32c(socket, io_socket);
+  // Configuration applied by a previous run, to skip reading it back on a cold start
+  ConfigCache saved_cache;
+  if (!config_cache_file.empty() && loadConfigCache(config_cache_file, &saved_cache))
+  {
+    os32c.setConfigCache(saved_cache);
+  }
+
+  // Acquisition delivers each scan to the observers on this thread
+  ScanAcquisition acquisition(&os32c);
+  acquisition.setMedianFilter(median_filter);
+  acquisition.setFilterChain(filter_chain);
+  ScanPublisher scan_publisher(frame_id, publish_intensities, invert_scan, &diagnosed_publisher);
+  if (publish_raw_scan)
+  {
+    scan_publisher.setRawScanPublisher(raw_scan_pub);
+  }
+  if (deskew)
+  {
+    scan_publisher.setCloudPublisher(cloud_pub, velocity_source);
+  }
+  if (sector_minima)
+  {
+    scan_publisher.setSectorRangesPublisher(sector_ranges_pub, sector_minima);
+  }
 
+  // Recorder of the last few seconds of scans, written out on a change of the
+  // machine stop reasons or detection zones, or on request. The durations are
+  // converted to scans at the highest scan rate, as the rate of the sensor is
+  // only known once it reports, so slower sensors keep proportionally longer.
+  // Only the newest files are kept in the directory.
+  shared_ptr<FlightRecorder> flight_recorder;
+  ros::ServiceServer flight_recorder_server;
+  shared_ptr<FlightRecorderService> flight_recorder_service;
+  if (flight_recorder_duration > 0)
+  {
     try
     {
-      os32c.open(host);
+      flight_recorder = shared_ptr<FlightRecorder>(new FlightRecorder(
+          ceil(flight_recorder_duration * MAX_FREQUENCY), ceil(flight_recorder_post_trigger * MAX_FREQUENCY),
+          flight_recorder_directory, std::max(flight_recorder_max_files, 0)));
     }
-    catch (std::runtime_error ex)
+    catch (std::exception& ex)
     {
-      ROS_ERROR("Exception caught opening session: %s. Reconnecting in %.2f seconds ...", ex.what(), reconnect_timeout);
-      ros::Duration(reconnect_timeout).sleep();
-      continue;
+      ROS_FATAL("Unable to start flight recorder: %s", ex.what());
+      return -1;
+    }
+    acquisition.addRawObserver(flight_recorder.get());
+    flight_recorder_service = shared_ptr<FlightRecorderService>(new FlightRecorderService(flight_recorder.get()));
+    flight_recorder_server = nh.advertiseService("~dump_flight_recorder", &FlightRecorderService::callback,
+                                                 flight_recorder_service.get());
+  }
+
+  // optional ring of scans in shared memory, for other processes on this host.
+  // Written ahead of the ROS messages so that local readers get scans first.
+  shared_ptr<ShmScanWriter> shm_writer;
+  if (!shm_name.empty())
+  {
+    try
+    {
+      shm_writer = shared_ptr<ShmScanWriter>(new ShmScanWriter(shm_name));
+    }
+    catch (std::exception& ex)
+    {
+      ROS_FATAL("Cannot publish scans to shared memory: %s", ex.what());
+      return -1;
     }
+    acquisition.addRawObserver(shm_writer.get());
+  }
+  acquisition.addObserver(&scan_publisher);
+
+  // This thread runs the acquisition loop, so the real-time settings go here,
+  // after everything above is allocated so that mlockall() covers it too.
+  RealtimeStatus realtime_status;
+  try
+  {
+    realtime_status = applyRealtimeSettings(realtime_settings);
+  }
+  catch (std::invalid_argument& ex)
+  {
+    ROS_FATAL("Invalid real-time settings: %s", ex.what());
+    return -1;
+  }
+  for (size_t i = 0; i < realtime_status.errors.size(); ++i)
+  {
+    ROS_WARN("%s, continuing without it", realtime_status.errors[i].c_str());
+  }
+  prefaultStack(PREFAULT_STACK_SIZE);
+  RealtimeDiagnostics realtime_diagnostics(realtime_settings, realtime_status);
+  updater.add("Real-time", &realtime_diagnostics, &RealtimeDiagnostics::produceDiagnostics);
+
+  ScanRateMonitor rate_monitor;
+  double sensor_frequency = 0;
+
+  ReconnectBackoff backoff(std::min(RECONNECT_INITIAL_DELAY, reconnect_timeout), reconnect_timeout);
+  ConnectionDiagnostics connection_diagnostics;
+  // Scans are taken as stopped after a few scan periods, up to reconnect_timeout
+  shared_ptr<StallDetector> stall_detector;
+  try
+  {
+    stall_detector = shared_ptr<StallDetector>(
+        new StallDetector(stall_missed_scans, std::min(stall_min_timeout, reconnect_timeout), reconnect_timeout));
+  }
+  catch (std::invalid_argument& ex)
+  {
+    ROS_FATAL("Invalid stall detection parameters: %s", ex.what());
+    return -1;
+  }
+  updater.add("Connection", &connection_diagnostics, &ConnectionDiagnostics::produceDiagnostics);
+  ReportDiagnostics report_diagnostics(&os32c);
+  updater.add("Reports", &report_diagnostics, &ReportDiagnostics::produceDiagnostics);
+  ros::WallTime outage_start = ros::WallTime::now();
+
+  while (ros::ok())
+  {
+    ros::WallDuration(backoff.getDelay()).sleep();
+    updater.update();
+    ros::spinOnce();
 
     try
     {
-      os32c.setRangeFormat(RANGE_MEASURE_50M);
-      os32c.setReflectivityFormat(REFLECTIVITY_MEASURE_TOT_4PS);
-      os32c.selectBeams(start_angle, end_angle);
+      socket->close();
+      os32c.open(host);
+      int writes = os32c.applyConfiguration(config.range_format, config.reflectivity_format, config.beam_selection);
+      ROS_DEBUG("Sensor configured with %d attribute writes", writes);
     }
     catch (std::invalid_argument ex)
     {
+      backoff.failed();
       ROS_ERROR("Invalid arguments in sensor configuration: %s. Reconnecting in %.2f seconds ...", ex.what(),
-                reconnect_timeout);
-      ros::Duration(reconnect_timeout).sleep();
+                backoff.getDelay());
+      continue;
+    }
+    catch (std::runtime_error ex)
+    {
+      backoff.failed();
+      ROS_ERROR("Exception caught opening session: %s. Reconnecting in %.2f seconds ...", ex.what(),
+                backoff.getDelay());
       continue;
     }
 
-    sensor_msgs::LaserScan laserscan_msg;
-    os32c.fillLaserScanStaticConfig(&laserscan_msg);
-    laserscan_msg.header.frame_id = frame_id;
+    configure_service.setSensor(&os32c);
+    acquisition.reset();
+    if (flight_recorder)
+    {
+      flight_recorder->reset();
+    }
+    ros::WallTime last_scan = ros::WallTime::now();
+    stall_detector->reset(last_scan.toSec());
+    rate_monitor.reset();
+    bool recovering = true;
 
     while (ros::ok())
     {
+      // The request for the next scan must not wait past the stall deadline, so that
+      // a sensor that goes silent is reconnected rather than blocking the loop
+      double poll_timeout = stall_detector->getTimeRemaining(ros::WallTime::now().toSec());
+      if (request_timeout > 0)
+      {
+        poll_timeout = std::min(poll_timeout, request_timeout);
+      }
+      socket->setRequestTimeout(std::max(poll_timeout, MIN_REQUEST_TIMEOUT));
       try
       {
-        // Poll ranges and reflectivity
-        RangeAndReflectanceMeasurement report = os32c.getSingleRRScan();
-
-        // Invert range measurements if z-axis is needed to point upwards.
-        if (invert_scan)
+        // Poll ranges and reflectivity, which publishes the scan. Malformed reports are
+        // only counted, for the diagnostics, so that a burst of them stays cheap.
+        if (acquisition.tryPoll() == REPORT_OK)
         {
-          reverse(report.range_data);
-        }
+          const RangeAndReflectanceMeasurement& report = acquisition.getReport();
 
-        OS32C::convertToLaserScan(report, &laserscan_msg);
+          // Take the rate from the first header after connecting, and watch for changes
+          if (rate_monitor.update(report.header.scan_rate))
+          {
+            if (sensor_frequency > 0 && fabs(rate_monitor.getFrequency() - sensor_frequency) > EPS)
+            {
+              ROS_WARN("Sensor scan rate changed from %.3f Hz to %.3f Hz", sensor_frequency,
+                       rate_monitor.getFrequency());
+            }
+            sensor_frequency = rate_monitor.getFrequency();
+            if (auto_frequency && fabs(std::min(sensor_frequency, MAX_FREQUENCY) - frequency) > EPS)
+            {
+              frequency = std::min(sensor_frequency, MAX_FREQUENCY);
+              expected_frequency = frequency;
+              loop_rate = ros::Rate(frequency);
+              ROS_INFO("Acquiring at the sensor scan rate of %.3f Hz", frequency);
+            }
+            else if (!auto_frequency && fabs(sensor_frequency - frequency) > EPS)
+            {
+              ROS_WARN_ONCE("Frequency parameter of %.3f Hz does not match the sensor scan rate of %.3f Hz", frequency,
+                            sensor_frequency);
+            }
+          }
 
-        // In earlier versions reflectivity was not received. So to be backwards
-        // compatible clear reflectivity from msg.
-        if (!publish_intensities)
-        {
-          laserscan_msg.intensities.clear();
-        }
+          // Reapply the configuration if something else changed it
+          if (!os32c.checkConfigChecksum(report.header))
+          {
+            ROS_WARN("Sensor configuration changed outside of the driver, reapplying");
+            socket->setRequestTimeout(request_timeout);
+            os32c.applyConfiguration(config.range_format, config.reflectivity_format, config.beam_selection);
+          }
+          if (!config_cache_file.empty())
+          {
+            saveConfigCache(config_cache_file, os32c.getConfigCache(), &saved_cache);
+          }
 
-        // Stamp and publish message diagnosed
-        laserscan_msg.header.stamp = ros::Time::now();
-        laserscan_msg.header.seq++;
-        diagnosed_publisher.publish(laserscan_msg);
+          // The connection only counts as recovered once scans are flowing again
+          last_scan = ros::WallTime::now();
+          stall_detector->scanReceived(last_scan.toSec(), report.header.scan_rate / 1000000.0);
+          if (recovering)
+          {
+            connection_diagnostics.connected((last_scan - outage_start).toSec());
+            backoff.reset();
+            recovering = false;
+          }
+        }
 
         // Update diagnostics
         updater.update();
@@ -180,11 +1132,25 @@ int main(int argc, char* argv[])
         ROS_ERROR_STREAM("Problem parsing return data: " << ex.what());
       }
 
-      if (!laserscan_msg.header.stamp.isZero() &&
-          (ros::Time::now() - laserscan_msg.header.stamp).toSec() > reconnect_timeout)
+      socket->setRequestTimeout(request_timeout);
+
+      ros::WallTime now = ros::WallTime::now();
+      if (stall_detector->isStalled(now.toSec()))
       {
-        ROS_ERROR("No scan received for %.2f seconds, reconnecting ...", reconnect_timeout);
-        laserscan_msg.header.stamp = ros::Time();
+        double latency = (now - last_scan).toSec();
+        ROS_ERROR("No scan received for %.3f seconds (deadline %.3f), reconnecting ...", latency,
+                  stall_detector->getDeadline());
+        // Retry immediately after losing a working connection, but back off if
+        // the last attempt connected without ever delivering a scan.
+        if (recovering)
+        {
+          backoff.failed();
+        }
+        else
+        {
+          outage_start = last_scan;
+        }
+        connection_diagnostics.disconnected(latency);
         break;
       }
 
@@ -194,6 +1160,7 @@ int main(int argc, char* argv[])
       loop_rate.sleep();
     }
 
+    configure_service.setSensor(NULL);
     if (!ros::ok())
     {
       os32c.closeActiveConnection();
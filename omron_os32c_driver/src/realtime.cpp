@@ -0,0 +1,127 @@
+/**
+Software License Agreement (BSD)
+
+\file      realtime.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "omron_os32c_driver/realtime.h"
+
+namespace omron_os32c_driver {
+
+static string errorMessage(const string& what, int error)
+{
+  return what + ": " + strerror(error);
+}
+
+RealtimeStatus applyRealtimeSettings(const RealtimeSettings& settings)
+{
+  RealtimeStatus status;
+  pthread_t thread = pthread_self();
+
+  if (settings.priority != 0)
+  {
+    int min_priority = sched_get_priority_min(SCHED_FIFO);
+    int max_priority = sched_get_priority_max(SCHED_FIFO);
+    if (settings.priority < min_priority || settings.priority > max_priority)
+    {
+      throw std::invalid_argument("Real-time priority out of range");
+    }
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = settings.priority;
+    int result = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if (result)
+    {
+      status.errors.push_back(errorMessage("Cannot set SCHED_FIFO priority", result));
+    }
+  }
+
+  cpu_set_t cpus;
+  if (!settings.cpus.empty())
+  {
+    CPU_ZERO(&cpus);
+    for (size_t i = 0; i < settings.cpus.size(); ++i)
+    {
+      if (settings.cpus[i] < 0 || settings.cpus[i] >= CPU_SETSIZE)
+      {
+        throw std::invalid_argument("CPU number out of range");
+      }
+      CPU_SET(settings.cpus[i], &cpus);
+    }
+    int result = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+    if (result)
+    {
+      status.errors.push_back(errorMessage("Cannot set CPU affinity", result));
+    }
+  }
+
+  if (settings.lock_memory)
+  {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE))
+    {
+      status.errors.push_back(errorMessage("Cannot lock memory", errno));
+    }
+    else
+    {
+      status.lock_memory = true;
+    }
+  }
+
+  // report what is actually in effect rather than what was asked for
+  int policy;
+  sched_param param;
+  if (!pthread_getschedparam(thread, &policy, &param) && policy == SCHED_FIFO)
+  {
+    status.priority = param.sched_priority;
+  }
+  if (!pthread_getaffinity_np(thread, sizeof(cpus), &cpus))
+  {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET(cpu, &cpus))
+      {
+        status.cpus.push_back(cpu);
+      }
+    }
+  }
+  return status;
+}
+
+void prefaultStack(size_t size)
+{
+  // volatile so that the writes are not optimized away
+  volatile char* stack = static_cast<volatile char*>(alloca(size));
+  for (size_t i = 0; i < size; i += 4096)
+  {
+    stack[i] = 0;
+  }
+}
+
+}  // namespace omron_os32c_driver
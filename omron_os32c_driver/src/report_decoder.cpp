@@ -0,0 +1,234 @@
+/**
+Software License Agreement (BSD)
+
+\file      report_decoder.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <cstring>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/report_decoder.h"
+
+using eip::serialization::BufferReader;
+
+namespace omron_os32c_driver {
+
+static const size_t HEADER_LENGTH = 56;
+
+/**
+ * Decode the header and check the number of beams against what a report can hold
+ */
+static ReportStatus decodeHeader(const ReportBuffer& report, MeasurementReportHeader* header)
+{
+  if (report.isOverflowed())
+  {
+    return REPORT_TOO_LONG;
+  }
+  if (report.getLength() < HEADER_LENGTH)
+  {
+    return REPORT_TOO_SHORT;
+  }
+  BufferReader reader(boost::asio::buffer(report.getData(), HEADER_LENGTH));
+  header->deserialize(reader);
+  if (header->num_beams > BeamSelection::NUM_BEAMS)
+  {
+    return REPORT_TOO_MANY_BEAMS;
+  }
+  return REPORT_OK;
+}
+
+/**
+ * Check the length of a report against the number of beams in its header and
+ * the number of values sent per beam
+ */
+static ReportStatus checkLength(const ReportBuffer& report, const MeasurementReportHeader& header,
+                                size_t values_per_beam)
+{
+  size_t expected = HEADER_LENGTH + header.num_beams * values_per_beam * sizeof(EIP_UINT);
+  if (report.getLength() < expected)
+  {
+    return REPORT_TOO_SHORT;
+  }
+  if (report.getLength() > expected)
+  {
+    return REPORT_TOO_LONG;
+  }
+  return REPORT_OK;
+}
+
+const char* getReportStatusName(ReportStatus status)
+{
+  switch (status)
+  {
+    case REPORT_OK:
+      return "OK";
+    case REPORT_NO_DATA:
+      return "No data";
+    case REPORT_TOO_SHORT:
+      return "Too short";
+    case REPORT_TOO_LONG:
+      return "Too long";
+    case REPORT_TOO_MANY_BEAMS:
+      return "Too many beams";
+    case REPORT_BAD_PACKET:
+      return "Bad packet";
+    case REPORT_DUPLICATE:
+      return "Duplicate";
+    case REPORT_STALE:
+      return "Stale";
+    case REPORT_WRONG_CONNECTION:
+      return "Wrong connection";
+    default:
+      return "Unknown";
+  }
+}
+
+ReportStatus decodeRangeAndReflectance(const ReportBuffer& report, RangeAndReflectanceMeasurement* rr)
+{
+  ReportStatus status = decodeHeader(report, &rr->header);
+  if (status != REPORT_OK)
+  {
+    return status;
+  }
+
+  // Without reflectivity measurements the sensor sends only the ranges, and the
+  // reflectance is left empty. Shrinking keeps the capacity for the next scan.
+  size_t num_beams = rr->header.num_beams;
+  bool with_reflectance = rr->header.refletivity_report_format != NO_TOT_MEASUREMENTS;
+  status = checkLength(report, rr->header, with_reflectance ? 2 : 1);
+  if (status != REPORT_OK)
+  {
+    return status;
+  }
+  rr->range_data.resize(num_beams);
+  rr->reflectance_data.resize(with_reflectance ? num_beams : 0);
+  if (num_beams > 0)
+  {
+    const EIP_BYTE* data = report.getData() + HEADER_LENGTH;
+    memcpy(&rr->range_data[0], data, num_beams * sizeof(EIP_UINT));
+    if (with_reflectance)
+    {
+      memcpy(&rr->reflectance_data[0], data + num_beams * sizeof(EIP_UINT), num_beams * sizeof(EIP_UINT));
+    }
+  }
+  return REPORT_OK;
+}
+
+ReportStatus decodeMeasurementReport(const ReportBuffer& report, MeasurementReport* mr)
+{
+  ReportStatus status = decodeHeader(report, &mr->header);
+  if (status != REPORT_OK)
+  {
+    return status;
+  }
+
+  // A report holds whatever of the requested measurements fits in the packet.
+  // With both requested, a reduced beam set gets the reflectance after the
+  // ranges, and otherwise only the ranges are sent. A report with only the
+  // reflectance requested holds the reflectance alone.
+  size_t num_beams = mr->header.num_beams;
+  bool with_ranges = mr->header.range_report_format != NO_TOF_MEASUREMENTS;
+  bool with_reflectance = mr->header.refletivity_report_format != NO_TOT_MEASUREMENTS;
+  if (with_ranges && with_reflectance)
+  {
+    with_reflectance = report.getLength() == HEADER_LENGTH + num_beams * 2 * sizeof(EIP_UINT);
+  }
+  with_ranges = with_ranges || !with_reflectance;
+  status = checkLength(report, mr->header, with_ranges && with_reflectance ? 2 : 1);
+  if (status != REPORT_OK)
+  {
+    return status;
+  }
+
+  const EIP_BYTE* data = report.getData() + HEADER_LENGTH;
+  mr->measurement_data.resize(with_ranges ? num_beams : 0);
+  mr->reflectance_data.resize(with_reflectance ? num_beams : 0);
+  if (!mr->measurement_data.empty())
+  {
+    memcpy(&mr->measurement_data[0], data, num_beams * sizeof(EIP_UINT));
+    data += num_beams * sizeof(EIP_UINT);
+  }
+  if (!mr->reflectance_data.empty())
+  {
+    memcpy(&mr->reflectance_data[0], data, num_beams * sizeof(EIP_UINT));
+  }
+  return REPORT_OK;
+}
+
+ReportStatus SequenceTracker::check(EIP_UDINT sequence)
+{
+  // modular difference, so that the count wrapping around still moves forward
+  EIP_UDINT behind = last_ - sequence;
+  if (valid_ && sequence == last_)
+  {
+    return REPORT_DUPLICATE;
+  }
+  if (valid_ && behind <= MAX_REORDER)
+  {
+    return REPORT_STALE;
+  }
+  valid_ = true;
+  last_ = sequence;
+  return REPORT_OK;
+}
+
+ReportAssembler::ReportAssembler() : dropped_(0)
+{
+  // reserve a full scan up front, so that adding reports does not allocate
+  scan_.range_data.reserve(BeamSelection::NUM_BEAMS);
+  scan_.reflectance_data.reserve(BeamSelection::NUM_BEAMS);
+}
+
+bool ReportAssembler::add(const MeasurementReport& report)
+{
+  if (report.measurement_data.empty() && !report.reflectance_data.empty())
+  {
+    ++dropped_;
+    return false;
+  }
+  scan_.header = report.header;
+  scan_.range_data.assign(report.measurement_data.begin(), report.measurement_data.end());
+  scan_.reflectance_data.assign(report.reflectance_data.begin(), report.reflectance_data.end());
+  return true;
+}
+
+boost::uint64_t ReportCounters::getErrors() const
+{
+  boost::uint64_t errors = 0;
+  for (int i = REPORT_OK + 1; i < NUM_REPORT_STATUSES; ++i)
+  {
+    errors += counts_[i];
+  }
+  return errors;
+}
+
+void ReportCounters::reset()
+{
+  for (int i = 0; i < NUM_REPORT_STATUSES; ++i)
+  {
+    counts_[i] = 0;
+  }
+}
+
+}  // namespace omron_os32c_driver
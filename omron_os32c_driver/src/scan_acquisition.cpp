@@ -0,0 +1,135 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_acquisition.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "omron_os32c_driver/scan_acquisition.h"
+
+namespace omron_os32c_driver {
+
+ScanAcquisition::ScanAcquisition(OS32C* os32c) : os32c_(os32c), selection_changed_(true)
+{
+  // touch the buffers for a full scan now, so that polling does not page fault
+  report_.range_data.assign(BeamSelection::NUM_BEAMS, 0);
+  report_.reflectance_data.assign(BeamSelection::NUM_BEAMS, 0);
+  spare_report_.range_data.assign(BeamSelection::NUM_BEAMS, 0);
+  spare_report_.reflectance_data.assign(BeamSelection::NUM_BEAMS, 0);
+}
+
+void ScanAcquisition::addObserver(ScanObserver* observer)
+{
+  observers_.push_back(observer);
+}
+
+void ScanAcquisition::removeObserver(ScanObserver* observer)
+{
+  observers_.erase(std::remove(observers_.begin(), observers_.end(), observer), observers_.end());
+}
+
+void ScanAcquisition::addRawObserver(ScanObserver* observer)
+{
+  raw_observers_.push_back(observer);
+}
+
+void ScanAcquisition::removeRawObserver(ScanObserver* observer)
+{
+  raw_observers_.erase(std::remove(raw_observers_.begin(), raw_observers_.end(), observer), raw_observers_.end());
+}
+
+void ScanAcquisition::reset()
+{
+  if (median_filter_)
+  {
+    median_filter_->reset();
+  }
+  selection_changed_ = true;
+}
+
+const RangeAndReflectanceMeasurement& ScanAcquisition::poll()
+{
+  ReportStatus status = tryPoll();
+  if (status != REPORT_OK)
+  {
+    throw std::logic_error(string("Range and reflectance report not decoded: ") + getReportStatusName(status));
+  }
+  return report_;
+}
+
+ReportStatus ScanAcquisition::tryPoll()
+{
+  // decode into a spare measurement, so that a bad report leaves the last scan intact
+  ReportStatus status = os32c_->tryGetSingleRRScan(spare_report_);
+  if (status != REPORT_OK)
+  {
+    return status;
+  }
+  report_.header = spare_report_.header;
+  report_.range_data.swap(spare_report_.range_data);
+  report_.reflectance_data.swap(spare_report_.reflectance_data);
+
+  // Angles switch over with the first scan that uses a new beam selection. The
+  // median history is of other beams then, even if the number of beams is the same.
+  if (os32c_->updateReportSelection(report_.header.num_beams))
+  {
+    selection_changed_ = true;
+    if (median_filter_)
+    {
+      median_filter_->reset();
+    }
+    if (filter_chain_ && filter_chain_->isEnabled())
+    {
+      filter_chain_->configure(os32c_->getReportSelection());
+    }
+  }
+
+  // the filters work in place, so the raw observers have to be done with the scan first
+  ScanView raw_scan(report_, &os32c_->getReportSelection(), selection_changed_);
+  for (size_t i = 0; i < raw_observers_.size(); ++i)
+  {
+    raw_observers_[i]->scanReceived(raw_scan);
+  }
+
+  if (median_filter_)
+  {
+    median_filter_->filter(report_.range_data);
+  }
+
+  // Scans from before the first selection switch are left unfiltered
+  if (filter_chain_ && filter_chain_->isEnabled() && filter_chain_->getNumBeams() == report_.range_data.size())
+  {
+    filter_chain_->filter(report_.range_data);
+  }
+
+  ScanView scan(report_, &os32c_->getReportSelection(), selection_changed_);
+  selection_changed_ = false;
+  for (size_t i = 0; i < observers_.size(); ++i)
+  {
+    observers_[i]->scanReceived(scan);
+  }
+  return REPORT_OK;
+}
+
+}  // namespace omron_os32c_driver
@@ -0,0 +1,215 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_codec.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdexcept>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/scan_codec.h"
+
+namespace omron_os32c_driver {
+
+static const EIP_BYTE BLOCK_KEYFRAME = 1;
+static const EIP_BYTE BLOCK_REFLECTANCE = 2;
+
+/// Largest varint of a zigzag mapped difference of two 16 bit values
+static const size_t MAX_VALUE_BYTES = 3;
+/// Flags byte and the varint number of beams
+static const size_t MAX_PREFIX_BYTES = 1 + 5;
+
+static inline EIP_UDINT zigzag(int diff)
+{
+  return (static_cast<EIP_UDINT>(diff) << 1) ^ static_cast<EIP_UDINT>(diff >> 31);
+}
+
+static inline int unzigzag(EIP_UDINT value)
+{
+  return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+static inline EIP_BYTE* putVarint(EIP_UDINT value, EIP_BYTE* out)
+{
+  while (value >= 0x80)
+  {
+    *out++ = static_cast<EIP_BYTE>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<EIP_BYTE>(value);
+  return out;
+}
+
+static inline const EIP_BYTE* getVarint(const EIP_BYTE* data, const EIP_BYTE* end, EIP_UDINT* value)
+{
+  EIP_UDINT result = 0;
+  for (int shift = 0; shift < 35 && data < end; shift += 7)
+  {
+    EIP_BYTE byte = *data++;
+    result |= static_cast<EIP_UDINT>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+    {
+      *value = result;
+      return data;
+    }
+  }
+  throw std::runtime_error("Truncated or malformed scan block");
+}
+
+static EIP_BYTE* encodeValues(const EIP_UINT* values, EIP_UINT* previous, size_t num_beams, bool keyframe,
+                              EIP_BYTE* out)
+{
+  if (keyframe)
+  {
+    int last = 0;
+    for (size_t i = 0; i < num_beams; ++i)
+    {
+      out = putVarint(zigzag(values[i] - last), out);
+      last = values[i];
+      previous[i] = values[i];
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < num_beams; ++i)
+    {
+      out = putVarint(zigzag(values[i] - previous[i]), out);
+      previous[i] = values[i];
+    }
+  }
+  return out;
+}
+
+static const EIP_BYTE* decodeValues(const EIP_BYTE* data, const EIP_BYTE* end, bool keyframe, EIP_UINT* values,
+                                    size_t num_beams)
+{
+  EIP_UDINT value;
+  if (keyframe)
+  {
+    int last = 0;
+    for (size_t i = 0; i < num_beams; ++i)
+    {
+      data = getVarint(data, end, &value);
+      last += unzigzag(value);
+      values[i] = static_cast<EIP_UINT>(last);
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < num_beams; ++i)
+    {
+      data = getVarint(data, end, &value);
+      values[i] = static_cast<EIP_UINT>(values[i] + unzigzag(value));
+    }
+  }
+  return data;
+}
+
+ScanEncoder::ScanEncoder(size_t keyframe_interval)
+  : keyframe_interval_(keyframe_interval), since_keyframe_(keyframe_interval), has_reflectance_(false)
+{
+  if (keyframe_interval == 0)
+  {
+    throw std::invalid_argument("Keyframe interval must be at least one scan");
+  }
+}
+
+bool ScanEncoder::encode(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams,
+                         vector<EIP_BYTE>* out)
+{
+  bool keyframe = since_keyframe_ >= keyframe_interval_ || num_beams != ranges_.size() ||
+                  (reflectance != NULL) != has_reflectance_;
+  since_keyframe_ = keyframe ? 1 : since_keyframe_ + 1;
+  has_reflectance_ = reflectance != NULL;
+  ranges_.resize(num_beams);
+  reflectance_.resize(reflectance ? num_beams : 0);
+
+  // reserve the worst case and write through a pointer, then trim to what was used
+  size_t start = out->size();
+  out->resize(start + MAX_PREFIX_BYTES + (reflectance ? 2 : 1) * num_beams * MAX_VALUE_BYTES);
+  EIP_BYTE* begin = &(*out)[start];
+  EIP_BYTE* p = begin;
+  *p++ = (keyframe ? BLOCK_KEYFRAME : 0) | (reflectance ? BLOCK_REFLECTANCE : 0);
+  p = putVarint(num_beams, p);
+  if (num_beams > 0)
+  {
+    p = encodeValues(ranges, &ranges_[0], num_beams, keyframe, p);
+    if (reflectance)
+    {
+      p = encodeValues(reflectance, &reflectance_[0], num_beams, keyframe, p);
+    }
+  }
+  out->resize(start + (p - begin));
+  return keyframe;
+}
+
+ScanDecoder::ScanDecoder() : valid_(false)
+{
+}
+
+bool ScanDecoder::isKeyframe(const EIP_BYTE* data)
+{
+  return data[0] & BLOCK_KEYFRAME;
+}
+
+size_t ScanDecoder::decode(const EIP_BYTE* data, size_t size)
+{
+  const EIP_BYTE* end = data + size;
+  if (size == 0)
+  {
+    throw std::runtime_error("Truncated or malformed scan block");
+  }
+  EIP_BYTE flags = data[0];
+  bool keyframe = flags & BLOCK_KEYFRAME;
+  bool has_reflectance = flags & BLOCK_REFLECTANCE;
+  EIP_UDINT num_beams;
+  const EIP_BYTE* p = getVarint(data + 1, end, &num_beams);
+  // no scan has more beams than the sensor, and every value takes at least a byte,
+  // which bounds what a corrupt block can allocate. Counted in size_t, as a
+  // corrupt number of beams would overflow an EIP_UDINT.
+  if (num_beams > static_cast<EIP_UDINT>(BeamSelection::NUM_BEAMS) ||
+      static_cast<size_t>(num_beams) * (has_reflectance ? 2 : 1) > static_cast<size_t>(end - p))
+  {
+    throw std::runtime_error("Truncated or malformed scan block");
+  }
+  if (!keyframe && (!valid_ || num_beams != ranges_.size() || has_reflectance != !reflectance_.empty()))
+  {
+    throw std::runtime_error("Scan block depends on a scan that was not decoded");
+  }
+
+  // a block that fails part way leaves the previous scan half overwritten
+  valid_ = false;
+  ranges_.resize(num_beams);
+  reflectance_.resize(has_reflectance ? num_beams : 0);
+  if (num_beams > 0)
+  {
+    p = decodeValues(p, end, keyframe, &ranges_[0], num_beams);
+    if (has_reflectance)
+    {
+      p = decodeValues(p, end, keyframe, &reflectance_[0], num_beams);
+    }
+  }
+  valid_ = true;
+  return p - data;
+}
+
+}  // namespace omron_os32c_driver
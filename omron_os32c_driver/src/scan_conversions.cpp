@@ -0,0 +1,225 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_conversions.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <algorithm>
+#include <limits>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_conversions.h"
+
+namespace omron_os32c_driver {
+
+void fillLaserScanStaticConfig(const BeamSelection& selection, sensor_msgs::LaserScan* ls)
+{
+  ls->angle_max = OS32C::calcBeamCentre(selection.getFirstBeam());
+  ls->angle_min = OS32C::calcBeamCentre(selection.getLastBeam());
+  ls->angle_increment = OS32C::ANGLE_INC * selection.getDecimation();
+  ls->range_min = OS32C::DISTANCE_MIN;
+  ls->range_max = OS32C::DISTANCE_MAX;
+}
+
+void convertToLaserScan(const ScanView& scan, sensor_msgs::LaserScan* ls)
+{
+  ls->time_increment = scan.getBeamPeriod();
+  ls->scan_time = scan.getScanPeriod();
+
+  // TODO: this currently makes assumptions of the report format. Should likely
+  // accomodate all of them, or at least anything reasonable.
+  const size_t num_beams = scan.getNumBeams();
+  const EIP_UINT* ranges = scan.getRanges();
+  ls->ranges.resize(num_beams);
+  for (size_t i = 0; i < num_beams; ++i)
+  {
+    if (ranges[i] == 0x0001)
+    {
+      // noisy beam detected
+      ls->ranges[i] = 0;
+    }
+    else if (ranges[i] == 0xFFFF)
+    {
+      // no return
+      ls->ranges[i] = OS32C::DISTANCE_MAX;
+    }
+    else
+    {
+      ls->ranges[i] = ranges[i] / 1000.0;
+    }
+  }
+
+  const EIP_UINT* reflectance = scan.getReflectance();
+  if (reflectance)
+  {
+    ls->intensities.assign(reflectance, reflectance + num_beams);
+  }
+  else
+  {
+    ls->intensities.clear();
+  }
+}
+
+void convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls)
+{
+  convertToLaserScan(ScanView(rr), ls);
+}
+
+void convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls)
+{
+  convertToLaserScan(ScanView(mr), ls);
+}
+
+void expandToBeamSelection(const BeamSelection& selection, sensor_msgs::LaserScan* ls)
+{
+  if (selection.isContiguous())
+  {
+    return;
+  }
+  selection.expand(ls->ranges, std::numeric_limits<float>::quiet_NaN());
+  if (!ls->intensities.empty())
+  {
+    selection.expand(ls->intensities, 0);
+  }
+}
+
+void fillRawScanStaticConfig(const BeamSelection& selection, RawScan* raw)
+{
+  raw->angle_max = OS32C::calcBeamCentre(selection.getFirstBeam());
+  raw->angle_min = OS32C::calcBeamCentre(selection.getLastBeam());
+  raw->angle_increment = OS32C::ANGLE_INC * selection.getDecimation();
+  raw->range_min = OS32C::DISTANCE_MIN;
+  raw->range_max = OS32C::DISTANCE_MAX;
+  raw->indices.clear();
+  if (!selection.isContiguous())
+  {
+    raw->indices.resize(selection.getNumBeams());
+    for (size_t i = 0; i < raw->indices.size(); ++i)
+    {
+      raw->indices[i] = selection.getSlot(i);
+    }
+  }
+}
+
+void convertToRawScan(const ScanView& scan, RawScan* raw)
+{
+  raw->time_increment = scan.getBeamPeriod();
+  raw->scan_time = scan.getScanPeriod();
+  raw->ranges.assign(scan.getRanges(), scan.getRanges() + scan.getNumBeams());
+  const EIP_UINT* reflectance = scan.getReflectance();
+  if (reflectance)
+  {
+    raw->intensities.assign(reflectance, reflectance + scan.getNumBeams());
+  }
+  else
+  {
+    raw->intensities.clear();
+  }
+}
+
+void invertLaserScan(sensor_msgs::LaserScan* ls)
+{
+  std::reverse(ls->ranges.begin(), ls->ranges.end());
+  std::reverse(ls->intensities.begin(), ls->intensities.end());
+}
+
+void invertRawScanStaticConfig(RawScan* raw)
+{
+  if (raw->indices.empty())
+  {
+    return;
+  }
+  EIP_UINT last = raw->indices.back();
+  std::reverse(raw->indices.begin(), raw->indices.end());
+  for (size_t i = 0; i < raw->indices.size(); ++i)
+  {
+    raw->indices[i] = last - raw->indices[i];
+  }
+}
+
+void invertRawScan(RawScan* raw)
+{
+  std::reverse(raw->ranges.begin(), raw->ranges.end());
+  std::reverse(raw->intensities.begin(), raw->intensities.end());
+}
+
+/**
+ * Angle of the beam at a slot of the selection in a LaserScan, which counts the
+ * slots from angle_min, or from the other end if the scan is inverted
+ */
+static float calcSlotAngle(const SectorMinima& minima, const sensor_msgs::LaserScan& ls, bool invert_scan, int slot)
+{
+  int index = invert_scan ? minima.getNumSlots() - 1 - slot : slot;
+  return ls.angle_min + index * ls.angle_increment;
+}
+
+void convertToSectorRanges(const SectorMinima& minima, const sensor_msgs::LaserScan& ls, bool invert_scan,
+                           SectorRanges* sectors)
+{
+  const size_t num_sectors = minima.getNumSectors();
+  sectors->start_angles.resize(num_sectors);
+  sectors->end_angles.resize(num_sectors);
+  sectors->ranges.resize(num_sectors);
+  sectors->angles.resize(num_sectors);
+  for (size_t i = 0; i < num_sectors; ++i)
+  {
+    sectors->angles[i] = std::numeric_limits<float>::quiet_NaN();
+    if (!minima.isMeasured(i))
+    {
+      sectors->start_angles[i] = std::numeric_limits<float>::quiet_NaN();
+      sectors->end_angles[i] = std::numeric_limits<float>::quiet_NaN();
+      sectors->ranges[i] = std::numeric_limits<float>::quiet_NaN();
+      continue;
+    }
+
+    float first = calcSlotAngle(minima, ls, invert_scan, minima.getFirstSlot(i));
+    float last = calcSlotAngle(minima, ls, invert_scan, minima.getLastSlot(i));
+    sectors->start_angles[i] = std::max(first, last);
+    sectors->end_angles[i] = std::min(first, last);
+    if (minima.getSlot(i) < 0)
+    {
+      sectors->ranges[i] = std::numeric_limits<float>::infinity();
+    }
+    else
+    {
+      sectors->ranges[i] = minima.getRange(i) / 1000.0;
+      sectors->angles[i] = calcSlotAngle(minima, ls, invert_scan, minima.getSlot(i));
+    }
+  }
+}
+
+void OS32C::fillLaserScanStaticConfig(sensor_msgs::LaserScan* ls)
+{
+  omron_os32c_driver::fillLaserScanStaticConfig(getReportSelection(), ls);
+}
+
+void OS32C::convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls)
+{
+  omron_os32c_driver::convertToLaserScan(rr, ls);
+}
+
+void OS32C::convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls)
+{
+  omron_os32c_driver::convertToLaserScan(mr, ls);
+}
+
+}  // namespace omron_os32c_driver
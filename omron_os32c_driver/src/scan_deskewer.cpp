@@ -0,0 +1,125 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_deskewer.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "omron_os32c_driver/scan_deskewer.h"
+
+using sensor_msgs::LaserScan;
+using sensor_msgs::PointCloud2;
+using sensor_msgs::PointField;
+
+namespace omron_os32c_driver {
+
+ScanDeskewer::ScanDeskewer() : angle_min_(0), angle_increment_(0), reverse_time_(false)
+{
+}
+
+void ScanDeskewer::configure(const LaserScan& ls, bool reverse_time)
+{
+  reverse_time_ = reverse_time;
+  if (ls.ranges.size() == cos_table_.size() && ls.angle_min == angle_min_ && ls.angle_increment == angle_increment_)
+  {
+    return;
+  }
+
+  angle_min_ = ls.angle_min;
+  angle_increment_ = ls.angle_increment;
+  cos_table_.resize(ls.ranges.size());
+  sin_table_.resize(ls.ranges.size());
+  for (size_t i = 0; i < ls.ranges.size(); ++i)
+  {
+    double angle = angle_min_ + i * angle_increment_;
+    cos_table_[i] = cos(angle);
+    sin_table_[i] = sin(angle);
+  }
+}
+
+void ScanDeskewer::deskew(const LaserScan& ls, double vx, double vy, double wz, PointCloud2* cloud) const
+{
+  const size_t num_beams = ls.ranges.size();
+  if (num_beams != cos_table_.size())
+  {
+    throw std::invalid_argument("Number of beams does not match configured scan");
+  }
+  bool has_intensities = ls.intensities.size() == num_beams;
+
+  cloud->header = ls.header;
+  cloud->height = 1;
+  cloud->width = num_beams;
+  if (cloud->fields.size() != 4)
+  {
+    const char* names[] = { "x", "y", "z", "intensity" };
+    cloud->fields.resize(4);
+    for (size_t i = 0; i < 4; ++i)
+    {
+      cloud->fields[i].name = names[i];
+      cloud->fields[i].offset = i * sizeof(float);
+      cloud->fields[i].datatype = PointField::FLOAT32;
+      cloud->fields[i].count = 1;
+    }
+  }
+  cloud->is_bigendian = false;
+  cloud->point_step = 4 * sizeof(float);
+  cloud->row_step = cloud->point_step * num_beams;
+  cloud->is_dense = false;
+  cloud->data.resize(cloud->row_step);
+  if (num_beams == 0)
+  {
+    return;
+  }
+
+  // Time of beam i relative to the last beam measured is t0 + i * dt. The motion
+  // over that time is linear in t, with the rotation small enough over a single
+  // sweep that a second order approximation of sin and cos is exact to well below
+  // the range resolution of the sensor.
+  const float period = ls.time_increment;
+  const float t0 = reverse_time_ ? 0 : -(num_beams - 1.0f) * period;
+  const float dt = reverse_time_ ? -period : period;
+  const float fvx = vx;
+  const float fvy = vy;
+  const float fwz = wz;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+
+  float* out = reinterpret_cast<float*>(&cloud->data[0]);
+  for (size_t i = 0; i < num_beams; ++i)
+  {
+    float r = ls.ranges[i];
+    float t = t0 + i * dt;
+    float dth = fwz * t;
+    float c = 1 - dth * dth / 2;
+    float x = r * (cos_table_[i] * c - sin_table_[i] * dth) + fvx * t;
+    float y = r * (sin_table_[i] * c + cos_table_[i] * dth) + fvy * t;
+    bool valid = r >= ls.range_min && r < ls.range_max;
+    out[4 * i] = valid ? x : nan;
+    out[4 * i + 1] = valid ? y : nan;
+    out[4 * i + 2] = valid ? 0 : nan;
+    out[4 * i + 3] = has_intensities ? ls.intensities[i] : 0;
+  }
+}
+
+}  // namespace omron_os32c_driver
@@ -0,0 +1,175 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_filter_chain.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_filter_chain.h"
+
+using std::min;
+using std::max;
+
+namespace omron_os32c_driver {
+
+const EIP_UINT ScanFilterChain::FILTERED;
+
+/**
+ * Convert a range in meters to device units, saturating below the no return code
+ */
+static EIP_UINT toDeviceRange(double range)
+{
+  return static_cast<EIP_UINT>(min(range * 1000 + 0.5, 65534.0));
+}
+
+ScanFilterChain::ScanFilterChain()
+  : min_range_(0), max_range_(std::numeric_limits<double>::infinity()), shadow_angle_(0), max_range_mm_(0xFFFE)
+{
+}
+
+void ScanFilterChain::setRangeLimits(double min_range, double max_range)
+{
+  if (min_range < 0 || max_range <= min_range)
+  {
+    throw std::invalid_argument("Invalid range limits");
+  }
+  min_range_ = min_range;
+  max_range_ = max_range;
+}
+
+void ScanFilterChain::addSelfMask(double start_angle, double end_angle, double min_range)
+{
+  BeamSelection::validateSector(start_angle, end_angle);
+  SelfMask mask;
+  mask.start_angle = start_angle;
+  mask.end_angle = end_angle;
+  mask.min_range = min_range;
+  self_masks_.push_back(mask);
+}
+
+void ScanFilterChain::setShadowAngle(double min_angle)
+{
+  if (min_angle < 0 || min_angle >= M_PI / 2)
+  {
+    throw std::invalid_argument("Shadow angle must be between 0 and pi/2");
+  }
+  shadow_angle_ = min_angle;
+}
+
+bool ScanFilterChain::isEnabled() const
+{
+  return min_range_ > 0 || !std::isinf(max_range_) || !self_masks_.empty() || shadow_angle_ > 0;
+}
+
+void ScanFilterChain::configure(const BeamSelection& selection)
+{
+  const vector<int>& beams = selection.getBeams();
+  const size_t n = beams.size();
+
+  // range limits, raised by the self masks for the beams they cover
+  max_range_mm_ = toDeviceRange(max_range_);
+  min_range_table_.assign(n, toDeviceRange(min_range_));
+  for (size_t m = 0; m < self_masks_.size(); ++m)
+  {
+    int start_beam = OS32C::calcBeamNumber(self_masks_[m].start_angle);
+    int end_beam = OS32C::calcBeamNumber(self_masks_[m].end_angle);
+    EIP_UINT min_range = toDeviceRange(self_masks_[m].min_range);
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (beams[i] >= start_beam && beams[i] <= end_beam)
+      {
+        min_range_table_[i] = max(min_range_table_[i], min_range);
+      }
+    }
+  }
+
+  // Neighbouring beams can be further apart than one increment where the
+  // selection has gaps, so the shadow test is set up per pair of beams.
+  shadows_.assign(n + 1, 0);
+  shadow_factor_.assign(n, 0);
+  if (shadow_angle_ > 0)
+  {
+    // The angle at the far point between its beam and the line to the near point
+    // is below the limit if far - near * (cos(a) + sin(a) / tan(limit)) > 0
+    double tan_shadow = tan(shadow_angle_);
+    for (size_t i = 0; i + 1 < n; ++i)
+    {
+      double angle = (beams[i + 1] - beams[i]) * OS32C::ANGLE_INC;
+      shadow_factor_[i] = cos(angle) + sin(angle) / tan_shadow;
+    }
+  }
+}
+
+void ScanFilterChain::filter(vector<EIP_UINT>& ranges)
+{
+  const size_t n = ranges.size();
+  if (n != getNumBeams())
+  {
+    throw std::invalid_argument("Number of beams does not match filter configuration");
+  }
+  if (n == 0)
+  {
+    return;
+  }
+  EIP_UINT* r = &ranges[0];
+
+  // Flag the pairs with a veiling point in between, and which of the two to
+  // remove. The flag for the pair starting at beam i is at i + 1, so that each
+  // beam finds the pairs on both sides of it at i and i + 1.
+  if (shadow_angle_ > 0)
+  {
+    // Local pointers, as stores through a byte pointer could otherwise alias the
+    // vectors, and operating on int and float rather than EIP_UINT lets the
+    // compiler turn the loop into vector compares and selects.
+    EIP_BYTE* shadows = &shadows_[1];
+    const float* factors = &shadow_factor_[0];
+    for (size_t i = 0; i + 1 < n; ++i)
+    {
+      int a = r[i];
+      int b = r[i + 1];
+      int valid = (a > FILTERED) & (b > FILTERED) & (a != 0xFFFF) & (b != 0xFFFF);
+      float fa = a;
+      float fb = b;
+      float near = fa < fb ? fa : fb;
+      float far = fa < fb ? fb : fa;
+      int shadow = valid & (far - near * factors[i] > 0);
+      shadows[i] = shadow * (1 + (a < b));
+    }
+  }
+
+  // Then remove the shadows along with anything outside of the range limits
+  for (size_t i = 0; i < n; ++i)
+  {
+    EIP_UINT v = r[i];
+    int valid = (v > FILTERED) & (v != 0xFFFF);
+    int clipped = valid & ((v < min_range_table_[i]) | (v > max_range_mm_));
+    int shadowed = (shadows_[i] == 2) | (shadows_[i + 1] == 1);
+    r[i] = (clipped | shadowed) ? FILTERED : v;
+  }
+}
+
+}  // namespace omron_os32c_driver
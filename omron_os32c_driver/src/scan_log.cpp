@@ -0,0 +1,541 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_log.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/scan_codec.h"
+#include "omron_os32c_driver/scan_log.h"
+
+using boost::uint64_t;
+using eip::serialization::BufferReader;
+using eip::serialization::BufferWriter;
+
+namespace omron_os32c_driver {
+
+const char SCAN_LOG_MAGIC[8] = { 'O', 'S', '3', '2', 'C', 'L', 'O', 'G' };
+const EIP_UDINT SCAN_LOG_VERSION = 1;
+/// "CHNK" and "INDX" in a little endian dump
+const EIP_UDINT SCAN_LOG_CHUNK_MAGIC = 0x4B4E4843;
+const EIP_UDINT SCAN_LOG_FOOTER_MAGIC = 0x58444E49;
+/// Alignment of every structure in the file, enough for the doubles and 64 bit offsets
+const size_t SCAN_LOG_ALIGNMENT = 8;
+
+/**
+ * Zero pad data to the alignment of the structures in the log
+ */
+static void padData(vector<EIP_BYTE>* data)
+{
+  data->resize((data->size() + SCAN_LOG_ALIGNMENT - 1) / SCAN_LOG_ALIGNMENT * SCAN_LOG_ALIGNMENT, 0);
+}
+
+static bool compareChunkStamp(const ScanLogChunkInfo& chunk, double stamp)
+{
+  return chunk.last_stamp < stamp;
+}
+
+static bool compareEntryStamp(const ScanLogIndexEntry& entry, double stamp)
+{
+  return entry.stamp < stamp;
+}
+
+static bool compareEntryScanCount(const ScanLogIndexEntry& entry, EIP_UDINT scan_count)
+{
+  return entry.scan_count < scan_count;
+}
+
+ScanLogWriter::ScanLogWriter(const string& filename, size_t chunk_scans, bool compress, size_t keyframe_interval)
+  : filename_(filename), chunk_scans_(chunk_scans), compress_(compress), encoder_(keyframe_interval), offset_(0)
+{
+  if (chunk_scans == 0)
+  {
+    throw std::invalid_argument("Scan log chunks must hold at least one scan");
+  }
+  file_.open(filename.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!file_)
+  {
+    throw std::runtime_error("Cannot create " + filename);
+  }
+
+  ScanLogFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SCAN_LOG_MAGIC, sizeof(header.magic));
+  header.version = SCAN_LOG_VERSION;
+  header.flags = compress ? SCAN_LOG_COMPRESSED : 0;
+  writeBytes(&header, sizeof(header));
+
+  memset(&chunk_, 0, sizeof(chunk_));
+  entries_.reserve(chunk_scans);
+  data_.reserve(chunk_scans * (sizeof(ScanLogRecordHeader) + 2 * BeamSelection::NUM_BEAMS * sizeof(EIP_UINT)));
+}
+
+ScanLogWriter::~ScanLogWriter()
+{
+  if (file_.is_open())
+  {
+    try
+    {
+      close();
+    }
+    catch (std::runtime_error& ex)
+    {
+      // the chunks already written can still be read without the index
+    }
+  }
+}
+
+void ScanLogWriter::scanReceived(const ScanView& scan)
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  write(scan, now.tv_sec + now.tv_nsec / 1000000000.0);
+}
+
+void ScanLogWriter::write(const ScanView& scan, double stamp)
+{
+  write(scan.getHeader(), stamp, scan.getRanges(), scan.getReflectance(), scan.getNumBeams());
+}
+
+void ScanLogWriter::write(const MeasurementReportHeader& header, double stamp, const EIP_UINT* ranges,
+                          const EIP_UINT* reflectance, size_t num_beams)
+{
+  if (entries_.empty())
+  {
+    chunk_.first_stamp = stamp;
+    chunk_.first_scan_count = header.scan_count;
+  }
+  chunk_.last_stamp = stamp;
+  chunk_.last_scan_count = header.scan_count;
+
+  // each record starts aligned, as compressed ones can be any length
+  padData(&data_);
+  ScanLogIndexEntry entry;
+  entry.stamp = stamp;
+  entry.scan_count = header.scan_count;
+  entry.offset = data_.size();
+  entries_.push_back(entry);
+
+  ScanLogRecordHeader record;
+  record.num_beams = num_beams;
+  record.has_reflectance = reflectance != NULL;
+  BufferWriter writer(boost::asio::buffer(record.header));
+  header.serialize(writer);
+  const EIP_BYTE* bytes = reinterpret_cast<const EIP_BYTE*>(&record);
+  data_.insert(data_.end(), bytes, bytes + sizeof(record));
+  if (compress_)
+  {
+    if (entries_.size() == 1)
+    {
+      encoder_.forceKeyframe();
+    }
+    encoder_.encode(ranges, reflectance, num_beams, &data_);
+  }
+  else
+  {
+    appendValues(ranges, reflectance, num_beams);
+  }
+
+  if (entries_.size() >= chunk_scans_)
+  {
+    flush();
+  }
+}
+
+void ScanLogWriter::appendValues(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams)
+{
+  const EIP_BYTE* bytes = reinterpret_cast<const EIP_BYTE*>(ranges);
+  data_.insert(data_.end(), bytes, bytes + num_beams * sizeof(EIP_UINT));
+  if (reflectance)
+  {
+    bytes = reinterpret_cast<const EIP_BYTE*>(reflectance);
+    data_.insert(data_.end(), bytes, bytes + num_beams * sizeof(EIP_UINT));
+  }
+}
+
+void ScanLogWriter::flush()
+{
+  if (entries_.empty())
+  {
+    return;
+  }
+  // so that the next chunk, or the chunk index, is aligned too
+  padData(&data_);
+  chunk_.magic = SCAN_LOG_CHUNK_MAGIC;
+  chunk_.num_scans = entries_.size();
+  chunk_.data_size = data_.size();
+
+  ScanLogChunkInfo info;
+  memset(&info, 0, sizeof(info));
+  info.offset = offset_;
+  info.first_stamp = chunk_.first_stamp;
+  info.last_stamp = chunk_.last_stamp;
+  info.first_scan_count = chunk_.first_scan_count;
+  info.last_scan_count = chunk_.last_scan_count;
+  info.num_scans = chunk_.num_scans;
+
+  writeBytes(&chunk_, sizeof(chunk_));
+  writeBytes(&entries_[0], entries_.size() * sizeof(ScanLogIndexEntry));
+  writeBytes(&data_[0], data_.size());
+  file_.flush();
+  chunks_.push_back(info);
+  entries_.clear();
+  data_.clear();
+}
+
+void ScanLogWriter::close()
+{
+  flush();
+  ScanLogFooter footer;
+  memset(&footer, 0, sizeof(footer));
+  footer.index_offset = offset_;
+  footer.num_chunks = chunks_.size();
+  footer.magic = SCAN_LOG_FOOTER_MAGIC;
+  if (!chunks_.empty())
+  {
+    writeBytes(&chunks_[0], chunks_.size() * sizeof(ScanLogChunkInfo));
+  }
+  writeBytes(&footer, sizeof(footer));
+  file_.close();
+}
+
+void ScanLogWriter::writeBytes(const void* data, size_t size)
+{
+  file_.write(static_cast<const char*>(data), size);
+  if (!file_)
+  {
+    throw std::runtime_error("Cannot write " + filename_);
+  }
+  offset_ += size;
+}
+
+ScanLogReader::ScanLogReader(const string& filename)
+  : num_scans_(0), chunk_(0), scan_(0), decoded_chunk_(0), decoded_scan_(0)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Cannot open " + filename + ": " + strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(ScanLogFileHeader))
+  {
+    ::close(fd);
+    throw std::runtime_error(filename + " is not a scan log");
+  }
+  size_ = st.st_size;
+  void* base = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED)
+  {
+    throw std::runtime_error("Cannot map " + filename + ": " + strerror(errno));
+  }
+  data_ = static_cast<const EIP_BYTE*>(base);
+
+  const ScanLogFileHeader* header = reinterpret_cast<const ScanLogFileHeader*>(data_);
+  if (memcmp(header->magic, SCAN_LOG_MAGIC, sizeof(header->magic)) || header->version != SCAN_LOG_VERSION ||
+      (header->flags & ~SCAN_LOG_COMPRESSED))
+  {
+    munmap(base, size_);
+    throw std::runtime_error(filename + " is not a compatible scan log");
+  }
+  compressed_ = header->flags & SCAN_LOG_COMPRESSED;
+  if (!readFooter())
+  {
+    walkChunks();
+  }
+  for (size_t i = 0; i < chunks_.size(); ++i)
+  {
+    num_scans_ += chunks_[i].num_scans;
+  }
+}
+
+ScanLogReader::~ScanLogReader()
+{
+  munmap(const_cast<EIP_BYTE*>(data_), size_);
+}
+
+bool ScanLogReader::readFooter()
+{
+  if (size_ < sizeof(ScanLogFileHeader) + sizeof(ScanLogFooter))
+  {
+    return false;
+  }
+  ScanLogFooter footer;
+  memcpy(&footer, data_ + size_ - sizeof(ScanLogFooter), sizeof(footer));
+  if (footer.magic != SCAN_LOG_FOOTER_MAGIC || footer.index_offset < sizeof(ScanLogFileHeader) ||
+      footer.index_offset > size_ - sizeof(ScanLogFooter) ||
+      size_ - sizeof(ScanLogFooter) - footer.index_offset != footer.num_chunks * sizeof(ScanLogChunkInfo))
+  {
+    return false;
+  }
+  chunks_.resize(footer.num_chunks);
+  if (!chunks_.empty())
+  {
+    memcpy(&chunks_[0], data_ + footer.index_offset, chunks_.size() * sizeof(ScanLogChunkInfo));
+  }
+
+  // every chunk has to be where the index says it is, or the chunks are walked instead
+  for (size_t i = 0; i < chunks_.size(); ++i)
+  {
+    const ScanLogChunkInfo& info = chunks_[i];
+    ScanLogChunkHeader chunk;
+    if (info.offset < sizeof(ScanLogFileHeader) || info.offset > footer.index_offset ||
+        footer.index_offset - info.offset < sizeof(ScanLogChunkHeader))
+    {
+      chunks_.clear();
+      return false;
+    }
+    memcpy(&chunk, data_ + info.offset, sizeof(chunk));
+    uint64_t end = info.offset + sizeof(ScanLogChunkHeader) +
+                   static_cast<uint64_t>(chunk.num_scans) * sizeof(ScanLogIndexEntry) + chunk.data_size;
+    if (chunk.magic != SCAN_LOG_CHUNK_MAGIC || chunk.num_scans != info.num_scans || end > footer.index_offset)
+    {
+      chunks_.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+void ScanLogReader::walkChunks()
+{
+  // everything up to the first incomplete chunk, such as one cut short by a crash
+  uint64_t offset = sizeof(ScanLogFileHeader);
+  while (offset + sizeof(ScanLogChunkHeader) <= size_)
+  {
+    ScanLogChunkHeader chunk;
+    memcpy(&chunk, data_ + offset, sizeof(chunk));
+    uint64_t end = offset + sizeof(ScanLogChunkHeader) +
+                   static_cast<uint64_t>(chunk.num_scans) * sizeof(ScanLogIndexEntry) + chunk.data_size;
+    if (chunk.magic != SCAN_LOG_CHUNK_MAGIC || end > size_)
+    {
+      break;
+    }
+    ScanLogChunkInfo info;
+    info.offset = offset;
+    info.first_stamp = chunk.first_stamp;
+    info.last_stamp = chunk.last_stamp;
+    info.first_scan_count = chunk.first_scan_count;
+    info.last_scan_count = chunk.last_scan_count;
+    info.num_scans = chunk.num_scans;
+    info.reserved = 0;
+    chunks_.push_back(info);
+    offset = end;
+  }
+}
+
+const ScanLogChunkHeader* ScanLogReader::getChunkHeader(size_t chunk) const
+{
+  return reinterpret_cast<const ScanLogChunkHeader*>(data_ + chunks_[chunk].offset);
+}
+
+const ScanLogIndexEntry* ScanLogReader::getIndex(size_t chunk) const
+{
+  return reinterpret_cast<const ScanLogIndexEntry*>(data_ + chunks_[chunk].offset + sizeof(ScanLogChunkHeader));
+}
+
+bool ScanLogReader::seekTime(double stamp)
+{
+  chunk_ = std::lower_bound(chunks_.begin(), chunks_.end(), stamp, compareChunkStamp) - chunks_.begin();
+  scan_ = 0;
+  if (chunk_ == chunks_.size())
+  {
+    return false;
+  }
+  const ScanLogIndexEntry* index = getIndex(chunk_);
+  scan_ = std::lower_bound(index, index + chunks_[chunk_].num_scans, stamp, compareEntryStamp) - index;
+  return true;
+}
+
+bool ScanLogReader::seekScanCount(EIP_UDINT scan_count)
+{
+  if (runs_.empty())
+  {
+    findScanCountRuns();
+  }
+  for (size_t i = 0; i < runs_.size(); ++i)
+  {
+    if (runs_[i].first_scan_count <= scan_count && scan_count <= runs_[i].last_scan_count)
+    {
+      seekInRun(runs_[i], scan_count);
+      return true;
+    }
+  }
+  for (size_t i = 0; i < runs_.size(); ++i)
+  {
+    if (runs_[i].first_scan_count > scan_count)
+    {
+      chunk_ = runs_[i].first_chunk;
+      scan_ = runs_[i].first_scan;
+      return true;
+    }
+  }
+  chunk_ = chunks_.size();
+  scan_ = 0;
+  return false;
+}
+
+void ScanLogReader::findScanCountRuns()
+{
+  ScanCountRun run;
+  bool in_run = false;
+  for (size_t chunk = 0; chunk < chunks_.size(); ++chunk)
+  {
+    const ScanLogIndexEntry* index = getIndex(chunk);
+    for (size_t scan = 0; scan < chunks_[chunk].num_scans; ++scan)
+    {
+      if (in_run && index[scan].scan_count >= run.last_scan_count)
+      {
+        run.last_chunk = chunk;
+        run.last_scan = scan;
+        run.last_scan_count = index[scan].scan_count;
+        continue;
+      }
+      if (in_run)
+      {
+        runs_.push_back(run);
+      }
+      in_run = true;
+      run.first_chunk = run.last_chunk = chunk;
+      run.first_scan = run.last_scan = scan;
+      run.first_scan_count = run.last_scan_count = index[scan].scan_count;
+    }
+  }
+  if (in_run)
+  {
+    runs_.push_back(run);
+  }
+}
+
+void ScanLogReader::seekInRun(const ScanCountRun& run, EIP_UDINT scan_count)
+{
+  // The count goes up over the run, so the scan is in the first chunk of the run
+  // that ends at or after it
+  for (chunk_ = run.first_chunk; chunk_ <= run.last_chunk; ++chunk_)
+  {
+    const ScanLogIndexEntry* index = getIndex(chunk_);
+    size_t begin = chunk_ == run.first_chunk ? run.first_scan : 0;
+    size_t end = chunk_ == run.last_chunk ? run.last_scan + 1 : chunks_[chunk_].num_scans;
+    if (end > begin && index[end - 1].scan_count >= scan_count)
+    {
+      scan_ = std::lower_bound(index + begin, index + end, scan_count, compareEntryScanCount) - index;
+      return;
+    }
+  }
+}
+
+const ScanLogRecordHeader* ScanLogReader::getRecord(size_t chunk, size_t scan, size_t* available) const
+{
+  const ScanLogChunkHeader* header = getChunkHeader(chunk);
+  const ScanLogIndexEntry* index = getIndex(chunk);
+  EIP_UDINT offset = index[scan].offset;
+  if (offset > header->data_size || header->data_size - offset < sizeof(ScanLogRecordHeader))
+  {
+    throw std::runtime_error("Scan log record runs past the end of its chunk");
+  }
+  *available = header->data_size - offset - sizeof(ScanLogRecordHeader);
+  const EIP_BYTE* data = reinterpret_cast<const EIP_BYTE*>(index + header->num_scans);
+  return reinterpret_cast<const ScanLogRecordHeader*>(data + offset);
+}
+
+void ScanLogReader::decodeRecord(size_t chunk, size_t scan)
+{
+  size_t available;
+  const ScanLogRecordHeader* record = getRecord(chunk, scan, &available);
+  decoder_.decode(reinterpret_cast<const EIP_BYTE*>(record + 1), available);
+}
+
+bool ScanLogReader::next(ScanLogEntry* entry)
+{
+  while (chunk_ < chunks_.size() && scan_ >= chunks_[chunk_].num_scans)
+  {
+    ++chunk_;
+    scan_ = 0;
+  }
+  if (chunk_ == chunks_.size())
+  {
+    return false;
+  }
+
+  size_t available;
+  const ScanLogRecordHeader* record = getRecord(chunk_, scan_, &available);
+  if (compressed_)
+  {
+    if (decoded_chunk_ != chunk_ || decoded_scan_ != scan_)
+    {
+      // after a seek, catch the decoder up from the last keyframe at or before this scan
+      size_t keyframe = scan_;
+      for (; keyframe > 0; --keyframe)
+      {
+        size_t size;
+        const ScanLogRecordHeader* previous = getRecord(chunk_, keyframe, &size);
+        if (size > 0 && ScanDecoder::isKeyframe(reinterpret_cast<const EIP_BYTE*>(previous + 1)))
+        {
+          break;
+        }
+      }
+      decoder_.reset();
+      for (; keyframe < scan_; ++keyframe)
+      {
+        decodeRecord(chunk_, keyframe);
+      }
+    }
+    decodeRecord(chunk_, scan_);
+    decoded_chunk_ = chunk_;
+    decoded_scan_ = scan_ + 1;
+    entry->num_beams = decoder_.getRanges().size();
+    entry->ranges = decoder_.getRanges().empty() ? NULL : &decoder_.getRanges()[0];
+    entry->reflectance = decoder_.getReflectance().empty() ? NULL : &decoder_.getReflectance()[0];
+  }
+  else
+  {
+    if ((record->has_reflectance ? 2 : 1) * record->num_beams * sizeof(EIP_UINT) > available)
+    {
+      throw std::runtime_error("Scan log record runs past the end of its chunk");
+    }
+    entry->num_beams = record->num_beams;
+    entry->ranges = reinterpret_cast<const EIP_UINT*>(record + 1);
+    entry->reflectance = record->has_reflectance ? entry->ranges + record->num_beams : NULL;
+  }
+
+  entry->stamp = getIndex(chunk_)[scan_].stamp;
+  BufferReader reader(boost::asio::buffer(record->header));
+  entry->header.deserialize(reader);
+  ++scan_;
+  return true;
+}
+
+}  // namespace omron_os32c_driver
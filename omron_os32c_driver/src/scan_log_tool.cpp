@@ -0,0 +1,278 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_log_tool.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "omron_os32c_driver/scan_codec.h"
+#include "omron_os32c_driver/scan_log.h"
+#include "omron_os32c_driver/shm_scan_ring.h"
+
+using std::string;
+using std::vector;
+using omron_os32c_driver::ScanDecoder;
+using omron_os32c_driver::ScanEncoder;
+using omron_os32c_driver::ScanLogChunkInfo;
+using omron_os32c_driver::ScanLogEntry;
+using omron_os32c_driver::ScanLogReader;
+using omron_os32c_driver::ScanLogWriter;
+using omron_os32c_driver::ShmScan;
+using omron_os32c_driver::ShmScanReader;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void requestStop(int)
+{
+  stop_requested = 1;
+}
+
+static int usage()
+{
+  fprintf(stderr,
+          "Usage: os32c_scan_log record <shm_name> <log> [--chunk-scans <n>] [--compress] [--keyframe-interval <n>]\n"
+          "       os32c_scan_log info <log>\n"
+          "       os32c_scan_log dump <log> [--time <seconds> | --scan-count <n>] [--count <n>]\n"
+          "       os32c_scan_log benchmark <log> [--keyframe-interval <n>]\n"
+          "\n"
+          "record     Log the scans published on the driver's ~shm_name ring until interrupted\n"
+          "info       Print the chunks of a log\n"
+          "dump       Print scans as CSV lines of stamp, scan_count and range codes, starting at\n"
+          "           the first scan at or after a CLOCK_REALTIME time or a scan_count\n"
+          "benchmark  Compress the scans of a log in memory and report the ratio and speed\n");
+  return 2;
+}
+
+static int record(const string& shm_name, const string& filename, int argc, char** argv)
+{
+  size_t chunk_scans = 256;
+  bool compress = false;
+  size_t keyframe_interval = 25;
+  for (int i = 0; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "--compress"))
+    {
+      compress = true;
+    }
+    else if (!strcmp(argv[i], "--chunk-scans") && i + 1 < argc)
+    {
+      chunk_scans = strtoul(argv[++i], NULL, 0);
+    }
+    else if (!strcmp(argv[i], "--keyframe-interval") && i + 1 < argc)
+    {
+      keyframe_interval = strtoul(argv[++i], NULL, 0);
+    }
+    else
+    {
+      return usage();
+    }
+  }
+
+  ShmScanReader reader(shm_name);
+  ScanLogWriter writer(filename, chunk_scans, compress, keyframe_interval);
+  signal(SIGINT, requestStop);
+  signal(SIGTERM, requestStop);
+
+  // readNext() never blocks, so poll at a fraction of the 40 ms scan period
+  ShmScan scan;
+  size_t num_scans = 0;
+  while (!stop_requested && !reader.isClosed())
+  {
+    if (!reader.readNext(&scan))
+    {
+      usleep(2000);
+      continue;
+    }
+    writer.write(scan.header, scan.stamp, &scan.ranges[0], scan.reflectance.empty() ? NULL : &scan.reflectance[0],
+                 scan.ranges.size());
+    ++num_scans;
+  }
+  writer.close();
+  fprintf(stderr, "Logged %zu scans to %s, %llu dropped\n", num_scans, filename.c_str(),
+          static_cast<unsigned long long>(reader.getDropped()));
+  return 0;
+}
+
+static int info(const string& filename)
+{
+  ScanLogReader reader(filename);
+  printf("%zu scans in %zu chunks%s\n", reader.getNumScans(), reader.getNumChunks(),
+         reader.isCompressed() ? ", compressed" : "");
+  for (size_t i = 0; i < reader.getNumChunks(); ++i)
+  {
+    const ScanLogChunkInfo& chunk = reader.getChunk(i);
+    printf("chunk %zu at %llu: %u scans, %.6f to %.6f, scan_count %u to %u\n", i,
+           static_cast<unsigned long long>(chunk.offset), chunk.num_scans, chunk.first_stamp, chunk.last_stamp,
+           chunk.first_scan_count, chunk.last_scan_count);
+  }
+  return 0;
+}
+
+static int dump(const string& filename, int argc, char** argv)
+{
+  ScanLogReader reader(filename);
+  long count = -1;
+  for (int i = 0; i + 1 < argc; i += 2)
+  {
+    if (!strcmp(argv[i], "--time"))
+    {
+      reader.seekTime(strtod(argv[i + 1], NULL));
+    }
+    else if (!strcmp(argv[i], "--scan-count"))
+    {
+      reader.seekScanCount(strtoul(argv[i + 1], NULL, 0));
+    }
+    else if (!strcmp(argv[i], "--count"))
+    {
+      count = strtol(argv[i + 1], NULL, 0);
+    }
+    else
+    {
+      return usage();
+    }
+  }
+
+  ScanLogEntry entry;
+  for (; count != 0 && reader.next(&entry); --count)
+  {
+    printf("%.6f,%u", entry.stamp, entry.header.scan_count);
+    for (size_t i = 0; i < entry.num_beams; ++i)
+    {
+      printf(",%u", entry.ranges[i]);
+    }
+    printf("\n");
+  }
+  return 0;
+}
+
+static double now()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
+
+static int benchmark(const string& filename, int argc, char** argv)
+{
+  size_t keyframe_interval = 25;
+  if (argc == 2 && !strcmp(argv[0], "--keyframe-interval"))
+  {
+    keyframe_interval = strtoul(argv[1], NULL, 0);
+  }
+  else if (argc != 0)
+  {
+    return usage();
+  }
+
+  // copy the scans out of the log first, so that only the codec is timed
+  ScanLogReader reader(filename);
+  vector<vector<EIP_UINT> > ranges, reflectance;
+  ScanLogEntry entry;
+  size_t raw_size = 0;
+  while (reader.next(&entry))
+  {
+    ranges.push_back(vector<EIP_UINT>(entry.ranges, entry.ranges + entry.num_beams));
+    reflectance.push_back(entry.reflectance ? vector<EIP_UINT>(entry.reflectance, entry.reflectance + entry.num_beams) :
+                                              vector<EIP_UINT>());
+    raw_size += (ranges.back().size() + reflectance.back().size()) * sizeof(EIP_UINT);
+  }
+  if (ranges.empty())
+  {
+    fprintf(stderr, "%s has no scans\n", filename.c_str());
+    return 1;
+  }
+
+  ScanEncoder encoder(keyframe_interval);
+  vector<EIP_BYTE> encoded;
+  encoded.reserve(raw_size * 2);
+  double start = now();
+  for (size_t i = 0; i < ranges.size(); ++i)
+  {
+    encoder.encode(&ranges[i][0], reflectance[i].empty() ? NULL : &reflectance[i][0], ranges[i].size(), &encoded);
+  }
+  double encode_time = now() - start;
+
+  ScanDecoder decoder;
+  size_t offset = 0;
+  bool matches = true;
+  start = now();
+  for (size_t i = 0; i < ranges.size(); ++i)
+  {
+    offset += decoder.decode(&encoded[offset], encoded.size() - offset);
+    matches = matches && decoder.getRanges() == ranges[i] && decoder.getReflectance() == reflectance[i];
+  }
+  double decode_time = now() - start;
+
+  printf("%zu scans, %zu bytes raw, %zu bytes encoded, ratio %.2f\n", ranges.size(), raw_size, encoded.size(),
+         static_cast<double>(raw_size) / encoded.size());
+  printf("encode %.1f MB/s, decode %.1f MB/s of raw data\n", raw_size / encode_time / 1e6,
+         raw_size / decode_time / 1e6);
+  if (!matches)
+  {
+    fprintf(stderr, "Decoded scans differ from the originals\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    return usage();
+  }
+  string command = argv[1];
+  try
+  {
+    if (command == "record" && argc >= 4)
+    {
+      return record(argv[2], argv[3], argc - 4, argv + 4);
+    }
+    else if (command == "info" && argc == 3)
+    {
+      return info(argv[2]);
+    }
+    else if (command == "dump" && argc % 2 == 1)
+    {
+      return dump(argv[2], argc - 3, argv + 3);
+    }
+    else if (command == "benchmark")
+    {
+      return benchmark(argv[2], argc - 3, argv + 3);
+    }
+  }
+  catch (std::exception& ex)
+  {
+    fprintf(stderr, "%s\n", ex.what());
+    return 1;
+  }
+  return usage();
+}
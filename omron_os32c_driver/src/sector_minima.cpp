@@ -0,0 +1,114 @@
+/**
+Software License Agreement (BSD)
+
+\file      sector_minima.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/sector_minima.h"
+
+namespace omron_os32c_driver {
+
+const EIP_UINT SectorMinima::NO_RETURN;
+
+/**
+ * Smallest range of a span of beams, counting noisy beams as no return. The
+ * ranges are shifted down by two with wrap around, which moves the noisy code
+ * (0x0001) above every range and no return (0xFFFF) just below it, so a plain
+ * minimum that vectorizes skips both.
+ */
+static EIP_UINT minRange(const EIP_UINT* ranges, size_t n)
+{
+  EIP_UINT shifted = SectorMinima::NO_RETURN - 2;
+  for (size_t i = 0; i < n; ++i)
+  {
+    EIP_UINT r = ranges[i] - 2;
+    shifted = r < shifted ? r : shifted;
+  }
+  return shifted + 2;
+}
+
+void SectorMinima::addSector(double start_angle, double end_angle)
+{
+  BeamSelection::validateSector(start_angle, end_angle);
+  Sector sector;
+  sector.start_angle = start_angle;
+  sector.end_angle = end_angle;
+  sector.first_beam = OS32C::calcBeamNumber(start_angle);
+  sector.last_beam = OS32C::calcBeamNumber(end_angle);
+  sector.begin = 0;
+  sector.end = 0;
+  sector.range = NO_RETURN;
+  sector.beam = -1;
+  sector.index = -1;
+  sectors_.push_back(sector);
+}
+
+void SectorMinima::configure(const BeamSelection& selection)
+{
+  // selected beams are reported in increasing order, so each sector is a span of indices
+  beams_ = selection.getBeams();
+  slots_.resize(beams_.size());
+  for (size_t i = 0; i < slots_.size(); ++i)
+  {
+    slots_[i] = selection.getSlot(i);
+  }
+  num_slots_ = selection.getNumSlots();
+  for (size_t i = 0; i < sectors_.size(); ++i)
+  {
+    Sector& sector = sectors_[i];
+    sector.begin = std::lower_bound(beams_.begin(), beams_.end(), sector.first_beam) - beams_.begin();
+    sector.end = std::upper_bound(beams_.begin(), beams_.end(), sector.last_beam) - beams_.begin();
+  }
+}
+
+void SectorMinima::reduce(const EIP_UINT* ranges, size_t num_beams)
+{
+  num_beams = std::min(num_beams, beams_.size());
+  for (size_t s = 0; s < sectors_.size(); ++s)
+  {
+    Sector& sector = sectors_[s];
+    const size_t begin = std::min(sector.begin, num_beams);
+    const size_t end = std::min(sector.end, num_beams);
+    if (begin >= end)
+    {
+      sector.range = NO_RETURN;
+      sector.beam = -1;
+      sector.index = -1;
+      continue;
+    }
+
+    // the minimum first, then the first beam at it, rather than one loop that
+    // tracks the index and does not vectorize
+    sector.range = minRange(ranges + begin, end - begin);
+    sector.beam = -1;
+    sector.index = -1;
+    if (sector.range != NO_RETURN)
+    {
+      sector.index = std::find(ranges + begin, ranges + end, sector.range) - ranges;
+      sector.beam = beams_[sector.index];
+    }
+  }
+}
+
+}  // namespace omron_os32c_driver
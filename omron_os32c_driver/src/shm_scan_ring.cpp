@@ -0,0 +1,308 @@
+/**
+Software License Agreement (BSD)
+
+\file      shm_scan_ring.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include <boost/static_assert.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/shm_scan_ring.h"
+
+using boost::uint64_t;
+using eip::serialization::BufferReader;
+using eip::serialization::BufferWriter;
+
+// The atomics live in memory shared between processes, which only works if they
+// are lock free rather than relying on a lock in the address space of the writer
+BOOST_STATIC_ASSERT(BOOST_ATOMIC_INT32_LOCK_FREE == 2);
+BOOST_STATIC_ASSERT(BOOST_ATOMIC_INT64_LOCK_FREE == 2);
+
+namespace omron_os32c_driver {
+
+/// "OS32" followed by the layout version. Changes whenever the structures below do.
+const EIP_UDINT SHM_MAGIC = 0x4F533332;
+const EIP_UDINT SHM_VERSION = 1;
+/// Size of a serialized MeasurementReportHeader
+const size_t SHM_HEADER_SIZE = 56;
+
+/**
+ * Start of the shared memory, followed by the slots
+ */
+struct ShmRingHeader
+{
+  /// Set to SHM_MAGIC once the ring is ready, and cleared when the writer closes
+  boost::atomic<EIP_UDINT> magic;
+  EIP_UDINT version;
+  EIP_UDINT num_slots;
+  EIP_UDINT slot_size;
+  /// Number of scans completely written. Scan i is in slot i % num_slots.
+  boost::atomic<uint64_t> write_count;
+};
+
+/**
+ * One scan in the ring. The sequence is odd while the writer is changing the slot,
+ * so a reader knows its copy is good if the sequence was even and unchanged.
+ */
+struct ShmSlot
+{
+  boost::atomic<EIP_UDINT> sequence;
+  EIP_UDINT num_beams;
+  EIP_UDINT has_reflectance;
+  uint64_t index;
+  double stamp;
+  double monotonic_stamp;
+  /// Header as serialized by the sensor
+  EIP_BYTE header[SHM_HEADER_SIZE];
+  EIP_UINT ranges[BeamSelection::NUM_BEAMS];
+  EIP_UINT reflectance[BeamSelection::NUM_BEAMS];
+};
+
+/// Slots start on a cache line after the header
+const size_t SHM_SLOTS_OFFSET = (sizeof(ShmRingHeader) + 63) / 64 * 64;
+
+static double getTime(clockid_t clock)
+{
+  timespec now;
+  clock_gettime(clock, &now);
+  return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
+
+static string errorMessage(const string& what, int error)
+{
+  return what + ": " + strerror(error);
+}
+
+ShmScanWriter::ShmScanWriter(const string& name, int num_slots) : name_(name), write_count_(0)
+{
+  if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != string::npos)
+  {
+    throw std::invalid_argument("Shared memory name must be a single / followed by a name");
+  }
+  if (num_slots < 2)
+  {
+    throw std::invalid_argument("Shared memory ring needs at least 2 slots");
+  }
+
+  // start over from any ring left behind by a previous run
+  shm_unlink(name_.c_str());
+  int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0)
+  {
+    throw std::runtime_error(errorMessage("Cannot create shared memory " + name_, errno));
+  }
+  size_ = SHM_SLOTS_OFFSET + num_slots * sizeof(ShmSlot);
+  void* base = MAP_FAILED;
+  if (!ftruncate(fd, size_))
+  {
+    base = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (base == MAP_FAILED)
+  {
+    string error = errorMessage("Cannot map shared memory " + name_, errno);
+    close(fd);
+    shm_unlink(name_.c_str());
+    throw std::runtime_error(error);
+  }
+  close(fd);
+
+  // the new object is zero filled, which is a valid empty slot for every slot
+  ring_ = static_cast<ShmRingHeader*>(base);
+  slots_ = reinterpret_cast<ShmSlot*>(static_cast<char*>(base) + SHM_SLOTS_OFFSET);
+  ring_->version = SHM_VERSION;
+  ring_->num_slots = num_slots;
+  ring_->slot_size = sizeof(ShmSlot);
+  ring_->write_count.store(0, boost::memory_order_relaxed);
+  ring_->magic.store(SHM_MAGIC, boost::memory_order_release);
+}
+
+ShmScanWriter::~ShmScanWriter()
+{
+  ring_->magic.store(0, boost::memory_order_release);
+  munmap(ring_, size_);
+  shm_unlink(name_.c_str());
+}
+
+void ShmScanWriter::scanReceived(const ScanView& scan)
+{
+  write(scan, getTime(CLOCK_REALTIME), getTime(CLOCK_MONOTONIC));
+}
+
+void ShmScanWriter::write(const ScanView& scan, double stamp, double monotonic_stamp)
+{
+  ShmSlot& slot = slots_[write_count_ % ring_->num_slots];
+  EIP_UDINT sequence = slot.sequence.load(boost::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, boost::memory_order_relaxed);
+  boost::atomic_thread_fence(boost::memory_order_release);
+
+  size_t num_beams = std::min(scan.getNumBeams(), static_cast<size_t>(BeamSelection::NUM_BEAMS));
+  slot.num_beams = num_beams;
+  slot.index = write_count_;
+  slot.stamp = stamp;
+  slot.monotonic_stamp = monotonic_stamp;
+  BufferWriter writer(boost::asio::buffer(slot.header));
+  scan.getHeader().serialize(writer);
+  std::copy(scan.getRanges(), scan.getRanges() + num_beams, slot.ranges);
+  slot.has_reflectance = scan.getReflectance() != NULL;
+  if (slot.has_reflectance)
+  {
+    std::copy(scan.getReflectance(), scan.getReflectance() + num_beams, slot.reflectance);
+  }
+
+  slot.sequence.store(sequence + 2, boost::memory_order_release);
+  ring_->write_count.store(++write_count_, boost::memory_order_release);
+}
+
+ShmScanReader::ShmScanReader(const string& name) : next_(0), dropped_(0)
+{
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+  {
+    throw std::runtime_error(errorMessage("Cannot open shared memory " + name, errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < SHM_SLOTS_OFFSET)
+  {
+    close(fd);
+    throw std::runtime_error("Shared memory " + name + " is not a scan ring");
+  }
+  size_ = st.st_size;
+  void* base = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd, 0);
+  int error = errno;
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    throw std::runtime_error(errorMessage("Cannot map shared memory " + name, error));
+  }
+
+  ring_ = static_cast<const ShmRingHeader*>(base);
+  slots_ = reinterpret_cast<const ShmSlot*>(static_cast<const char*>(base) + SHM_SLOTS_OFFSET);
+  if (ring_->magic.load(boost::memory_order_acquire) != SHM_MAGIC || ring_->version != SHM_VERSION ||
+      ring_->slot_size != sizeof(ShmSlot) || ring_->num_slots < 2 ||
+      size_ < SHM_SLOTS_OFFSET + ring_->num_slots * sizeof(ShmSlot))
+  {
+    munmap(const_cast<ShmRingHeader*>(ring_), size_);
+    throw std::runtime_error("Shared memory " + name + " is not a compatible scan ring");
+  }
+
+  uint64_t written = ring_->write_count.load(boost::memory_order_acquire);
+  next_ = written > ring_->num_slots ? written - ring_->num_slots : 0;
+}
+
+ShmScanReader::~ShmScanReader()
+{
+  munmap(const_cast<ShmRingHeader*>(ring_), size_);
+}
+
+bool ShmScanReader::isClosed() const
+{
+  return ring_->magic.load(boost::memory_order_acquire) != SHM_MAGIC;
+}
+
+bool ShmScanReader::readNext(ShmScan* scan)
+{
+  uint64_t written = ring_->write_count.load(boost::memory_order_acquire);
+  while (next_ < written)
+  {
+    if (written - next_ > ring_->num_slots)
+    {
+      dropped_ += written - next_ - ring_->num_slots;
+      next_ = written - ring_->num_slots;
+    }
+    if (readSlot(next_++, scan))
+    {
+      return true;
+    }
+    // overwritten while copying it, so the writer is a whole ring ahead
+    ++dropped_;
+    written = ring_->write_count.load(boost::memory_order_acquire);
+  }
+  return false;
+}
+
+bool ShmScanReader::readLatest(ShmScan* scan)
+{
+  uint64_t written = ring_->write_count.load(boost::memory_order_acquire);
+  while (next_ < written)
+  {
+    if (readSlot(written - 1, scan))
+    {
+      next_ = written;
+      return true;
+    }
+    written = ring_->write_count.load(boost::memory_order_acquire);
+  }
+  return false;
+}
+
+bool ShmScanReader::readSlot(uint64_t index, ShmScan* scan)
+{
+  const ShmSlot& slot = slots_[index % ring_->num_slots];
+  EIP_UDINT sequence = slot.sequence.load(boost::memory_order_acquire);
+  if (sequence & 1)
+  {
+    return false;
+  }
+
+  // Copy everything out first, as nothing read can be trusted until the
+  // sequence is found to be unchanged afterwards
+  EIP_BYTE header[SHM_HEADER_SIZE];
+  memcpy(header, slot.header, sizeof(header));
+  size_t num_beams = std::min(slot.num_beams, static_cast<EIP_UDINT>(BeamSelection::NUM_BEAMS));
+  bool has_reflectance = slot.has_reflectance;
+  scan->index = slot.index;
+  scan->stamp = slot.stamp;
+  scan->monotonic_stamp = slot.monotonic_stamp;
+  scan->ranges.assign(slot.ranges, slot.ranges + num_beams);
+  if (has_reflectance)
+  {
+    scan->reflectance.assign(slot.reflectance, slot.reflectance + num_beams);
+  }
+  else
+  {
+    scan->reflectance.clear();
+  }
+
+  boost::atomic_thread_fence(boost::memory_order_acquire);
+  if (slot.sequence.load(boost::memory_order_relaxed) != sequence || scan->index != index)
+  {
+    return false;
+  }
+  BufferReader reader(boost::asio::buffer(header));
+  scan->header.deserialize(reader);
+  return true;
+}
+
+}  // namespace omron_os32c_driver
@@ -0,0 +1,99 @@
+/**
+Software License Agreement (BSD)
+
+\file      temporal_median_filter.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "omron_os32c_driver/temporal_median_filter.h"
+
+using std::min;
+using std::max;
+
+namespace omron_os32c_driver {
+
+TemporalMedianFilter::TemporalMedianFilter(int window) : window_(window), num_beams_(0), newest_(0)
+{
+  if (window != 3 && window != 5)
+  {
+    throw std::invalid_argument("Median window must be 3 or 5");
+  }
+}
+
+void TemporalMedianFilter::reset()
+{
+  num_beams_ = 0;
+  history_.clear();
+}
+
+void TemporalMedianFilter::filter(vector<EIP_UINT>& ranges)
+{
+  const size_t n = ranges.size();
+  if (n == 0)
+  {
+    return;
+  }
+  if (n != num_beams_)
+  {
+    // start out with every row holding this scan, which makes it its own median
+    num_beams_ = n;
+    history_.resize(window_ * n);
+    for (int row = 0; row < window_; ++row)
+    {
+      std::copy(ranges.begin(), ranges.end(), history_.begin() + row * n);
+    }
+    newest_ = 0;
+    return;
+  }
+
+  newest_ = (newest_ + 1) % window_;
+  std::copy(ranges.begin(), ranges.end(), history_.begin() + newest_ * n);
+
+  // The order of the rows in time does not matter to the median
+  EIP_UINT* out = &ranges[0];
+  const EIP_UINT* a = &history_[0];
+  const EIP_UINT* b = a + n;
+  const EIP_UINT* c = b + n;
+  if (window_ == 3)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      out[i] = max(min(a[i], b[i]), min(max(a[i], b[i]), c[i]));
+    }
+  }
+  else
+  {
+    const EIP_UINT* d = c + n;
+    const EIP_UINT* e = d + n;
+    for (size_t i = 0; i < n; ++i)
+    {
+      // the lowest and highest of a to d can not be the median, leaving three
+      EIP_UINT f = max(min(a[i], b[i]), min(c[i], d[i]));
+      EIP_UINT g = min(max(a[i], b[i]), max(c[i], d[i]));
+      out[i] = max(min(f, g), min(max(f, g), e[i]));
+    }
+  }
+}
+
+}  // namespace omron_os32c_driver
@@ -0,0 +1,221 @@
+/**
+Software License Agreement (BSD)
+
+\file      timeout_tcp_socket.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "omron_os32c_driver/timeout_tcp_socket.h"
+
+namespace omron_os32c_driver {
+
+static string errorMessage(const string& what, int error)
+{
+  return what + ": " + strerror(error);
+}
+
+TimeoutTCPSocket::TimeoutTCPSocket(double connect_timeout, double request_timeout)
+  : fd_(-1), connect_timeout_(connect_timeout), request_timeout_(0)
+{
+  if (!(connect_timeout > 0))
+  {
+    throw std::invalid_argument("Connect timeout must be positive");
+  }
+  setRequestTimeout(request_timeout);
+}
+
+TimeoutTCPSocket::~TimeoutTCPSocket()
+{
+  close();
+}
+
+void TimeoutTCPSocket::setRequestTimeout(double timeout)
+{
+  if (!(timeout >= 0))
+  {
+    throw std::invalid_argument("Request timeout must not be negative");
+  }
+  request_timeout_ = timeout;
+}
+
+void TimeoutTCPSocket::open(string hostname, string port)
+{
+  close();
+
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = NULL;
+  int result = getaddrinfo(hostname.c_str(), port.c_str(), &hints, &addresses);
+  if (result != 0)
+  {
+    throw std::runtime_error("Cannot resolve " + hostname + ": " + gai_strerror(result));
+  }
+
+  // connect without blocking, so that an unreachable host fails after the timeout
+  int fd = ::socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+  if (fd < 0)
+  {
+    int error = errno;
+    freeaddrinfo(addresses);
+    throw std::runtime_error(errorMessage("Cannot create socket", error));
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  fd_ = fd;
+  result = ::connect(fd, addresses->ai_addr, addresses->ai_addrlen);
+  int error = errno;
+  freeaddrinfo(addresses);
+  try
+  {
+    if (result != 0)
+    {
+      if (error != EINPROGRESS)
+      {
+        throw std::runtime_error(errorMessage("Cannot connect to " + hostname, error));
+      }
+      wait(POLLOUT, connect_timeout_, "connecting to " + hostname);
+      socklen_t len = sizeof(error);
+      getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+      if (error != 0)
+      {
+        throw std::runtime_error(errorMessage("Cannot connect to " + hostname, error));
+      }
+    }
+  }
+  catch (...)
+  {
+    close();
+    throw;
+  }
+
+  // requests are small and answered one at a time
+  int flag = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+void TimeoutTCPSocket::close()
+{
+  int fd = fd_.exchange(-1);
+  if (fd >= 0)
+  {
+    ::close(fd);
+  }
+}
+
+void TimeoutTCPSocket::abort()
+{
+  int fd = fd_;
+  if (fd >= 0)
+  {
+    shutdown(fd, SHUT_RDWR);
+  }
+}
+
+size_t TimeoutTCPSocket::send(const boost::asio::const_buffer& buf)
+{
+  const char* data = boost::asio::buffer_cast<const char*>(buf);
+  size_t size = boost::asio::buffer_size(buf);
+  size_t sent = 0;
+  while (sent < size)
+  {
+    wait(POLLOUT, request_timeout_, "sending");
+    ssize_t n = ::send(fd_, data + sent, size - sent, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      {
+        continue;
+      }
+      throw std::runtime_error(errorMessage("Send failed", errno));
+    }
+    sent += n;
+  }
+  return sent;
+}
+
+size_t TimeoutTCPSocket::receive(const boost::asio::mutable_buffer& buf)
+{
+  while (true)
+  {
+    wait(POLLIN, request_timeout_, "receiving");
+    ssize_t n = ::recv(fd_, boost::asio::buffer_cast<char*>(buf), boost::asio::buffer_size(buf), 0);
+    if (n > 0)
+    {
+      return n;
+    }
+    if (n == 0)
+    {
+      throw std::runtime_error("Connection closed");
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+      throw std::runtime_error(errorMessage("Receive failed", errno));
+    }
+  }
+}
+
+void TimeoutTCPSocket::wait(short events, double timeout, const string& what)
+{
+  if (fd_ < 0)
+  {
+    throw std::runtime_error("Socket is not open");
+  }
+  pollfd pfd;
+  pfd.fd = fd_;
+  pfd.events = events;
+  int timeout_ms = timeout > 0 ? std::max(1, static_cast<int>(ceil(timeout * 1000))) : -1;
+  while (true)
+  {
+    pfd.revents = 0;
+    int result = poll(&pfd, 1, timeout_ms);
+    if (result > 0)
+    {
+      // errors and hangups are reported by the call that follows
+      return;
+    }
+    if (result == 0)
+    {
+      throw std::runtime_error("Timed out " + what);
+    }
+    if (errno != EINTR)
+    {
+      throw std::runtime_error(errorMessage("Poll failed " + what, errno));
+    }
+  }
+}
+
+}  // namespace omron_os32c_driver
@@ -0,0 +1,179 @@
+/**
+Software License Agreement (BSD)
+
+\file      work_stealing_pool.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <unistd.h>
+#include <stdexcept>
+
+#include "omron_os32c_driver/work_stealing_pool.h"
+
+namespace omron_os32c_driver {
+
+WorkStealingPool::WorkStealingPool(size_t num_workers) : num_workers_(num_workers), task_(NULL), failed_(false)
+{
+  if (num_workers_ == 0)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_workers_ = cpus > 0 ? cpus : 1;
+  }
+}
+
+void WorkStealingPool::run(size_t num_tasks, ParallelTask* task)
+{
+  task_ = task;
+  failed_ = false;
+  error_.clear();
+  pthread_mutex_init(&error_mutex_, NULL);
+  ranges_.resize(num_workers_);
+  for (size_t i = 0; i < num_workers_; ++i)
+  {
+    pthread_mutex_init(&ranges_[i].mutex, NULL);
+    ranges_[i].begin = num_tasks * i / num_workers_;
+    ranges_[i].end = num_tasks * (i + 1) / num_workers_;
+  }
+
+  // the calling thread is worker 0. If a thread cannot be started, the others steal its share.
+  vector<Worker> workers(num_workers_);
+  vector<pthread_t> threads;
+  for (size_t i = 1; i < num_workers_; ++i)
+  {
+    workers[i].pool = this;
+    workers[i].index = i;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, runWorker, &workers[i]) == 0)
+    {
+      threads.push_back(thread);
+    }
+  }
+  work(0);
+  for (size_t i = 0; i < threads.size(); ++i)
+  {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (size_t i = 0; i < num_workers_; ++i)
+  {
+    pthread_mutex_destroy(&ranges_[i].mutex);
+  }
+  pthread_mutex_destroy(&error_mutex_);
+  task_ = NULL;
+  if (failed_)
+  {
+    throw std::runtime_error(error_);
+  }
+}
+
+void* WorkStealingPool::runWorker(void* arg)
+{
+  Worker* worker = static_cast<Worker*>(arg);
+  worker->pool->work(worker->index);
+  return NULL;
+}
+
+void WorkStealingPool::work(size_t worker)
+{
+  size_t task;
+  while (take(worker, &task) || (steal(worker) && take(worker, &task)))
+  {
+    pthread_mutex_lock(&error_mutex_);
+    bool failed = failed_;
+    pthread_mutex_unlock(&error_mutex_);
+    if (failed)
+    {
+      return;
+    }
+
+    try
+    {
+      task_->run(task, worker);
+    }
+    catch (std::exception& ex)
+    {
+      pthread_mutex_lock(&error_mutex_);
+      if (!failed_)
+      {
+        failed_ = true;
+        error_ = ex.what();
+      }
+      pthread_mutex_unlock(&error_mutex_);
+      return;
+    }
+  }
+}
+
+bool WorkStealingPool::take(size_t worker, size_t* task)
+{
+  Range& range = ranges_[worker];
+  pthread_mutex_lock(&range.mutex);
+  bool taken = range.begin < range.end;
+  if (taken)
+  {
+    *task = range.begin++;
+  }
+  pthread_mutex_unlock(&range.mutex);
+  return taken;
+}
+
+bool WorkStealingPool::steal(size_t worker)
+{
+  for (;;)
+  {
+    size_t victim = worker;
+    size_t most = 0;
+    for (size_t i = 0; i < num_workers_; ++i)
+    {
+      pthread_mutex_lock(&ranges_[i].mutex);
+      size_t remaining = ranges_[i].end - ranges_[i].begin;
+      pthread_mutex_unlock(&ranges_[i].mutex);
+      if (i != worker && remaining > most)
+      {
+        victim = i;
+        most = remaining;
+      }
+    }
+    if (most == 0)
+    {
+      return false;
+    }
+
+    // the victim may have run down its range since it was measured, in which case look again
+    Range& range = ranges_[victim];
+    pthread_mutex_lock(&range.mutex);
+    size_t begin = range.begin + (range.end - range.begin) / 2;
+    size_t end = range.end;
+    range.end = begin;
+    pthread_mutex_unlock(&range.mutex);
+    if (begin < end)
+    {
+      Range& own = ranges_[worker];
+      pthread_mutex_lock(&own.mutex);
+      own.begin = begin;
+      own.end = end;
+      pthread_mutex_unlock(&own.mutex);
+      return true;
+    }
+  }
+}
+
+}  // namespace omron_os32c_driver
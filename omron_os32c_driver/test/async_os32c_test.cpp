@@ -0,0 +1,176 @@
+/**
+Software License Agreement (BSD)
+
+\file      async_os32c_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <utility>
+#include <gtest/gtest.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/make_shared.hpp>
+
+#include "omron_os32c_driver/async_os32c.h"
+#include "odva_ethernetip/socket/test_socket.h"
+
+using boost::asio::awaitable;
+using boost::make_shared;
+using eip::socket::TestSocket;
+using namespace omron_os32c_driver;
+
+/**
+ * Bind a listening socket to a free port on the loopback interface. Connections
+ * to it complete, but nothing is ever sent on them.
+ * @param port Set to the port listened on
+ * @return The listening socket
+ */
+static int listenOnLoopback(std::string* port)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  bind(fd, reinterpret_cast<sockaddr*>(&addr), len);
+  listen(fd, 4);
+  getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+  *port = std::to_string(ntohs(addr.sin_port));
+  return fd;
+}
+
+class AsyncOS32CTest : public ::testing ::Test
+{
+public:
+  AsyncOS32CTest()
+    : pool_(2), os32c_(make_shared<OS32C>(make_shared<TestSocket>(), make_shared<TestSocket>())), error_(0)
+  {
+  }
+
+  /**
+   * Run a coroutine to completion, recording the error code it ends with
+   */
+  void run(std::function<awaitable<void>()> coroutine)
+  {
+    boost::asio::co_spawn(io_context_, [this, coroutine]() -> awaitable<void> {
+      try
+      {
+        co_await coroutine();
+      }
+      catch (boost::system::system_error& ex)
+      {
+        error_ = ex.code().value();
+      }
+    }, boost::asio::detached);
+    io_context_.run();
+    io_context_.restart();
+  }
+
+protected:
+  boost::asio::io_context io_context_;
+  boost::asio::thread_pool pool_;
+  boost::shared_ptr<OS32C> os32c_;
+  int error_;
+};
+
+TEST_F(AsyncOS32CTest, test_call)
+{
+  AsyncOS32C sensor(io_context_.get_executor(), pool_, os32c_);
+  int result = 0;
+  run([&]() -> awaitable<void> {
+    result = co_await sensor.call<int>([](OS32C& os32c) { return 42; });
+  });
+  EXPECT_EQ(42, result);
+  EXPECT_EQ(0, error_);
+
+  // exceptions thrown on the pool come out of the co_await
+  bool thrown = false;
+  run([&]() -> awaitable<void> {
+    try
+    {
+      co_await sensor.call<int>([](OS32C& os32c) -> int { throw std::logic_error("bad data"); });
+    }
+    catch (std::logic_error& ex)
+    {
+      thrown = true;
+    }
+  });
+  EXPECT_TRUE(thrown);
+}
+
+TEST_F(AsyncOS32CTest, test_timeout)
+{
+  AsyncOS32C sensor(io_context_.get_executor(), pool_, os32c_, std::chrono::milliseconds(10));
+  run([&]() -> awaitable<void> {
+    co_await sensor.call<int>([](OS32C& os32c) {
+      usleep(100000);
+      return 1;
+    });
+  });
+  EXPECT_EQ(boost::asio::error::timed_out, error_);
+  pool_.join();
+}
+
+TEST_F(AsyncOS32CTest, test_cancel)
+{
+  AsyncOS32C sensor(io_context_.get_executor(), pool_, os32c_);
+  boost::asio::steady_timer timer(io_context_, std::chrono::milliseconds(10));
+  timer.async_wait([&sensor](const boost::system::error_code& ec) { sensor.cancel(); });
+  run([&]() -> awaitable<void> {
+    co_await sensor.call<int>([](OS32C& os32c) {
+      usleep(100000);
+      return 1;
+    });
+  });
+  EXPECT_EQ(boost::asio::error::operation_aborted, error_);
+  pool_.join();
+}
+
+TEST_F(AsyncOS32CTest, test_wedged_sensor)
+{
+  // a sensor that accepts the session but never answers, with no request timeout
+  std::string port;
+  int listener = listenOnLoopback(&port);
+  boost::shared_ptr<TimeoutTCPSocket> socket = make_shared<TimeoutTCPSocket>(1, 0);
+  socket->open("127.0.0.1", port);
+  boost::shared_ptr<OS32C> os32c = make_shared<OS32C>(socket, make_shared<TestSocket>());
+  AsyncOS32C sensor(io_context_.get_executor(), pool_, os32c, std::chrono::milliseconds(50), socket);
+
+  run([&]() -> awaitable<void> { co_await sensor.getSingleRRScan(); });
+  EXPECT_EQ(boost::asio::error::timed_out, error_);
+
+  // the blocked request was aborted, so the strand is free for the next call
+  error_ = 0;
+  int result = 0;
+  run([&]() -> awaitable<void> {
+    result = co_await sensor.call<int>([](OS32C& os32c) { return 42; });
+  });
+  EXPECT_EQ(0, error_);
+  EXPECT_EQ(42, result);
+  pool_.join();
+  close(listener);
+}
@@ -0,0 +1,160 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_selection_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/os32c.h"
+
+using namespace omron_os32c_driver;
+
+class BeamSelectionTest : public ::testing ::Test
+{
+};
+
+TEST_F(BeamSelectionTest, test_all_beams)
+{
+  BeamSelection bs;
+  bs.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  EXPECT_EQ(677, bs.getNumBeams());
+  EXPECT_EQ(677, bs.getNumSlots());
+  EXPECT_TRUE(bs.isContiguous());
+
+  EIP_BYTE mask[88];
+  bs.getMask(mask);
+  for (size_t i = 0; i < 84; ++i)
+  {
+    EXPECT_EQ(0xFF, mask[i]);
+  }
+  EXPECT_EQ(0x1F, mask[84]);
+  EXPECT_EQ(0, mask[85]);
+  EXPECT_EQ(0, mask[86]);
+  EXPECT_EQ(0, mask[87]);
+}
+
+TEST_F(BeamSelectionTest, test_matches_single_sector_mask)
+{
+  BeamSelection bs;
+  bs.addSector(0.6911503837897546, -0.7051130178057091);
+  EIP_BYTE mask[88];
+  bs.getMask(mask);
+  for (size_t i = 0; i < 29; ++i)
+  {
+    EXPECT_EQ(0, mask[i]);
+  }
+  EXPECT_EQ(0x80, mask[29]);
+  for (size_t i = 30; i < 55; ++i)
+  {
+    EXPECT_EQ(0xFF, mask[i]);
+  }
+  for (size_t i = 55; i < 88; ++i)
+  {
+    EXPECT_EQ(0, mask[i]);
+  }
+}
+
+TEST_F(BeamSelectionTest, test_front_and_rear)
+{
+  BeamSelection bs;
+  // 10 beams at the CCW end, 10 at the CW end
+  bs.addSector(OS32C::calcBeamCentre(0), OS32C::calcBeamCentre(9));
+  bs.addSector(OS32C::calcBeamCentre(667), OS32C::calcBeamCentre(676));
+  EXPECT_EQ(20, bs.getNumBeams());
+  EXPECT_EQ(677, bs.getNumSlots());
+  EXPECT_FALSE(bs.isContiguous());
+  EXPECT_EQ(0, bs.getFirstBeam());
+  EXPECT_EQ(676, bs.getLastBeam());
+
+  EIP_BYTE mask[88];
+  bs.getMask(mask);
+  EXPECT_EQ(0xFF, mask[0]);
+  EXPECT_EQ(0x03, mask[1]);
+  EXPECT_EQ(0, mask[2]);
+  EXPECT_EQ(0, mask[82]);
+  EXPECT_EQ(0xF8, mask[83]);
+  EXPECT_EQ(0x1F, mask[84]);
+}
+
+TEST_F(BeamSelectionTest, test_decimation)
+{
+  BeamSelection bs;
+  bs.addSector(OS32C::calcBeamCentre(100), OS32C::calcBeamCentre(200));
+  bs.setDecimation(3);
+  EXPECT_EQ(3, bs.getDecimation());
+  ASSERT_EQ(34, bs.getNumBeams());
+  EXPECT_EQ(34, bs.getNumSlots());
+  EXPECT_TRUE(bs.isContiguous());
+  EXPECT_EQ(100, bs.getBeams()[0]);
+  EXPECT_EQ(103, bs.getBeams()[1]);
+  EXPECT_EQ(199, bs.getLastBeam());
+  EXPECT_THROW(bs.setDecimation(0), std::invalid_argument);
+}
+
+TEST_F(BeamSelectionTest, test_exclusion)
+{
+  BeamSelection bs;
+  bs.addSector(OS32C::calcBeamCentre(10), OS32C::calcBeamCentre(19));
+  bs.excludeSector(OS32C::calcBeamCentre(12), OS32C::calcBeamCentre(13));
+  bs.excludeBeam(19);
+  ASSERT_EQ(7, bs.getNumBeams());
+  EXPECT_EQ(9, bs.getNumSlots());
+  EXPECT_EQ(11, bs.getBeams()[1]);
+  EXPECT_EQ(14, bs.getBeams()[2]);
+  EXPECT_EQ(18, bs.getLastBeam());
+  EXPECT_THROW(bs.excludeBeam(677), std::invalid_argument);
+}
+
+TEST_F(BeamSelectionTest, test_expand)
+{
+  BeamSelection bs;
+  bs.addSector(OS32C::calcBeamCentre(10), OS32C::calcBeamCentre(19));
+  bs.excludeSector(OS32C::calcBeamCentre(12), OS32C::calcBeamCentre(13));
+  vector<float> values;
+  for (int i = 0; i < bs.getNumBeams(); ++i)
+  {
+    values.push_back(i);
+  }
+  bs.expand(values, -1);
+  ASSERT_EQ(10, values.size());
+  EXPECT_FLOAT_EQ(0, values[0]);
+  EXPECT_FLOAT_EQ(1, values[1]);
+  EXPECT_FLOAT_EQ(-1, values[2]);
+  EXPECT_FLOAT_EQ(-1, values[3]);
+  EXPECT_FLOAT_EQ(2, values[4]);
+  EXPECT_FLOAT_EQ(7, values[9]);
+
+  values.resize(3);
+  EXPECT_THROW(bs.expand(values, -1), std::invalid_argument);
+}
+
+TEST_F(BeamSelectionTest, test_invalid_sectors)
+{
+  BeamSelection bs;
+  EXPECT_THROW(bs.addSector(2.3631758089456514, -0.7051130178057091), std::invalid_argument);
+  EXPECT_THROW(bs.addSector(0.6911503837897546, -2.3631758089456514), std::invalid_argument);
+  EXPECT_THROW(bs.addSector(0.6911503837897546, 0.6911503837897546), std::invalid_argument);
+  EXPECT_EQ(0, bs.getNumBeams());
+}
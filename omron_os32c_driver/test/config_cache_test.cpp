@@ -0,0 +1,87 @@
+/**
+Software License Agreement (BSD)
+
+\file      config_cache_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include "omron_os32c_driver/config_cache.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
+
+using namespace boost::asio;
+using namespace omron_os32c_driver;
+using namespace eip;
+using namespace eip::serialization;
+
+class ConfigCacheTest : public ::testing ::Test
+{
+};
+
+TEST_F(ConfigCacheTest, test_round_trip)
+{
+  ConfigCache cache;
+  EXPECT_FALSE(cache.valid);
+  cache.checksum = 0x55AA;
+  cache.range_report_format = 1;
+  cache.reflectivity_report_format = 2;
+  cache.num_beams = 677;
+  for (size_t i = 0; i < sizeof(cache.beam_selection_mask); ++i)
+  {
+    cache.beam_selection_mask[i] = i;
+  }
+
+  EIP_BYTE d[96];
+  EXPECT_EQ(sizeof(d), cache.getLength());
+  BufferWriter writer(buffer(d));
+  cache.serialize(writer);
+  EXPECT_EQ(sizeof(d), writer.getByteCount());
+  EXPECT_EQ(0xAA, d[0]);
+  EXPECT_EQ(0x55, d[1]);
+  EXPECT_EQ(1, d[2]);
+  EXPECT_EQ(2, d[4]);
+  EXPECT_EQ(0xA5, d[6]);
+  EXPECT_EQ(0x02, d[7]);
+  EXPECT_EQ(0, d[8]);
+  EXPECT_EQ(87, d[95]);
+
+  BufferReader reader(buffer(d));
+  ConfigCache read;
+  read.deserialize(reader);
+  EXPECT_EQ(sizeof(d), reader.getByteCount());
+  EXPECT_TRUE(read.valid);
+  EXPECT_EQ(0x55AA, read.checksum);
+  EXPECT_EQ(1, read.range_report_format);
+  EXPECT_EQ(2, read.reflectivity_report_format);
+  EXPECT_EQ(677, read.num_beams);
+  EXPECT_EQ(0, memcmp(cache.beam_selection_mask, read.beam_selection_mask, sizeof(read.beam_selection_mask)));
+}
+
+TEST_F(ConfigCacheTest, test_short_buffer)
+{
+  EIP_BYTE d[50];
+  BufferReader reader(buffer(d));
+  ConfigCache cache;
+  EXPECT_THROW(cache.deserialize(reader), std::length_error);
+}
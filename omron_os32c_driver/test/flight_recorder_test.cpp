@@ -0,0 +1,185 @@
+/**
+Software License Agreement (BSD)
+
+\file      flight_recorder_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/flight_recorder.h"
+
+using namespace omron_os32c_driver;
+
+class FlightRecorderTest : public ::testing ::Test
+{
+public:
+  FlightRecorderTest()
+  {
+    char directory[] = "/tmp/os32c_flight_test_XXXXXX";
+    directory_ = mkdtemp(directory);
+    rr_.header.num_beams = 2;
+    rr_.range_data.resize(2);
+    rr_.reflectance_data.resize(2, 9);
+  }
+
+  ~FlightRecorderTest()
+  {
+    vector<string> files = listFiles();
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+      unlink(files[i].c_str());
+    }
+    rmdir(directory_.c_str());
+  }
+
+  void record(FlightRecorder& recorder, EIP_UDINT scan_count, EIP_UINT stop_reasons)
+  {
+    rr_.header.scan_count = scan_count;
+    rr_.header.machine_stop_reasons = stop_reasons;
+    rr_.range_data.assign(2, 1000 + scan_count);
+    recorder.scanReceived(ScanView(rr_));
+  }
+
+  vector<string> listFiles()
+  {
+    vector<string> files;
+    DIR* dir = opendir(directory_.c_str());
+    for (dirent* entry = readdir(dir); dir && entry; entry = readdir(dir))
+    {
+      if (entry->d_name[0] != '.')
+      {
+        files.push_back(directory_ + "/" + entry->d_name);
+      }
+    }
+    if (dir)
+    {
+      closedir(dir);
+    }
+    return files;
+  }
+
+  void readFile(const string& filename, FlightRecorderFileHeader* header, vector<FlightRecord>* records)
+  {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    file.read(reinterpret_cast<char*>(header), sizeof(*header));
+    ASSERT_TRUE(file.good());
+    records->resize(header->num_records);
+    file.read(reinterpret_cast<char*>(&(*records)[0]), records->size() * sizeof(FlightRecord));
+    ASSERT_TRUE(file.good());
+  }
+
+protected:
+  string directory_;
+  RangeAndReflectanceMeasurement rr_;
+};
+
+TEST_F(FlightRecorderTest, test_trigger)
+{
+  FlightRecorder recorder(4, 1, directory_);
+  for (int i = 1; i <= 5; ++i)
+  {
+    record(recorder, i, 0);
+  }
+  EXPECT_TRUE(listFiles().empty());
+
+  // a stop is written out once the scan after it has been recorded too
+  record(recorder, 6, 0x0004);
+  EXPECT_TRUE(recorder.isDumpPending());
+  EXPECT_TRUE(listFiles().empty());
+  record(recorder, 7, 0x0004);
+  EXPECT_FALSE(recorder.isDumpPending());
+  recorder.flush();
+  vector<string> files = listFiles();
+  ASSERT_EQ(1, files.size());
+
+  FlightRecorderFileHeader header;
+  vector<FlightRecord> records;
+  readFile(files[0], &header, &records);
+  EXPECT_STREQ("OS32CFR", header.magic);
+  EXPECT_EQ(sizeof(FlightRecord), header.record_size);
+  ASSERT_EQ(4, header.num_records);
+  EXPECT_EQ(2, header.trigger_record);
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_EQ(2, records[i].num_beams);
+    EXPECT_EQ(1004 + i, records[i].ranges[1]);
+    EXPECT_EQ(9, records[i].reflectance[0]);
+  }
+  EXPECT_EQ(1006, records[header.trigger_record].ranges[0]);
+
+  // the state after reconnecting is not compared with the state before
+  recorder.reset();
+  record(recorder, 8, 0);
+  EXPECT_FALSE(recorder.isDumpPending());
+}
+
+TEST_F(FlightRecorderTest, test_dump)
+{
+  EXPECT_THROW(FlightRecorder(2, 2, directory_), std::invalid_argument);
+
+  FlightRecorder recorder(10, 2, directory_);
+  record(recorder, 1, 0);
+  record(recorder, 2, 0);
+  string filename = recorder.dump();
+  recorder.flush();
+
+  FlightRecorderFileHeader header;
+  vector<FlightRecord> records;
+  readFile(filename, &header, &records);
+  ASSERT_EQ(2, header.num_records);
+  EXPECT_EQ(2, header.trigger_record);
+  EXPECT_EQ(1001, records[0].ranges[0]);
+  EXPECT_EQ(1002, records[1].ranges[0]);
+
+  FlightRecorder missing(10, 2, directory_ + "/missing");
+  EXPECT_THROW(missing.dump(), std::runtime_error);
+}
+
+TEST_F(FlightRecorderTest, test_max_files)
+{
+  // older files from before, named for the time they were written
+  const char* old_names[] = { "/os32c_flight_20200101_000000_000.bin", "/os32c_flight_20200101_000001_000.bin",
+                              "/os32c_flight_20200101_000002_000.bin" };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    std::ofstream file((directory_ + old_names[i]).c_str());
+  }
+
+  FlightRecorder recorder(4, 1, directory_, 2);
+  record(recorder, 1, 0);
+  string filename = recorder.dump();
+  recorder.flush();
+
+  // only the newest of the old files is kept along with the new one
+  vector<string> files = listFiles();
+  std::sort(files.begin(), files.end());
+  ASSERT_EQ(2, files.size());
+  EXPECT_EQ(directory_ + old_names[2], files[0]);
+  EXPECT_EQ(filename, files[1]);
+}
@@ -0,0 +1,121 @@
+/**
+Software License Agreement (BSD)
+
+\file      latest_scan_buffer_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <pthread.h>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/latest_scan_buffer.h"
+
+using namespace omron_os32c_driver;
+
+class LatestScanBufferTest : public ::testing ::Test
+{
+};
+
+TEST_F(LatestScanBufferTest, test_latest)
+{
+  LatestScanBuffer buffer;
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(0, buffer.getLatest().stamp);
+  EXPECT_TRUE(buffer.getLatest().ranges.empty());
+
+  RangeAndReflectanceMeasurement rr;
+  rr.header.num_beams = 2;
+  rr.range_data.resize(2);
+  rr.reflectance_data.resize(2, 7);
+  for (int i = 1; i <= 3; ++i)
+  {
+    rr.header.scan_count = i;
+    rr.range_data[0] = 1000 + i;
+    buffer.write(ScanView(rr), i);
+  }
+
+  // only the newest of the scans written since the last update is seen
+  EXPECT_TRUE(buffer.update());
+  const LatestScan& latest = buffer.getLatest();
+  EXPECT_EQ(3, latest.header.scan_count);
+  EXPECT_EQ(3, latest.stamp);
+  ASSERT_EQ(2, latest.ranges.size());
+  EXPECT_EQ(1003, latest.ranges[0]);
+  ASSERT_EQ(2, latest.reflectance.size());
+  EXPECT_EQ(7, latest.reflectance[1]);
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(3, buffer.getLatest().header.scan_count);
+
+  MeasurementReport mr;
+  mr.header.scan_count = 4;
+  mr.header.num_beams = 1;
+  mr.measurement_data.resize(1, 2000);
+  buffer.write(ScanView(mr), 4);
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(4, buffer.getLatest().header.scan_count);
+  EXPECT_TRUE(buffer.getLatest().reflectance.empty());
+}
+
+namespace {
+
+const int NUM_SCANS = 20000;
+
+void* writeScans(void* arg)
+{
+  LatestScanBuffer* buffer = static_cast<LatestScanBuffer*>(arg);
+  RangeAndReflectanceMeasurement rr;
+  rr.header.num_beams = 677;
+  rr.reflectance_data.resize(677);
+  for (int i = 1; i <= NUM_SCANS; ++i)
+  {
+    rr.header.scan_count = i;
+    rr.range_data.assign(677, i);
+    buffer->write(ScanView(rr), i);
+  }
+  return NULL;
+}
+
+}  // namespace
+
+TEST_F(LatestScanBufferTest, test_concurrent)
+{
+  LatestScanBuffer buffer;
+  pthread_t writer;
+  ASSERT_EQ(0, pthread_create(&writer, NULL, writeScans, &buffer));
+
+  // every snapshot is a whole scan, and scans only ever move forward
+  EIP_UDINT last_count = 0;
+  while (last_count < NUM_SCANS)
+  {
+    if (!buffer.update())
+    {
+      continue;
+    }
+    const LatestScan& latest = buffer.getLatest();
+    ASSERT_GT(latest.header.scan_count, last_count);
+    ASSERT_EQ(677, latest.ranges.size());
+    EXPECT_EQ(latest.header.scan_count, latest.ranges.front());
+    EXPECT_EQ(latest.header.scan_count, latest.ranges.back());
+    EXPECT_EQ(latest.header.scan_count, latest.stamp);
+    last_count = latest.header.scan_count;
+  }
+  pthread_join(writer, NULL);
+}
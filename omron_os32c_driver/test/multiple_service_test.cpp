@@ -0,0 +1,126 @@
+/**
+Software License Agreement (BSD)
+
+\file      multiple_service_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <boost/make_shared.hpp>
+
+#include "omron_os32c_driver/multiple_service_request.h"
+#include "omron_os32c_driver/multiple_service_response.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/serializable_primitive.h"
+
+using namespace boost::asio;
+using namespace omron_os32c_driver;
+using namespace eip;
+using namespace eip::serialization;
+
+class MultipleServiceTest : public ::testing ::Test
+{
+};
+
+TEST_F(MultipleServiceTest, test_serialize_request)
+{
+  MultipleServiceRequest req;
+  EXPECT_EQ(0, req.addGetAttribute(0x73, 1, 4));
+  EXPECT_EQ(1, req.addSetAttribute(0x73, 1, 5, boost::make_shared<SerializablePrimitive<EIP_UINT> >(0x0102)));
+  EXPECT_EQ(2, req.getCount());
+
+  EIP_BYTE d[24];
+  EXPECT_EQ(sizeof(d), req.getLength());
+  BufferWriter writer(buffer(d));
+  req.serialize(writer);
+  EXPECT_EQ(sizeof(d), writer.getByteCount());
+
+  // count and offsets
+  EXPECT_EQ(2, d[0]);
+  EXPECT_EQ(0, d[1]);
+  EXPECT_EQ(6, d[2]);
+  EXPECT_EQ(0, d[3]);
+  EXPECT_EQ(14, d[4]);
+  EXPECT_EQ(0, d[5]);
+
+  // Get_Attribute_Single 0x73/1/4
+  EXPECT_EQ(0x0E, d[6]);
+  EXPECT_EQ(3, d[7]);
+  EXPECT_EQ(0x20, d[8]);
+  EXPECT_EQ(0x73, d[9]);
+  EXPECT_EQ(0x24, d[10]);
+  EXPECT_EQ(0x01, d[11]);
+  EXPECT_EQ(0x30, d[12]);
+  EXPECT_EQ(0x04, d[13]);
+
+  // Set_Attribute_Single 0x73/1/5 with data
+  EXPECT_EQ(0x10, d[14]);
+  EXPECT_EQ(3, d[15]);
+  EXPECT_EQ(0x05, d[21]);
+  EXPECT_EQ(0x02, d[22]);
+  EXPECT_EQ(0x01, d[23]);
+}
+
+TEST_F(MultipleServiceTest, test_deserialize_response)
+{
+  EIP_BYTE d[] = {
+    3,    0,    8,    0,    14,   0,    22,   0,     // count and offsets
+    0x8E, 0,    0,    0,    0x02, 0x01,              // get reply with data
+    0x8E, 0,    0,    1,    0xAA, 0xBB, 0x34, 0x12,  // get reply with additional status
+    0x90, 0,    0x0F, 0,                             // failed set reply
+  };
+
+  MultipleServiceResponse resp;
+  BufferReader reader(buffer(d));
+  resp.deserialize(reader, sizeof(d));
+  EXPECT_EQ(sizeof(d), reader.getByteCount());
+  ASSERT_EQ(3, resp.getCount());
+
+  SerializablePrimitive<EIP_UINT> value;
+  EXPECT_EQ(0x0102, resp.getReplyDataAs(0, value).data);
+  EXPECT_EQ(0x1234, resp.getReplyDataAs(1, value).data);
+  EXPECT_EQ(0x90, resp.getReply(2).service);
+  EXPECT_EQ(0x0F, resp.getReply(2).general_status);
+  EXPECT_EQ(0, resp.getReply(2).data.size());
+  EXPECT_NO_THROW(resp.checkReply(0));
+  EXPECT_THROW(resp.checkReply(2), std::runtime_error);
+  EXPECT_THROW(resp.getReplyDataAs(2, value), std::runtime_error);
+
+  // serializing gives back the same replies, minus the additional status
+  EIP_BYTE out[24];
+  EXPECT_EQ(sizeof(out), resp.getLength());
+  BufferWriter writer(buffer(out));
+  resp.serialize(writer);
+  EXPECT_EQ(sizeof(out), writer.getByteCount());
+  EXPECT_EQ(20, out[6]);
+  EXPECT_EQ(0x34, out[18]);
+  EXPECT_EQ(0x90, out[20]);
+}
+
+TEST_F(MultipleServiceTest, test_deserialize_bad_offsets)
+{
+  EIP_BYTE d[] = { 2, 0, 6, 0, 20, 0, 0x8E, 0, 0, 0, 0x02, 0x01 };
+  MultipleServiceResponse resp;
+  BufferReader reader(buffer(d));
+  EXPECT_THROW(resp.deserialize(reader, sizeof(d)), std::logic_error);
+}
@@ -24,12 +24,17 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 */
 
 
+#include <cmath>
+#include <limits>
 #include <gtest/gtest.h>
 #include <boost/make_shared.hpp>
 
 #include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/raw_scan_conversion.h"
+#include "omron_os32c_driver/scan_conversions.h"
 #include "odva_ethernetip/socket/test_socket.h"
 #include "odva_ethernetip/rr_data_response.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
 #include "odva_ethernetip/serialization/serializable_buffer.h"
 #include "odva_ethernetip/serialization/serializable_primitive.h"
 
@@ -88,6 +93,14 @@ TEST_F(OS32CTest, test_calc_beam_centre)
   EXPECT_DOUBLE_EQ(-2.3596851486963333, OS32C::calcBeamCentre(676));
 }
 
+TEST_F(OS32CTest, test_max_udp_beams)
+{
+  // 1412 bytes hold the sequence count, the header and all ranges, or about
+  // half the beams with reflectance
+  EXPECT_EQ(677, OS32C::getMaxUDPBeams(false));
+  EXPECT_EQ(338, OS32C::getMaxUDPBeams(true));
+}
+
 TEST_F(OS32CTest, test_calc_beam_mask_all)
 {
   EIP_BYTE buffer[96];  // plus 32 bits on each end as guards
@@ -188,6 +201,32 @@ TEST_F(OS32CTest, test_calc_beam_invalid_args)
   EXPECT_THROW(os32c.calcBeamMask(0.6911503837897546, 0.6841690685271065, mask), std::invalid_argument);
 }
 
+TEST_F(OS32CTest, test_update_report_selection)
+{
+  BeamSelection all;
+  all.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  os32c.setBeamSelection(all);
+  EXPECT_TRUE(os32c.updateReportSelection(677));
+  EXPECT_FALSE(os32c.updateReportSelection(677));
+
+  // reports with the old number of beams keep the old selection
+  BeamSelection decimated = all;
+  decimated.setDecimation(2);
+  os32c.setBeamSelection(decimated);
+  EXPECT_EQ(339, os32c.getBeamSelection().getNumBeams());
+  EXPECT_FALSE(os32c.updateReportSelection(677));
+
+  sensor_msgs::LaserScan ls;
+  fillLaserScanStaticConfig(os32c.getReportSelection(), &ls);
+  EXPECT_FLOAT_EQ(OS32C::ANGLE_INC, ls.angle_increment);
+
+  EXPECT_TRUE(os32c.updateReportSelection(339));
+  fillLaserScanStaticConfig(os32c.getReportSelection(), &ls);
+  EXPECT_FLOAT_EQ(2 * OS32C::ANGLE_INC, ls.angle_increment);
+
+  EXPECT_THROW(os32c.setBeamSelection(BeamSelection()), std::invalid_argument);
+}
+
 TEST_F(OS32CTest, test_select_beams)
 {
   // clang-format off
@@ -367,6 +406,273 @@ TEST_F(OS32CTest, test_select_beams)
   EXPECT_EQ(0x00, ts->tx_buffer[135]);
 }
 
+/**
+ * Test socket that answers each request with the next of a list of responses
+ * and counts the requests sent
+ */
+class SequenceTestSocket : public TestSocket
+{
+public:
+  SequenceTestSocket() : num_sent(0)
+  {
+  }
+
+  virtual size_t send(const const_buffer& buf)
+  {
+    ++num_sent;
+    return TestSocket::send(buf);
+  }
+
+  virtual size_t receive(const mutable_buffer& buf)
+  {
+    const vector<uint8_t>& resp = responses.at(num_sent - 1);
+    rx_buffer = buffer(resp);
+    return TestSocket::receive(buf);
+  }
+
+  vector<vector<uint8_t> > responses;
+  size_t num_sent;
+};
+
+/**
+ * Wrap the message router response to a service in an RR data response packet
+ */
+static vector<uint8_t> makeRRDataResponse(EIP_USINT service, const vector<uint8_t>& data)
+{
+  size_t item_length = 4 + data.size();
+  size_t encap_length = 16 + item_length;
+  // clang-format off
+  uint8_t header[] = {
+    0x6F, 0x00, (uint8_t)(encap_length & 0xFF), (uint8_t)(encap_length >> 8), 0x05, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xB2, 0x00, (uint8_t)(item_length & 0xFF), (uint8_t)(item_length >> 8),
+    (uint8_t)(service | 0x80), 0x00, 0x00, 0x00,
+  };
+  // clang-format on
+  vector<uint8_t> packet(header, header + sizeof(header));
+  packet.insert(packet.end(), data.begin(), data.end());
+  return packet;
+}
+
+/**
+ * Wrap the replies to a multiple service request in an RR data response packet
+ */
+static vector<uint8_t> makeMultipleServiceResponse(const vector<vector<uint8_t> >& replies)
+{
+  vector<uint8_t> data;
+  data.push_back(replies.size());
+  data.push_back(0);
+  size_t offset = 2 * (1 + replies.size());
+  for (size_t i = 0; i < replies.size(); ++i)
+  {
+    data.push_back(offset & 0xFF);
+    data.push_back(offset >> 8);
+    offset += replies[i].size();
+  }
+  for (size_t i = 0; i < replies.size(); ++i)
+  {
+    data.insert(data.end(), replies[i].begin(), replies[i].end());
+  }
+  return makeRRDataResponse(0x0A, data);
+}
+
+/**
+ * Reply to a single get or set attribute request within a multiple service response
+ */
+static vector<uint8_t> makeReply(EIP_USINT service, EIP_USINT status, const vector<uint8_t>& data)
+{
+  vector<uint8_t> reply;
+  reply.push_back(service | 0x80);
+  reply.push_back(0);
+  reply.push_back(status);
+  reply.push_back(0);
+  reply.insert(reply.end(), data.begin(), data.end());
+  return reply;
+}
+
+/**
+ * Reply to reading the range format, reflectivity format and beam mask
+ */
+static vector<uint8_t> makeConfigReadResponse(EIP_UINT range_format, EIP_UINT reflectivity_format,
+                                              const BeamSelection& selection)
+{
+  vector<uint8_t> range_data(2), refl_data(2), mask_data(88);
+  range_data[0] = range_format;
+  refl_data[0] = reflectivity_format;
+  selection.getMask(&mask_data[0]);
+
+  vector<vector<uint8_t> > replies;
+  replies.push_back(makeReply(0x0E, 0, range_data));
+  replies.push_back(makeReply(0x0E, 0, refl_data));
+  replies.push_back(makeReply(0x0E, 0, mask_data));
+  return makeMultipleServiceResponse(replies);
+}
+
+/**
+ * Reply to a get attribute request for a report, with only the header filled in
+ */
+static vector<uint8_t> makeHeaderReadResponse(const MeasurementReportHeader& header)
+{
+  vector<uint8_t> data(header.getLength());
+  BufferWriter writer(buffer(data));
+  header.serialize(writer);
+  return makeRRDataResponse(0x0E, data);
+}
+
+TEST_F(OS32CTest, test_apply_configuration_unchanged)
+{
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  shared_ptr<SequenceTestSocket> sts = make_shared<SequenceTestSocket>();
+  sts->responses.push_back(makeConfigReadResponse(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  OS32C sensor(sts, ts_io);
+
+  EXPECT_EQ(0, sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+
+  // only the read was sent, as a multiple service packet with three requests
+  EXPECT_EQ(1, sts->num_sent);
+  EXPECT_EQ(0x0A, sts->tx_buffer[40]);
+  EXPECT_EQ(3, sts->tx_buffer[46]);
+  EXPECT_EQ(0, sts->tx_buffer[47]);
+}
+
+TEST_F(OS32CTest, test_apply_configuration_mask_only)
+{
+  BeamSelection current, selection;
+  selection.addSector(DEG2RAD(45), DEG2RAD(-45));
+  vector<vector<uint8_t> > write_replies;
+  write_replies.push_back(makeReply(0x10, 0, vector<uint8_t>()));
+  shared_ptr<SequenceTestSocket> sts = make_shared<SequenceTestSocket>();
+  sts->responses.push_back(makeConfigReadResponse(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, current));
+  sts->responses.push_back(makeMultipleServiceResponse(write_replies));
+  OS32C sensor(sts, ts_io);
+
+  EXPECT_EQ(1, sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+
+  // the write carries only the set of the beam mask attribute
+  EXPECT_EQ(2, sts->num_sent);
+  EXPECT_EQ(0x0A, sts->tx_buffer[40]);
+  EXPECT_EQ(1, sts->tx_buffer[46]);
+  EXPECT_EQ(0, sts->tx_buffer[47]);
+  EXPECT_EQ(4, sts->tx_buffer[48]);
+  EXPECT_EQ(0, sts->tx_buffer[49]);
+  EXPECT_EQ(0x10, sts->tx_buffer[50]);
+  EXPECT_EQ(0x20, sts->tx_buffer[52]);
+  EXPECT_EQ(0x73, sts->tx_buffer[53]);
+  EXPECT_EQ(0x30, sts->tx_buffer[56]);
+  EXPECT_EQ(12, sts->tx_buffer[57]);
+
+  EIP_BYTE mask[88];
+  selection.getMask(mask);
+  EXPECT_EQ(0, memcmp(mask, sts->tx_buffer + 58, sizeof(mask)));
+}
+
+TEST_F(OS32CTest, test_apply_configuration_service_error)
+{
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  vector<vector<uint8_t> > write_replies;
+  write_replies.push_back(makeReply(0x10, 0x0E, vector<uint8_t>()));
+  shared_ptr<SequenceTestSocket> sts = make_shared<SequenceTestSocket>();
+  sts->responses.push_back(makeConfigReadResponse(RANGE_MEASURE_TOF_4PS, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  sts->responses.push_back(makeMultipleServiceResponse(write_replies));
+  OS32C sensor(sts, ts_io);
+
+  EXPECT_THROW(sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection),
+               std::runtime_error);
+  EXPECT_EQ(2, sts->num_sent);
+}
+
+TEST_F(OS32CTest, test_check_config_checksum)
+{
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  shared_ptr<SequenceTestSocket> sts = make_shared<SequenceTestSocket>();
+  sts->responses.push_back(makeConfigReadResponse(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  OS32C sensor(sts, ts_io);
+
+  // nothing to compare against before a configuration is applied
+  MeasurementReportHeader header;
+  header.non_safety_config_checksum = 0x1234;
+  EXPECT_TRUE(sensor.checkConfigChecksum(header));
+
+  // the first report after applying records the checksum
+  sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection);
+  EXPECT_TRUE(sensor.checkConfigChecksum(header));
+  EXPECT_TRUE(sensor.checkConfigChecksum(header));
+
+  // and a change after that means something else reconfigured the sensor
+  header.non_safety_config_checksum = 0x4321;
+  EXPECT_FALSE(sensor.checkConfigChecksum(header));
+}
+
+TEST_F(OS32CTest, test_apply_configuration_cached)
+{
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  MeasurementReportHeader header;
+  header.range_report_format = RANGE_MEASURE_50M;
+  header.refletivity_report_format = REFLECTIVITY_MEASURE_TOT_4PS;
+  header.num_beams = selection.getNumBeams();
+  header.non_safety_config_checksum = 0x1234;
+  shared_ptr<SequenceTestSocket> sts = make_shared<SequenceTestSocket>();
+  sts->responses.push_back(makeConfigReadResponse(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  sts->responses.push_back(makeHeaderReadResponse(header));
+  header.non_safety_config_checksum = 0x4321;
+  sts->responses.push_back(makeHeaderReadResponse(header));
+  sts->responses.push_back(makeConfigReadResponse(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  OS32C sensor(sts, ts_io);
+
+  // the first apply reads the configuration back, and the next report completes the cache
+  EXPECT_EQ(0, sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  EXPECT_FALSE(sensor.getConfigCache().valid);
+  header.non_safety_config_checksum = 0x1234;
+  EXPECT_TRUE(sensor.checkConfigChecksum(header));
+  EXPECT_TRUE(sensor.getConfigCache().valid);
+  EXPECT_EQ(0x1234, sensor.getConfigCache().checksum);
+
+  // with the checksum unchanged only the header is read
+  EXPECT_EQ(0, sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  EXPECT_EQ(2, sts->num_sent);
+  EXPECT_EQ(0x0E, sts->tx_buffer[40]);
+  EXPECT_TRUE(sensor.getConfigCache().valid);
+
+  // a changed checksum falls back to reading the configuration
+  EXPECT_EQ(0, sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  EXPECT_EQ(4, sts->num_sent);
+  EXPECT_EQ(0x0A, sts->tx_buffer[40]);
+  EXPECT_FALSE(sensor.getConfigCache().valid);
+}
+
+TEST_F(OS32CTest, test_apply_configuration_seeded_cache)
+{
+  BeamSelection selection;
+  selection.addSector(DEG2RAD(45), DEG2RAD(-45));
+  ConfigCache cache;
+  cache.valid = true;
+  cache.checksum = 0x1234;
+  cache.range_report_format = RANGE_MEASURE_50M;
+  cache.reflectivity_report_format = REFLECTIVITY_MEASURE_TOT_4PS;
+  cache.num_beams = selection.getNumBeams();
+  selection.getMask(cache.beam_selection_mask);
+  MeasurementReportHeader header;
+  header.range_report_format = RANGE_MEASURE_50M;
+  header.refletivity_report_format = REFLECTIVITY_MEASURE_TOT_4PS;
+  header.num_beams = selection.getNumBeams();
+  header.non_safety_config_checksum = 0x1234;
+  shared_ptr<SequenceTestSocket> sts = make_shared<SequenceTestSocket>();
+  sts->responses.push_back(makeHeaderReadResponse(header));
+  OS32C sensor(sts, ts_io);
+  sensor.setConfigCache(cache);
+
+  // a cache saved by a previous run skips the read on a cold start
+  EXPECT_EQ(0, sensor.applyConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, selection));
+  EXPECT_EQ(1, sts->num_sent);
+  EXPECT_TRUE(sensor.checkConfigChecksum(header));
+}
+
 TEST_F(OS32CTest, test_convert_to_laserscan)
 {
   RangeAndReflectanceMeasurement rr;
@@ -433,6 +739,213 @@ TEST_F(OS32CTest, test_convert_to_laserscan)
   EXPECT_FLOAT_EQ(0, ls.intensities[9]);
 }
 
+TEST_F(OS32CTest, test_convert_to_raw_scan)
+{
+  BeamSelection selection;
+  selection.addSector(DEG2RAD(10), DEG2RAD(-10));
+  selection.excludeSector(DEG2RAD(1), DEG2RAD(-1));
+  os32c.setBeamSelection(selection);
+  os32c.updateReportSelection(selection.getNumBeams());
+
+  RangeAndReflectanceMeasurement rr;
+  rr.header.scan_rate = 38609;
+  rr.header.scan_beam_period = 42898;
+  rr.header.num_beams = selection.getNumBeams();
+  rr.range_data.resize(rr.header.num_beams);
+  rr.reflectance_data.resize(rr.header.num_beams);
+  for (size_t i = 0; i < rr.range_data.size(); ++i)
+  {
+    rr.range_data[i] = 1000 + i;
+    rr.reflectance_data[i] = i;
+  }
+  rr.range_data[0] = 0x0001;
+  rr.range_data[1] = 0xFFFF;
+
+  RawScan raw;
+  fillRawScanStaticConfig(os32c.getReportSelection(), &raw);
+  convertToRawScan(ScanView(rr), &raw);
+  EXPECT_EQ(selection.getNumBeams(), raw.indices.size());
+  EXPECT_EQ(selection.getNumBeams(), raw.ranges.size());
+  EXPECT_EQ(1002, raw.ranges[2]);
+  EXPECT_EQ(2, raw.intensities[2]);
+
+  // expanding the raw scan gives the same as converting straight to a LaserScan
+  sensor_msgs::LaserScan expected, ls;
+  fillLaserScanStaticConfig(os32c.getReportSelection(), &expected);
+  convertToLaserScan(rr, &expected);
+  expandToBeamSelection(os32c.getReportSelection(), &expected);
+  convertRawScanToLaserScan(raw, &ls);
+  EXPECT_FLOAT_EQ(expected.angle_min, ls.angle_min);
+  EXPECT_FLOAT_EQ(expected.angle_max, ls.angle_max);
+  EXPECT_FLOAT_EQ(expected.angle_increment, ls.angle_increment);
+  EXPECT_FLOAT_EQ(expected.time_increment, ls.time_increment);
+  EXPECT_FLOAT_EQ(expected.scan_time, ls.scan_time);
+  ASSERT_EQ(expected.ranges.size(), ls.ranges.size());
+  ASSERT_EQ(expected.intensities.size(), ls.intensities.size());
+  for (size_t i = 0; i < ls.ranges.size(); ++i)
+  {
+    if (std::isnan(expected.ranges[i]))
+    {
+      EXPECT_TRUE(std::isnan(ls.ranges[i]));
+    }
+    else
+    {
+      EXPECT_FLOAT_EQ(expected.ranges[i], ls.ranges[i]);
+    }
+    EXPECT_FLOAT_EQ(expected.intensities[i], ls.intensities[i]);
+  }
+}
+
+TEST_F(OS32CTest, test_convert_to_raw_scan_inverted)
+{
+  BeamSelection selection;
+  selection.addSector(DEG2RAD(10), DEG2RAD(-20));
+  selection.excludeSector(DEG2RAD(1), DEG2RAD(-1));
+  os32c.setBeamSelection(selection);
+  os32c.updateReportSelection(selection.getNumBeams());
+
+  RangeAndReflectanceMeasurement rr;
+  rr.header.num_beams = selection.getNumBeams();
+  rr.range_data.resize(rr.header.num_beams);
+  rr.reflectance_data.resize(rr.header.num_beams);
+  for (size_t i = 0; i < rr.range_data.size(); ++i)
+  {
+    rr.range_data[i] = 1000 + i;
+    rr.reflectance_data[i] = i;
+  }
+
+  // invert both the way the node does for a sensor mounted upside down
+  RawScan raw;
+  fillRawScanStaticConfig(os32c.getReportSelection(), &raw);
+  invertRawScanStaticConfig(&raw);
+  convertToRawScan(ScanView(rr), &raw);
+  invertRawScan(&raw);
+
+  sensor_msgs::LaserScan expected, ls;
+  fillLaserScanStaticConfig(os32c.getReportSelection(), &expected);
+  convertToLaserScan(rr, &expected);
+  expandToBeamSelection(os32c.getReportSelection(), &expected);
+  invertLaserScan(&expected);
+
+  // the last beam comes first, with its own intensity
+  EXPECT_FLOAT_EQ(1000 + rr.header.num_beams - 1, expected.ranges[0] * 1000);
+  EXPECT_FLOAT_EQ(rr.header.num_beams - 1, expected.intensities[0]);
+
+  convertRawScanToLaserScan(raw, &ls);
+  ASSERT_EQ(expected.ranges.size(), ls.ranges.size());
+  ASSERT_EQ(expected.intensities.size(), ls.intensities.size());
+  for (size_t i = 0; i < ls.ranges.size(); ++i)
+  {
+    if (std::isnan(expected.ranges[i]))
+    {
+      EXPECT_TRUE(std::isnan(ls.ranges[i]));
+    }
+    else
+    {
+      EXPECT_FLOAT_EQ(expected.ranges[i], ls.ranges[i]);
+    }
+    EXPECT_FLOAT_EQ(expected.intensities[i], ls.intensities[i]);
+  }
+}
+
+TEST_F(OS32CTest, test_convert_to_sector_ranges)
+{
+  SectorMinima minima;
+  minima.addSector(DEG2RAD(10), DEG2RAD(-10));
+  minima.addSector(DEG2RAD(-30), DEG2RAD(-40));
+  minima.addSector(DEG2RAD(-50), DEG2RAD(-60));
+  BeamSelection selection;
+  selection.addSector(DEG2RAD(10), DEG2RAD(-45));
+  minima.configure(selection);
+
+  // nearest return in the first sector, none in the second, and the third not measured
+  vector<EIP_UINT> ranges(selection.getNumBeams(), 0xFFFF);
+  ranges[338 - 313] = 1234;
+  minima.reduce(&ranges[0], ranges.size());
+  sensor_msgs::LaserScan ls;
+  fillLaserScanStaticConfig(selection, &ls);
+  SectorRanges msg;
+  convertToSectorRanges(minima, ls, false, &msg);
+  ASSERT_EQ(3, msg.ranges.size());
+  ASSERT_EQ(3, msg.angles.size());
+
+  // at the indices of the beams in the laser scan, where the first sector is beams 313 to 363
+  EXPECT_FLOAT_EQ(ls.angle_min + 50 * ls.angle_increment, msg.start_angles[0]);
+  EXPECT_FLOAT_EQ(ls.angle_min, msg.end_angles[0]);
+  EXPECT_FLOAT_EQ(1.234, msg.ranges[0]);
+  EXPECT_FLOAT_EQ(ls.angle_min + 25 * ls.angle_increment, msg.angles[0]);
+  EXPECT_TRUE(std::isinf(msg.ranges[1]));
+  EXPECT_TRUE(std::isnan(msg.angles[1]));
+  EXPECT_TRUE(std::isnan(msg.ranges[2]));
+  EXPECT_TRUE(std::isnan(msg.angles[2]));
+  EXPECT_TRUE(std::isnan(msg.start_angles[2]));
+
+  // counted from the other end when the scan is inverted
+  convertToSectorRanges(minima, ls, true, &msg);
+  EXPECT_FLOAT_EQ(ls.angle_max, msg.start_angles[0]);
+  EXPECT_FLOAT_EQ(ls.angle_max - 50 * ls.angle_increment, msg.end_angles[0]);
+  EXPECT_FLOAT_EQ(ls.angle_max - 25 * ls.angle_increment, msg.angles[0]);
+}
+
+TEST_F(OS32CTest, test_sector_ranges_match_laserscan)
+{
+  SectorMinima minima;
+  minima.addSector(DEG2RAD(80), DEG2RAD(40));
+  minima.addSector(DEG2RAD(30), DEG2RAD(-5));
+  minima.addSector(DEG2RAD(0), DEG2RAD(-20));
+  BeamSelection selection;
+  selection.addSector(DEG2RAD(60), DEG2RAD(-20));
+  selection.excludeSector(DEG2RAD(20), DEG2RAD(10));
+  selection.setDecimation(2);
+  minima.configure(selection);
+
+  // every range different, so the nearest return of each sector is a single beam
+  RangeAndReflectanceMeasurement rr;
+  rr.header.num_beams = selection.getNumBeams();
+  rr.range_data.resize(rr.header.num_beams);
+  for (size_t i = 0; i < rr.range_data.size(); ++i)
+  {
+    rr.range_data[i] = 1000 + (i * 37) % rr.range_data.size();
+  }
+  minima.reduce(&rr.range_data[0], rr.range_data.size());
+
+  for (int invert = 0; invert < 2; ++invert)
+  {
+    sensor_msgs::LaserScan ls;
+    fillLaserScanStaticConfig(selection, &ls);
+    convertToLaserScan(rr, &ls);
+    expandToBeamSelection(selection, &ls);
+    if (invert)
+    {
+      invertLaserScan(&ls);
+    }
+    SectorRanges msg;
+    convertToSectorRanges(minima, ls, invert, &msg);
+
+    for (size_t s = 0; s < msg.ranges.size(); ++s)
+    {
+      // the nearest return is the one in the laser scan at its angle
+      ASSERT_FALSE(std::isnan(msg.angles[s]));
+      int index = std::floor((msg.angles[s] - ls.angle_min) / ls.angle_increment + 0.5);
+      ASSERT_GE(index, 0);
+      ASSERT_LT(index, ls.ranges.size());
+      EXPECT_FLOAT_EQ(msg.ranges[s], ls.ranges[index]);
+
+      // and the nearest one in the laser scan between the bounds of the sector
+      int first = std::floor((msg.end_angles[s] - ls.angle_min) / ls.angle_increment + 0.5);
+      int last = std::floor((msg.start_angles[s] - ls.angle_min) / ls.angle_increment + 0.5);
+      float nearest = std::numeric_limits<float>::infinity();
+      for (int i = first; i <= last; ++i)
+      {
+        if (!std::isnan(ls.ranges[i]))
+        {
+          nearest = std::min(nearest, ls.ranges[i]);
+        }
+      }
+      EXPECT_FLOAT_EQ(nearest, msg.ranges[s]);
+    }
+  }
+}
 
 TEST_F(OS32CTest, test_receive_measurement_report)
 {
@@ -497,6 +1010,46 @@ TEST_F(OS32CTest, test_receive_measurement_report)
   EXPECT_EQ(0x085E, data.measurement_data[17]);
   EXPECT_EQ(0x085E, data.measurement_data[18]);
   EXPECT_EQ(0x086F, data.measurement_data[19]);
+
+  // the same datagram again is dropped before its beams are decoded
+  ts_io->rx_buffer = buffer(io_packet);
+  data.measurement_data.clear();
+  EXPECT_EQ(REPORT_DUPLICATE, os32c.tryReceiveMeasurementReportUDP(data));
+  EXPECT_TRUE(data.measurement_data.empty());
+  EXPECT_EQ(1, os32c.getReportCounters().get(REPORT_OK));
+  EXPECT_EQ(1, os32c.getReportCounters().get(REPORT_DUPLICATE));
+}
+
+TEST_F(OS32CTest, test_receive_bad_measurement_report)
+{
+  // clang-format off
+  uint8_t io_packet[] = {
+    0x01, 0x00, 0x02, 0x80, 0x08, 0x00, 0x04, 0x00,
+    0x02, 0x00, 0x15, 0x00, 0x00, 0x00,
+  };
+  // clang-format on
+
+  // a packet with only the address item is counted rather than thrown
+  ts_io->rx_buffer = buffer(io_packet);
+  MeasurementReport data;
+  EXPECT_EQ(REPORT_BAD_PACKET, os32c.tryReceiveMeasurementReportUDP(data));
+  EXPECT_EQ(1, os32c.getReportCounters().get(REPORT_BAD_PACKET));
+  EXPECT_EQ(1, os32c.getReportCounters().getErrors());
+
+  ts_io->rx_buffer = buffer(io_packet);
+  EXPECT_THROW(os32c.receiveMeasurementReportUDP(), std::logic_error);
+
+  // clang-format off
+  uint8_t truncated_packet[] = {
+    0x02, 0x00, 0x02, 0x80, 0x04, 0x00, 0x04, 0x00,
+    0x02, 0x00, 0xB1, 0x00, 0x02, 0x00, 0x01, 0x00,
+  };
+  // clang-format on
+
+  // so is an address item too short to hold the sequence number
+  ts_io->rx_buffer = buffer(truncated_packet);
+  EXPECT_EQ(REPORT_BAD_PACKET, os32c.tryReceiveMeasurementReportUDP(data));
+  EXPECT_EQ(3, os32c.getReportCounters().get(REPORT_BAD_PACKET));
 }
 
 
@@ -0,0 +1,89 @@
+/**
+Software License Agreement (BSD)
+
+\file      raw_scan_conversion_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/raw_scan_conversion.h"
+
+using namespace omron_os32c_driver;
+
+class RawScanConversionTest : public ::testing ::Test
+{
+};
+
+TEST_F(RawScanConversionTest, test_convert)
+{
+  RawScan raw;
+  raw.header.frame_id = "laser";
+  raw.angle_min = -0.1;
+  raw.angle_max = 0.1;
+  raw.range_max = 50;
+  raw.ranges.push_back(RawScan::RANGE_NOISY);
+  raw.ranges.push_back(RawScan::RANGE_NO_RETURN);
+  raw.ranges.push_back(1253);
+  raw.intensities.push_back(10);
+  raw.intensities.push_back(20);
+  raw.intensities.push_back(30);
+
+  sensor_msgs::LaserScan ls;
+  convertRawScanToLaserScan(raw, &ls);
+  EXPECT_EQ("laser", ls.header.frame_id);
+  EXPECT_FLOAT_EQ(-0.1, ls.angle_min);
+  ASSERT_EQ(3, ls.ranges.size());
+  EXPECT_FLOAT_EQ(0, ls.ranges[0]);
+  EXPECT_FLOAT_EQ(50, ls.ranges[1]);
+  EXPECT_FLOAT_EQ(1.253, ls.ranges[2]);
+  ASSERT_EQ(3, ls.intensities.size());
+  EXPECT_FLOAT_EQ(30, ls.intensities[2]);
+
+  // without intensities, and with a gap between the measurements
+  raw.intensities.clear();
+  raw.indices.push_back(0);
+  raw.indices.push_back(1);
+  raw.indices.push_back(4);
+  convertRawScanToLaserScan(raw, &ls);
+  ASSERT_EQ(5, ls.ranges.size());
+  EXPECT_TRUE(ls.intensities.empty());
+  EXPECT_FLOAT_EQ(50, ls.ranges[1]);
+  EXPECT_TRUE(std::isnan(ls.ranges[2]));
+  EXPECT_TRUE(std::isnan(ls.ranges[3]));
+  EXPECT_FLOAT_EQ(1.253, ls.ranges[4]);
+}
+
+TEST_F(RawScanConversionTest, test_invalid)
+{
+  RawScan raw;
+  raw.ranges.resize(3, 1000);
+  raw.intensities.resize(2);
+  sensor_msgs::LaserScan ls;
+  EXPECT_THROW(convertRawScanToLaserScan(raw, &ls), std::invalid_argument);
+
+  raw.intensities.clear();
+  raw.indices.push_back(0);
+  raw.indices.push_back(3);
+  raw.indices.push_back(2);
+  EXPECT_THROW(convertRawScanToLaserScan(raw, &ls), std::invalid_argument);
+}
@@ -0,0 +1,83 @@
+/**
+Software License Agreement (BSD)
+
+\file      realtime_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <pthread.h>
+#include <sched.h>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/realtime.h"
+
+using namespace omron_os32c_driver;
+
+class RealtimeTest : public ::testing ::Test
+{
+protected:
+  virtual void TearDown()
+  {
+    // leave the test thread as it was for the tests that follow
+    sched_param param;
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+  }
+};
+
+TEST_F(RealtimeTest, test_defaults)
+{
+  RealtimeStatus status = applyRealtimeSettings(RealtimeSettings());
+  EXPECT_TRUE(status.errors.empty());
+  EXPECT_EQ(0, status.priority);
+  EXPECT_FALSE(status.lock_memory);
+  EXPECT_FALSE(status.cpus.empty());
+  prefaultStack(64 * 1024);
+}
+
+TEST_F(RealtimeTest, test_invalid)
+{
+  RealtimeSettings settings;
+  settings.priority = 1000;
+  EXPECT_THROW(applyRealtimeSettings(settings), std::invalid_argument);
+  settings.priority = 0;
+  settings.cpus.push_back(-1);
+  EXPECT_THROW(applyRealtimeSettings(settings), std::invalid_argument);
+}
+
+TEST_F(RealtimeTest, test_fallback)
+{
+  RealtimeStatus original = applyRealtimeSettings(RealtimeSettings());
+  ASSERT_FALSE(original.cpus.empty());
+
+  // whether or not this is permitted here, it must not throw and the status
+  // must say what is in effect
+  RealtimeSettings settings;
+  settings.priority = 1;
+  settings.cpus.push_back(original.cpus[0]);
+  RealtimeStatus status = applyRealtimeSettings(settings);
+  EXPECT_TRUE(status.priority == 1 || !status.errors.empty());
+  EXPECT_TRUE(status.cpus == settings.cpus || !status.errors.empty());
+
+  settings = RealtimeSettings();
+  settings.cpus = original.cpus;
+  applyRealtimeSettings(settings);
+}
@@ -0,0 +1,63 @@
+/**
+Software License Agreement (BSD)
+
+\file      reconnect_backoff_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/reconnect_backoff.h"
+
+using namespace omron_os32c_driver;
+
+class ReconnectBackoffTest : public ::testing ::Test
+{
+};
+
+TEST_F(ReconnectBackoffTest, test_backoff)
+{
+  ReconnectBackoff backoff(0.05, 0.3);
+  EXPECT_DOUBLE_EQ(0, backoff.getDelay());
+  backoff.failed();
+  EXPECT_DOUBLE_EQ(0.05, backoff.getDelay());
+  backoff.failed();
+  EXPECT_DOUBLE_EQ(0.1, backoff.getDelay());
+  backoff.failed();
+  EXPECT_DOUBLE_EQ(0.2, backoff.getDelay());
+  backoff.failed();
+  EXPECT_DOUBLE_EQ(0.3, backoff.getDelay());
+  backoff.failed();
+  EXPECT_DOUBLE_EQ(0.3, backoff.getDelay());
+  EXPECT_EQ(5, backoff.getAttempts());
+
+  backoff.reset();
+  EXPECT_DOUBLE_EQ(0, backoff.getDelay());
+  EXPECT_EQ(0, backoff.getAttempts());
+  backoff.failed();
+  EXPECT_DOUBLE_EQ(0.05, backoff.getDelay());
+}
+
+TEST_F(ReconnectBackoffTest, test_invalid_args)
+{
+  EXPECT_THROW(ReconnectBackoff(0, 1), std::invalid_argument);
+  EXPECT_THROW(ReconnectBackoff(1, 0.5), std::invalid_argument);
+}
@@ -0,0 +1,260 @@
+/**
+Software License Agreement (BSD)
+
+\file      report_decoder_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/report_decoder.h"
+#include "omron_os32c_driver/scan_view.h"
+
+using namespace boost::asio;
+using namespace omron_os32c_driver;
+using namespace eip::serialization;
+
+class ReportDecoderTest : public ::testing ::Test
+{
+public:
+  /**
+   * Fill the report buffer with a header announcing the given number of beams,
+   * followed by values counting up from 1000, as a packet of the given length
+   */
+  void makeReport(EIP_UINT num_beams, size_t length, EIP_UINT range_format = RANGE_MEASURE_50M,
+                  EIP_UINT reflectivity_format = REFLECTIVITY_MEASURE_TOT_4PS)
+  {
+    MeasurementReportHeader header;
+    header.scan_count = 42;
+    header.num_beams = num_beams;
+    header.range_report_format = range_format;
+    header.refletivity_report_format = reflectivity_format;
+    vector<EIP_BYTE> data(length + sizeof(EIP_UINT));
+    BufferWriter writer(buffer(data));
+    header.serialize(writer);
+    for (EIP_UINT i = 0; writer.getByteCount() < length; ++i)
+    {
+      writer.write(static_cast<EIP_UINT>(1000 + i));
+    }
+    BufferReader reader(buffer(data));
+    report_.deserialize(reader, length);
+  }
+
+protected:
+  ReportBuffer report_;
+};
+
+TEST_F(ReportDecoderTest, test_range_and_reflectance)
+{
+  makeReport(3, 56 + 3 * 4);
+  RangeAndReflectanceMeasurement rr;
+  ASSERT_EQ(REPORT_OK, decodeRangeAndReflectance(report_, &rr));
+  EXPECT_EQ(42, rr.header.scan_count);
+  ASSERT_EQ(3, rr.range_data.size());
+  ASSERT_EQ(3, rr.reflectance_data.size());
+  EXPECT_EQ(1000, rr.range_data[0]);
+  EXPECT_EQ(1002, rr.range_data[2]);
+  EXPECT_EQ(1003, rr.reflectance_data[0]);
+  EXPECT_EQ(1005, rr.reflectance_data[2]);
+}
+
+TEST_F(ReportDecoderTest, test_range_only)
+{
+  // without reflectivity measurements only the ranges are sent
+  RangeAndReflectanceMeasurement rr;
+  makeReport(3, 56 + 3 * 4);
+  ASSERT_EQ(REPORT_OK, decodeRangeAndReflectance(report_, &rr));
+  makeReport(3, 56 + 3 * 2, RANGE_MEASURE_50M, NO_TOT_MEASUREMENTS);
+  ASSERT_EQ(REPORT_OK, decodeRangeAndReflectance(report_, &rr));
+  ASSERT_EQ(3, rr.range_data.size());
+  EXPECT_EQ(1002, rr.range_data[2]);
+  EXPECT_TRUE(rr.reflectance_data.empty());
+  ScanView view(rr);
+  EXPECT_EQ(3, view.getNumBeams());
+  EXPECT_TRUE(view.getReflectance() == NULL);
+
+  makeReport(3, 56 + 3 * 4, RANGE_MEASURE_50M, NO_TOT_MEASUREMENTS);
+  EXPECT_EQ(REPORT_TOO_LONG, decodeRangeAndReflectance(report_, &rr));
+}
+
+TEST_F(ReportDecoderTest, test_measurement_report)
+{
+  makeReport(3, 56 + 3 * 2);
+  MeasurementReport mr;
+  ASSERT_EQ(REPORT_OK, decodeMeasurementReport(report_, &mr));
+  ASSERT_EQ(3, mr.measurement_data.size());
+  EXPECT_EQ(1002, mr.measurement_data[2]);
+
+  makeReport(0, 56);
+  ASSERT_EQ(REPORT_OK, decodeMeasurementReport(report_, &mr));
+  EXPECT_TRUE(mr.measurement_data.empty());
+}
+
+TEST_F(ReportDecoderTest, test_measurement_report_with_reflectance)
+{
+  // the reflectance follows the ranges when both fit in the packet
+  makeReport(3, 56 + 3 * 4);
+  MeasurementReport mr;
+  ASSERT_EQ(REPORT_OK, decodeMeasurementReport(report_, &mr));
+  ASSERT_EQ(3, mr.measurement_data.size());
+  ASSERT_EQ(3, mr.reflectance_data.size());
+  EXPECT_EQ(1002, mr.measurement_data[2]);
+  EXPECT_EQ(1003, mr.reflectance_data[0]);
+  ScanView view(mr);
+  ASSERT_TRUE(view.getReflectance() != NULL);
+  EXPECT_EQ(1005, view.getReflectance()[2]);
+
+  // otherwise only the ranges are sent
+  makeReport(3, 56 + 3 * 2);
+  ASSERT_EQ(REPORT_OK, decodeMeasurementReport(report_, &mr));
+  EXPECT_EQ(3, mr.measurement_data.size());
+  EXPECT_TRUE(mr.reflectance_data.empty());
+
+  // or only the reflectance, if no ranges were requested
+  makeReport(3, 56 + 3 * 2, NO_TOF_MEASUREMENTS);
+  ASSERT_EQ(REPORT_OK, decodeMeasurementReport(report_, &mr));
+  EXPECT_TRUE(mr.measurement_data.empty());
+  ASSERT_EQ(3, mr.reflectance_data.size());
+  EXPECT_EQ(1000, mr.reflectance_data[0]);
+  EXPECT_THROW(ScanView view(mr), std::invalid_argument);
+}
+
+TEST_F(ReportDecoderTest, test_bad_lengths)
+{
+  RangeAndReflectanceMeasurement rr;
+  makeReport(3, 55);
+  EXPECT_EQ(REPORT_TOO_SHORT, decodeRangeAndReflectance(report_, &rr));
+  makeReport(3, 56 + 3 * 4 - 1);
+  EXPECT_EQ(REPORT_TOO_SHORT, decodeRangeAndReflectance(report_, &rr));
+  makeReport(3, 56 + 3 * 4 + 2);
+  EXPECT_EQ(REPORT_TOO_LONG, decodeRangeAndReflectance(report_, &rr));
+  makeReport(678, 56 + 678 * 4);
+  EXPECT_EQ(REPORT_TOO_LONG, decodeRangeAndReflectance(report_, &rr));
+  makeReport(678, 56 + 678 * 2);
+  EXPECT_EQ(REPORT_TOO_MANY_BEAMS, decodeRangeAndReflectance(report_, &rr));
+
+  // reflectance is only expected in a measurement report if it was requested
+  MeasurementReport mr;
+  makeReport(3, 56 + 3 * 4, RANGE_MEASURE_50M, NO_TOT_MEASUREMENTS);
+  EXPECT_EQ(REPORT_TOO_LONG, decodeMeasurementReport(report_, &mr));
+  makeReport(3, 56 + 3 * 3);
+  EXPECT_EQ(REPORT_TOO_LONG, decodeMeasurementReport(report_, &mr));
+  makeReport(3, 56 + 3 * 2, NO_TOF_MEASUREMENTS);
+  EXPECT_EQ(REPORT_OK, decodeMeasurementReport(report_, &mr));
+  makeReport(3, 56 + 3 * 4, NO_TOF_MEASUREMENTS);
+  EXPECT_EQ(REPORT_TOO_LONG, decodeMeasurementReport(report_, &mr));
+  makeReport(3, 56 + 3 * 2);
+  EXPECT_EQ(REPORT_TOO_SHORT, decodeRangeAndReflectance(report_, &rr));
+
+  // the largest valid report still fits
+  makeReport(677, 56 + 677 * 4);
+  EXPECT_FALSE(report_.isOverflowed());
+  EXPECT_EQ(REPORT_OK, decodeRangeAndReflectance(report_, &rr));
+}
+
+TEST_F(ReportDecoderTest, test_sequence_tracker)
+{
+  SequenceTracker tracker;
+  EXPECT_EQ(REPORT_OK, tracker.check(100));
+  EXPECT_EQ(REPORT_DUPLICATE, tracker.check(100));
+  EXPECT_EQ(REPORT_OK, tracker.check(102));
+  EXPECT_EQ(REPORT_STALE, tracker.check(101));
+  EXPECT_EQ(REPORT_OK, tracker.check(103));
+
+  // the count wraps around
+  tracker.reset();
+  EXPECT_EQ(REPORT_OK, tracker.check(0xFFFFFFFF));
+  EXPECT_EQ(REPORT_OK, tracker.check(0));
+  EXPECT_EQ(REPORT_STALE, tracker.check(0xFFFFFFFF));
+
+  // far behind is the sender starting over rather than a late packet
+  EXPECT_EQ(REPORT_OK, tracker.check(1000));
+  EXPECT_EQ(REPORT_STALE, tracker.check(1000 - SequenceTracker::MAX_REORDER));
+  EXPECT_EQ(REPORT_OK, tracker.check(1000 - SequenceTracker::MAX_REORDER - 1));
+
+  tracker.reset();
+  EXPECT_EQ(REPORT_OK, tracker.check(5));
+}
+
+/**
+ * Make a report of the given scan with either ranges or reflectance, each of
+ * value base plus the beam number
+ */
+static MeasurementReport makeHalf(EIP_UDINT scan_count, bool ranges, EIP_UINT base)
+{
+  MeasurementReport mr;
+  mr.header.scan_count = scan_count;
+  mr.header.num_beams = 2;
+  mr.header.range_report_format = ranges ? RANGE_MEASURE_50M : NO_TOF_MEASUREMENTS;
+  mr.header.refletivity_report_format = ranges ? NO_TOT_MEASUREMENTS : REFLECTIVITY_MEASURE_TOT_4PS;
+  vector<EIP_UINT>& data = ranges ? mr.measurement_data : mr.reflectance_data;
+  data.push_back(base);
+  data.push_back(base + 1);
+  return mr;
+}
+
+TEST_F(ReportDecoderTest, test_assembler)
+{
+  // reports with ranges are whole scans
+  ReportAssembler assembler;
+  ASSERT_TRUE(assembler.add(makeHalf(1, true, 100)));
+  EXPECT_EQ(1, assembler.getScan().header.scan_count);
+  EXPECT_EQ(101, assembler.getScan().range_data[1]);
+  EXPECT_TRUE(assembler.getScan().reflectance_data.empty());
+
+  // reflectance alone is not
+  EXPECT_FALSE(assembler.add(makeHalf(1, false, 200)));
+  EXPECT_EQ(1, assembler.getDropped());
+  EXPECT_EQ(100, assembler.getScan().range_data[0]);
+
+  MeasurementReport both = makeHalf(2, true, 300);
+  both.reflectance_data = makeHalf(2, false, 400).reflectance_data;
+  ASSERT_TRUE(assembler.add(both));
+  const RangeAndReflectanceMeasurement& scan = assembler.getScan();
+  EXPECT_EQ(2, scan.header.scan_count);
+  ASSERT_EQ(2, scan.range_data.size());
+  ASSERT_EQ(2, scan.reflectance_data.size());
+  EXPECT_EQ(301, scan.range_data[1]);
+  EXPECT_EQ(401, scan.reflectance_data[1]);
+  EXPECT_EQ(1, assembler.getDropped());
+}
+
+TEST_F(ReportDecoderTest, test_counters)
+{
+  ReportCounters counters;
+  EXPECT_EQ(REPORT_OK, counters.count(REPORT_OK));
+  counters.count(REPORT_OK);
+  EXPECT_EQ(REPORT_TOO_SHORT, counters.count(REPORT_TOO_SHORT));
+  counters.count(REPORT_BAD_PACKET);
+  EXPECT_EQ(2, counters.get(REPORT_OK));
+  EXPECT_EQ(1, counters.get(REPORT_TOO_SHORT));
+  EXPECT_EQ(2, counters.getErrors());
+  counters.reset();
+  EXPECT_EQ(0, counters.get(REPORT_OK));
+  EXPECT_EQ(0, counters.getErrors());
+  EXPECT_STREQ("Too short", getReportStatusName(REPORT_TOO_SHORT));
+  EXPECT_STREQ("Wrong connection", getReportStatusName(REPORT_WRONG_CONNECTION));
+}
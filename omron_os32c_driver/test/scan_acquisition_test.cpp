@@ -0,0 +1,171 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_acquisition_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_acquisition.h"
+#include "odva_ethernetip/socket/test_socket.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+
+using boost::make_shared;
+using namespace boost::asio;
+
+using namespace eip::socket;
+using namespace eip::serialization;
+using namespace omron_os32c_driver;
+
+/**
+ * Observer that keeps a copy of the ranges of the last scan
+ */
+class CopyObserver : public ScanObserver
+{
+public:
+  CopyObserver() : num_scans(0), selection_changed(false)
+  {
+  }
+
+  virtual void scanReceived(const ScanView& scan)
+  {
+    ranges.assign(scan.getRanges(), scan.getRanges() + scan.getNumBeams());
+    selection_changed = scan.isSelectionChanged();
+    ++num_scans;
+  }
+
+  vector<EIP_UINT> ranges;
+  int num_scans;
+  bool selection_changed;
+};
+
+class ScanAcquisitionTest : public ::testing ::Test
+{
+public:
+  ScanAcquisitionTest() : ts(make_shared<TestSocket>()), os32c(ts, make_shared<TestSocket>()), acquisition(&os32c)
+  {
+  }
+
+protected:
+  /**
+   * Queue the reply to the next range and reflectance request, with every
+   * range of the scan set to the same value
+   */
+  void setNextScan(int num_beams, EIP_UINT range)
+  {
+    RangeAndReflectanceMeasurement rr;
+    rr.header.range_report_format = RANGE_MEASURE_50M;
+    rr.header.refletivity_report_format = NO_TOT_MEASUREMENTS;
+    rr.header.num_beams = num_beams;
+    rr.range_data.assign(num_beams, range);
+
+    size_t item_length = 4 + rr.getLength();
+    size_t encap_length = 16 + item_length;
+    // clang-format off
+    uint8_t header[] = {
+      0x6F, 0x00, (uint8_t)(encap_length & 0xFF), (uint8_t)(encap_length >> 8), 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0xB2, 0x00, (uint8_t)(item_length & 0xFF), (uint8_t)(item_length >> 8),
+      0x8E, 0x00, 0x00, 0x00,
+    };
+    // clang-format on
+    packet.assign(header, header + sizeof(header));
+    packet.resize(sizeof(header) + rr.getLength());
+    BufferWriter writer(buffer(&packet[sizeof(header)], rr.getLength()));
+    rr.serialize(writer);
+    ts->rx_buffer = buffer(packet);
+  }
+
+  shared_ptr<TestSocket> ts;
+  OS32C os32c;
+  ScanAcquisition acquisition;
+  vector<uint8_t> packet;
+};
+
+TEST_F(ScanAcquisitionTest, test_median_reset_on_selection_change)
+{
+  BeamSelection first, second;
+  first.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  first.excludeBeam(0);
+  second.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  second.excludeBeam(BeamSelection::NUM_BEAMS - 1);
+  ASSERT_EQ(first.getNumBeams(), second.getNumBeams());
+
+  CopyObserver observer;
+  acquisition.addObserver(&observer);
+  acquisition.setMedianFilter(make_shared<TemporalMedianFilter>(3));
+
+  os32c.setBeamSelection(first);
+  for (int i = 0; i < 3; ++i)
+  {
+    setNextScan(first.getNumBeams(), 1000);
+    ASSERT_EQ(REPORT_OK, acquisition.tryPoll());
+  }
+  EXPECT_EQ(1000, observer.ranges[10]);
+
+  // the same number of beams at other angles must not be filtered with the old history
+  os32c.setBeamSelection(second);
+  setNextScan(second.getNumBeams(), 2000);
+  ASSERT_EQ(REPORT_OK, acquisition.tryPoll());
+  EXPECT_TRUE(observer.selection_changed);
+  EXPECT_EQ(2000, observer.ranges[10]);
+  EXPECT_EQ(4, observer.num_scans);
+}
+
+TEST_F(ScanAcquisitionTest, test_raw_observers)
+{
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  os32c.setBeamSelection(selection);
+
+  CopyObserver raw_observer, observer;
+  acquisition.addRawObserver(&raw_observer);
+  acquisition.addObserver(&observer);
+  acquisition.setMedianFilter(make_shared<TemporalMedianFilter>(3));
+
+  setNextScan(selection.getNumBeams(), 1000);
+  ASSERT_EQ(REPORT_OK, acquisition.tryPoll());
+  EXPECT_TRUE(raw_observer.selection_changed);
+  EXPECT_TRUE(observer.selection_changed);
+  setNextScan(selection.getNumBeams(), 1000);
+  ASSERT_EQ(REPORT_OK, acquisition.tryPoll());
+  EXPECT_FALSE(raw_observer.selection_changed);
+
+  // the spike is filtered out of the published scan, but is what the sensor sent
+  setNextScan(selection.getNumBeams(), 3000);
+  ASSERT_EQ(REPORT_OK, acquisition.tryPoll());
+  EXPECT_EQ(3000, raw_observer.ranges[10]);
+  EXPECT_EQ(1000, observer.ranges[10]);
+  EXPECT_EQ(3, raw_observer.num_scans);
+  EXPECT_EQ(3, observer.num_scans);
+
+  acquisition.removeRawObserver(&raw_observer);
+  setNextScan(selection.getNumBeams(), 1000);
+  ASSERT_EQ(REPORT_OK, acquisition.tryPoll());
+  EXPECT_EQ(3, raw_observer.num_scans);
+  EXPECT_EQ(4, observer.num_scans);
+}
@@ -0,0 +1,166 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_codec_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/beam_selection.h"
+#include "omron_os32c_driver/scan_codec.h"
+
+using namespace omron_os32c_driver;
+
+class ScanCodecTest : public ::testing ::Test
+{
+public:
+  ScanCodecTest() : seed_(1)
+  {
+  }
+
+  /// drift every beam of the scan a little, with the occasional jump across the whole range
+  void step(vector<EIP_UINT>& values)
+  {
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      seed_ = seed_ * 1103515245 + 12345;
+      unsigned r = seed_ >> 16;
+      values[i] = r % 50 ? values[i] + static_cast<int>(r % 7) - 3 : r;
+    }
+  }
+
+protected:
+  unsigned seed_;
+};
+
+TEST_F(ScanCodecTest, test_roundtrip)
+{
+  vector<EIP_UINT> ranges(677, 5000), reflectance(677, 300);
+  ranges[0] = 0;
+  ranges[1] = 65535;
+  ScanEncoder encoder(4);
+  vector<EIP_BYTE> encoded;
+  vector<size_t> offsets;
+  vector<vector<EIP_UINT> > expected_ranges, expected_reflectance;
+  for (int i = 0; i < 10; ++i)
+  {
+    offsets.push_back(encoded.size());
+    bool with_reflectance = i < 6;
+    EXPECT_EQ(i == 0 || i == 4 || i == 6, encoder.encode(&ranges[0], with_reflectance ? &reflectance[0] : NULL,
+                                                   ranges.size(), &encoded));
+    expected_ranges.push_back(ranges);
+    expected_reflectance.push_back(with_reflectance ? reflectance : vector<EIP_UINT>());
+    step(ranges);
+    step(reflectance);
+  }
+  offsets.push_back(encoded.size());
+  EXPECT_LT(encoded.size(), 10 * 677 * 2 * sizeof(EIP_UINT) * 3 / 4);
+
+  ScanDecoder decoder;
+  for (int i = 0; i < 10; ++i)
+  {
+    EXPECT_EQ(offsets[i + 1] - offsets[i], decoder.decode(&encoded[offsets[i]], encoded.size() - offsets[i]));
+    EXPECT_EQ(expected_ranges[i], decoder.getRanges());
+    EXPECT_EQ(expected_reflectance[i], decoder.getReflectance());
+  }
+}
+
+TEST_F(ScanCodecTest, test_static_scene)
+{
+  vector<EIP_UINT> ranges(677, 1234);
+  ScanEncoder encoder(100);
+  vector<EIP_BYTE> encoded;
+  encoder.encode(&ranges[0], NULL, ranges.size(), &encoded);
+  size_t keyframe_size = encoded.size();
+  encoder.encode(&ranges[0], NULL, ranges.size(), &encoded);
+  // flags, two byte beam count and a byte per unchanged beam
+  EXPECT_EQ(1 + 2 + 677, encoded.size() - keyframe_size);
+}
+
+TEST_F(ScanCodecTest, test_keyframes)
+{
+  vector<EIP_UINT> ranges(3, 7);
+  ScanEncoder encoder(100);
+  vector<EIP_BYTE> encoded;
+  EXPECT_TRUE(encoder.encode(&ranges[0], NULL, 3, &encoded));
+  EXPECT_FALSE(encoder.encode(&ranges[0], NULL, 3, &encoded));
+  EXPECT_TRUE(encoder.encode(&ranges[0], NULL, 2, &encoded));
+  encoder.forceKeyframe();
+  size_t keyframe = encoded.size();
+  EXPECT_TRUE(encoder.encode(&ranges[0], NULL, 2, &encoded));
+  size_t delta = encoded.size();
+  EXPECT_FALSE(encoder.encode(&ranges[0], NULL, 2, &encoded));
+  EXPECT_TRUE(ScanDecoder::isKeyframe(&encoded[keyframe]));
+  EXPECT_FALSE(ScanDecoder::isKeyframe(&encoded[delta]));
+
+  // a delta block cannot be decoded without the keyframe before it
+  ScanDecoder decoder;
+  EXPECT_THROW(decoder.decode(&encoded[delta], encoded.size() - delta), std::runtime_error);
+  decoder.decode(&encoded[keyframe], delta - keyframe);
+  decoder.decode(&encoded[delta], encoded.size() - delta);
+  EXPECT_EQ(vector<EIP_UINT>(2, 7), decoder.getRanges());
+  decoder.reset();
+  EXPECT_THROW(decoder.decode(&encoded[delta], encoded.size() - delta), std::runtime_error);
+
+  EXPECT_THROW(ScanEncoder(0), std::invalid_argument);
+}
+
+TEST_F(ScanCodecTest, test_truncated)
+{
+  vector<EIP_UINT> ranges(10, 1000);
+  ScanEncoder encoder(1);
+  vector<EIP_BYTE> encoded;
+  encoder.encode(&ranges[0], NULL, ranges.size(), &encoded);
+  ScanDecoder decoder;
+  for (size_t size = 0; size < encoded.size(); ++size)
+  {
+    EXPECT_THROW(decoder.decode(&encoded[0], size), std::runtime_error);
+  }
+  EXPECT_EQ(encoded.size(), decoder.decode(&encoded[0], encoded.size()));
+}
+
+TEST_F(ScanCodecTest, test_too_many_beams)
+{
+  // a keyframe with reflectance claiming 0x80000000 beams, which doubles to zero in 32 bits
+  vector<EIP_BYTE> block;
+  block.push_back(3);
+  block.push_back(0x80);
+  block.push_back(0x80);
+  block.push_back(0x80);
+  block.push_back(0x80);
+  block.push_back(0x08);
+  block.resize(block.size() + 16, 0);
+  ScanDecoder decoder;
+  EXPECT_THROW(decoder.decode(&block[0], block.size()), std::runtime_error);
+
+  // and one beam more than the sensor has, with enough bytes for all of them
+  vector<EIP_UINT> ranges(BeamSelection::NUM_BEAMS + 1, 1000);
+  vector<EIP_BYTE> encoded;
+  ScanEncoder encoder(1);
+  encoder.encode(&ranges[0], NULL, ranges.size(), &encoded);
+  EXPECT_THROW(decoder.decode(&encoded[0], encoded.size()), std::runtime_error);
+  encoded.clear();
+  encoder.encode(&ranges[0], NULL, ranges.size() - 1, &encoded);
+  EXPECT_EQ(encoded.size(), decoder.decode(&encoded[0], encoded.size()));
+}
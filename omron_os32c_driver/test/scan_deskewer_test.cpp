@@ -0,0 +1,121 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_deskewer_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_deskewer.h"
+
+using namespace omron_os32c_driver;
+using sensor_msgs::LaserScan;
+using sensor_msgs::PointCloud2;
+
+class ScanDeskewerTest : public ::testing ::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    ls.angle_min = -M_PI / 2;
+    ls.angle_max = M_PI / 2;
+    ls.angle_increment = M_PI / 2;
+    ls.time_increment = 0.01;
+    ls.range_min = OS32C::DISTANCE_MIN;
+    ls.range_max = OS32C::DISTANCE_MAX;
+    ls.ranges.resize(3, 2.0);
+    ls.intensities.resize(3, 100);
+  }
+
+  const float* point(const PointCloud2& cloud, size_t i)
+  {
+    return reinterpret_cast<const float*>(&cloud.data[i * cloud.point_step]);
+  }
+
+  LaserScan ls;
+  ScanDeskewer deskewer;
+};
+
+TEST_F(ScanDeskewerTest, test_stationary)
+{
+  PointCloud2 cloud;
+  deskewer.configure(ls, false);
+  deskewer.deskew(ls, 0, 0, 0, &cloud);
+  ASSERT_EQ(3, cloud.width);
+  ASSERT_EQ(4, cloud.fields.size());
+  EXPECT_EQ(16, cloud.point_step);
+  EXPECT_NEAR(0, point(cloud, 0)[0], 1e-6);
+  EXPECT_NEAR(-2, point(cloud, 0)[1], 1e-6);
+  EXPECT_NEAR(2, point(cloud, 1)[0], 1e-6);
+  EXPECT_NEAR(0, point(cloud, 1)[1], 1e-6);
+  EXPECT_NEAR(0, point(cloud, 2)[0], 1e-6);
+  EXPECT_NEAR(2, point(cloud, 2)[1], 1e-6);
+  EXPECT_FLOAT_EQ(100, point(cloud, 1)[3]);
+}
+
+TEST_F(ScanDeskewerTest, test_translation)
+{
+  PointCloud2 cloud;
+  deskewer.configure(ls, false);
+  deskewer.deskew(ls, 1.0, 0, 0, &cloud);
+  // first beam was measured 20 ms before the reference, the last beam at the reference
+  EXPECT_NEAR(-0.02, point(cloud, 0)[0], 1e-6);
+  EXPECT_NEAR(-0.01, point(cloud, 1)[0] - 2, 1e-6);
+  EXPECT_NEAR(0, point(cloud, 2)[0], 1e-6);
+
+  // reversing time makes the first beam the reference
+  deskewer.configure(ls, true);
+  deskewer.deskew(ls, 1.0, 0, 0, &cloud);
+  EXPECT_NEAR(0, point(cloud, 0)[0], 1e-6);
+  EXPECT_NEAR(-0.02, point(cloud, 2)[0], 1e-6);
+}
+
+TEST_F(ScanDeskewerTest, test_rotation)
+{
+  PointCloud2 cloud;
+  deskewer.configure(ls, false);
+  deskewer.deskew(ls, 0, 0, 1.0, &cloud);
+  // beam 1 was measured 10 ms before the reference, so it appears rotated by -0.01 rad
+  EXPECT_NEAR(2 * cos(-0.01), point(cloud, 1)[0], 1e-6);
+  EXPECT_NEAR(2 * sin(-0.01), point(cloud, 1)[1], 1e-6);
+}
+
+TEST_F(ScanDeskewerTest, test_invalid_ranges)
+{
+  PointCloud2 cloud;
+  ls.ranges[0] = 0;
+  ls.ranges[2] = OS32C::DISTANCE_MAX;
+  deskewer.configure(ls, false);
+  deskewer.deskew(ls, 0, 0, 0, &cloud);
+  EXPECT_TRUE(std::isnan(point(cloud, 0)[0]));
+  EXPECT_FALSE(std::isnan(point(cloud, 1)[0]));
+  EXPECT_TRUE(std::isnan(point(cloud, 2)[1]));
+  EXPECT_FALSE(cloud.is_dense);
+}
+
+TEST_F(ScanDeskewerTest, test_unconfigured)
+{
+  PointCloud2 cloud;
+  EXPECT_THROW(deskewer.deskew(ls, 0, 0, 0, &cloud), std::invalid_argument);
+}
@@ -0,0 +1,124 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_filter_chain_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_filter_chain.h"
+
+using namespace omron_os32c_driver;
+
+class ScanFilterChainTest : public ::testing ::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    // beams 317 to 359, straight ahead +/- 8.4 degrees
+    selection.addSector(DEG2RAD(8.4), DEG2RAD(-8.4));
+  }
+
+  BeamSelection selection;
+};
+
+TEST_F(ScanFilterChainTest, test_disabled)
+{
+  ScanFilterChain chain;
+  EXPECT_FALSE(chain.isEnabled());
+  chain.configure(selection);
+  EXPECT_EQ(43, chain.getNumBeams());
+
+  vector<EIP_UINT> ranges(43, 1000);
+  ranges[0] = 0x0001;
+  ranges[1] = 0xFFFF;
+  ranges[2] = 2;
+  chain.filter(ranges);
+  EXPECT_EQ(0x0001, ranges[0]);
+  EXPECT_EQ(0xFFFF, ranges[1]);
+  EXPECT_EQ(2, ranges[2]);
+  EXPECT_EQ(1000, ranges[42]);
+
+  ranges.resize(42);
+  EXPECT_THROW(chain.filter(ranges), std::invalid_argument);
+}
+
+TEST_F(ScanFilterChainTest, test_range_limits_and_self_mask)
+{
+  ScanFilterChain chain;
+  EXPECT_THROW(chain.setRangeLimits(1.0, 0.5), std::invalid_argument);
+  chain.setRangeLimits(0.1, 10.0);
+  chain.addSelfMask(DEG2RAD(8.4), DEG2RAD(6), 0.5);
+  chain.addSelfMask(DEG2RAD(8.4), DEG2RAD(8), 0.8);
+  EXPECT_TRUE(chain.isEnabled());
+  chain.configure(selection);
+
+  vector<EIP_UINT> ranges(43, 600);
+  ranges[10] = 50;
+  ranges[11] = 10001;
+  ranges[12] = 0xFFFF;
+  chain.filter(ranges);
+  // the overlapping masks use the larger minimum range
+  EXPECT_EQ(ScanFilterChain::FILTERED, ranges[0]);
+  EXPECT_EQ(ScanFilterChain::FILTERED, ranges[1]);
+  EXPECT_EQ(600, ranges[2]);
+  EXPECT_EQ(600, ranges[6]);
+  EXPECT_EQ(600, ranges[7]);
+  EXPECT_EQ(ScanFilterChain::FILTERED, ranges[10]);
+  EXPECT_EQ(ScanFilterChain::FILTERED, ranges[11]);
+  EXPECT_EQ(0xFFFF, ranges[12]);
+  EXPECT_EQ(600, ranges[42]);
+}
+
+TEST_F(ScanFilterChainTest, test_shadows)
+{
+  ScanFilterChain chain;
+  EXPECT_THROW(chain.setShadowAngle(M_PI / 2), std::invalid_argument);
+  chain.setShadowAngle(0.15);
+  chain.configure(selection);
+
+  // a wall seen at a shallow angle, then an edge with a veiling point behind it
+  vector<EIP_UINT> ranges(43, 3000);
+  for (int i = 0; i < 20; ++i)
+  {
+    ranges[i] = 1000 + 5 * i;
+  }
+  ranges[20] = 2000;
+  ranges[30] = 0x0001;
+  chain.filter(ranges);
+  EXPECT_EQ(1095, ranges[19]);
+  EXPECT_EQ(ScanFilterChain::FILTERED, ranges[20]);
+  EXPECT_EQ(ScanFilterChain::FILTERED, ranges[21]);
+  EXPECT_EQ(3000, ranges[22]);
+  EXPECT_EQ(3000, ranges[29]);
+  EXPECT_EQ(3000, ranges[31]);
+
+  // with a gap in the selection the same jump is further apart in angle
+  BeamSelection gaps = selection;
+  gaps.setDecimation(20);
+  chain.configure(gaps);
+  ranges.assign(3, 1000);
+  ranges[1] = 1300;
+  chain.filter(ranges);
+  EXPECT_EQ(1300, ranges[1]);
+}
@@ -0,0 +1,292 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_log_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/scan_log.h"
+
+using namespace omron_os32c_driver;
+
+class ScanLogTest : public ::testing ::Test
+{
+public:
+  ScanLogTest()
+  {
+    char filename[] = "/tmp/os32c_scan_log_test_XXXXXX";
+    int fd = mkstemp(filename);
+    close(fd);
+    filename_ = filename;
+  }
+
+  ~ScanLogTest()
+  {
+    unlink(filename_.c_str());
+  }
+
+  /// scan i is stamped at 100 + i / 10 s, with scan_count 1000 + i and ranges of i
+  void writeScans(ScanLogWriter& writer, size_t num_scans)
+  {
+    MeasurementReportHeader header;
+    vector<EIP_UINT> ranges(3), reflectance(3, 7);
+    for (size_t i = 0; i < num_scans; ++i)
+    {
+      header.scan_count = 1000 + i;
+      ranges.assign(3, i);
+      writer.write(header, 100 + i / 10.0, &ranges[0], i % 2 ? &reflectance[0] : NULL, ranges.size());
+    }
+  }
+
+protected:
+  string filename_;
+};
+
+TEST_F(ScanLogTest, test_roundtrip)
+{
+  ScanLogWriter writer(filename_, 4);
+  writeScans(writer, 10);
+  writer.close();
+
+  ScanLogReader reader(filename_);
+  EXPECT_EQ(3, reader.getNumChunks());
+  EXPECT_EQ(10, reader.getNumScans());
+  EXPECT_EQ(1008, reader.getChunk(2).first_scan_count);
+  EXPECT_EQ(1009, reader.getChunk(2).last_scan_count);
+
+  ScanLogEntry entry;
+  for (size_t i = 0; i < 10; ++i)
+  {
+    ASSERT_TRUE(reader.next(&entry));
+    EXPECT_DOUBLE_EQ(100 + i / 10.0, entry.stamp);
+    EXPECT_EQ(1000 + i, entry.header.scan_count);
+    ASSERT_EQ(3, entry.num_beams);
+    EXPECT_EQ(i, entry.ranges[2]);
+    if (i % 2)
+    {
+      ASSERT_TRUE(entry.reflectance);
+      EXPECT_EQ(7, entry.reflectance[0]);
+    }
+    else
+    {
+      EXPECT_FALSE(entry.reflectance);
+    }
+  }
+  EXPECT_FALSE(reader.next(&entry));
+}
+
+TEST_F(ScanLogTest, test_seek)
+{
+  ScanLogWriter writer(filename_, 4);
+  writeScans(writer, 10);
+  writer.close();
+
+  ScanLogReader reader(filename_);
+  ScanLogEntry entry;
+  ASSERT_TRUE(reader.seekTime(100.45));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1005, entry.header.scan_count);
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1006, entry.header.scan_count);
+
+  ASSERT_TRUE(reader.seekTime(0));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1000, entry.header.scan_count);
+
+  ASSERT_TRUE(reader.seekScanCount(1004));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1004, entry.header.scan_count);
+
+  ASSERT_TRUE(reader.seekScanCount(1009));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1009, entry.header.scan_count);
+  EXPECT_FALSE(reader.next(&entry));
+
+  EXPECT_FALSE(reader.seekTime(101));
+  EXPECT_FALSE(reader.next(&entry));
+  EXPECT_FALSE(reader.seekScanCount(1010));
+}
+
+TEST_F(ScanLogTest, test_seek_scan_count_runs)
+{
+  // the sensor restarts after scan 1005, and the count later wraps around
+  const EIP_UDINT counts[] = { 1000, 1001, 1002, 1003, 1004, 1005, 3, 4, 5, 6, 0xFFFFFFFE, 0xFFFFFFFF, 0, 1 };
+  const size_t num_scans = sizeof(counts) / sizeof(counts[0]);
+  ScanLogWriter writer(filename_, 4);
+  MeasurementReportHeader header;
+  vector<EIP_UINT> ranges(3);
+  for (size_t i = 0; i < num_scans; ++i)
+  {
+    header.scan_count = counts[i];
+    ranges.assign(3, i);
+    writer.write(header, 100 + i / 10.0, &ranges[0], NULL, ranges.size());
+  }
+  writer.close();
+
+  ScanLogReader reader(filename_);
+  ScanLogEntry entry;
+  ASSERT_TRUE(reader.seekScanCount(1004));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(4, entry.ranges[0]);
+
+  // found in the run after the restart, in the middle of a chunk
+  ASSERT_TRUE(reader.seekScanCount(5));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(8, entry.ranges[0]);
+
+  // counts after the wrap are in the last run
+  ASSERT_TRUE(reader.seekScanCount(1));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(13, entry.ranges[0]);
+  ASSERT_TRUE(reader.seekScanCount(0xFFFFFFFF));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(11, entry.ranges[0]);
+
+  // a count skipped within a run goes to the next scan of the run
+  ASSERT_TRUE(reader.seekScanCount(2000));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(10, entry.ranges[0]);
+
+  // a count in none of the runs goes to the first run starting after it
+  ASSERT_TRUE(reader.seekScanCount(2));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(0, entry.ranges[0]);
+}
+
+TEST_F(ScanLogTest, test_compressed)
+{
+  ScanLogWriter writer(filename_, 4, true, 3);
+  writeScans(writer, 10);
+  writer.close();
+
+  ScanLogReader reader(filename_);
+  EXPECT_TRUE(reader.isCompressed());
+  ScanLogEntry entry;
+  for (size_t i = 0; i < 10; ++i)
+  {
+    ASSERT_TRUE(reader.next(&entry));
+    EXPECT_EQ(1000 + i, entry.header.scan_count);
+    ASSERT_EQ(3, entry.num_beams);
+    EXPECT_EQ(i, entry.ranges[1]);
+    EXPECT_EQ(i % 2 == 1, entry.reflectance != NULL);
+  }
+  EXPECT_FALSE(reader.next(&entry));
+
+  // scans in the middle of a chunk are decoded from the keyframe before them
+  ASSERT_TRUE(reader.seekScanCount(1007));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1007, entry.header.scan_count);
+  EXPECT_EQ(7, entry.ranges[0]);
+  ASSERT_TRUE(reader.seekTime(100.25));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(3, entry.ranges[2]);
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(4, entry.ranges[2]);
+}
+
+TEST_F(ScanLogTest, test_alignment)
+{
+  // compressed scans come in blocks of any length
+  ScanLogWriter writer(filename_, 3, true);
+  writeScans(writer, 10);
+  writer.close();
+
+  struct stat st;
+  ASSERT_EQ(0, stat(filename_.c_str(), &st));
+  EXPECT_EQ(0, st.st_size % 8);
+  ScanLogReader reader(filename_);
+  ASSERT_EQ(4, reader.getNumChunks());
+  for (size_t i = 0; i < reader.getNumChunks(); ++i)
+  {
+    EXPECT_EQ(0, reader.getChunk(i).offset % 8);
+  }
+  ScanLogEntry entry;
+  for (size_t i = 0; i < 10; ++i)
+  {
+    ASSERT_TRUE(reader.next(&entry));
+    EXPECT_EQ(i, entry.ranges[2]);
+  }
+}
+
+TEST_F(ScanLogTest, test_corrupt_index)
+{
+  ScanLogWriter writer(filename_, 4);
+  writeScans(writer, 10);
+  writer.close();
+
+  // claim far more scans in the last chunk than the log holds
+  struct stat st;
+  ASSERT_EQ(0, stat(filename_.c_str(), &st));
+  ScanLogChunkInfo info;
+  std::fstream file(filename_.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+  off_t last = st.st_size - sizeof(ScanLogFooter) - sizeof(ScanLogChunkInfo);
+  file.seekg(last);
+  file.read(reinterpret_cast<char*>(&info), sizeof(info));
+  info.num_scans = 1000000;
+  file.seekp(last);
+  file.write(reinterpret_cast<const char*>(&info), sizeof(info));
+  file.close();
+
+  // the chunks are then found by walking them instead
+  ScanLogReader reader(filename_);
+  EXPECT_EQ(3, reader.getNumChunks());
+  EXPECT_EQ(10, reader.getNumScans());
+  ASSERT_TRUE(reader.seekScanCount(1009));
+  ScanLogEntry entry;
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1009, entry.header.scan_count);
+  EXPECT_FALSE(reader.next(&entry));
+}
+
+TEST_F(ScanLogTest, test_unclosed_log)
+{
+  ScanLogWriter writer(filename_, 4);
+  writeScans(writer, 10);
+  writer.close();
+  off_t cut = ScanLogReader(filename_).getChunk(2).offset + 10;
+
+  // drop the index and part of the last chunk, as if the recorder had crashed while writing it
+  ASSERT_EQ(0, truncate(filename_.c_str(), cut));
+  ScanLogReader reader(filename_);
+  EXPECT_EQ(2, reader.getNumChunks());
+  EXPECT_EQ(8, reader.getNumScans());
+  ScanLogEntry entry;
+  ASSERT_TRUE(reader.seekScanCount(1007));
+  ASSERT_TRUE(reader.next(&entry));
+  EXPECT_EQ(1007, entry.header.scan_count);
+  EXPECT_FALSE(reader.next(&entry));
+}
+
+TEST_F(ScanLogTest, test_not_a_log)
+{
+  EXPECT_THROW(ScanLogReader reader(filename_), std::runtime_error);
+  EXPECT_THROW(ScanLogReader reader(filename_ + ".missing"), std::runtime_error);
+  EXPECT_THROW(ScanLogWriter writer(filename_, 0), std::invalid_argument);
+}
@@ -0,0 +1,59 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_rate_monitor_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/scan_rate_monitor.h"
+
+using namespace omron_os32c_driver;
+
+class ScanRateMonitorTest : public ::testing ::Test
+{
+};
+
+TEST_F(ScanRateMonitorTest, test_update)
+{
+  ScanRateMonitor monitor;
+  EXPECT_FALSE(monitor.hasRate());
+  EXPECT_DOUBLE_EQ(0, monitor.getFrequency());
+  EXPECT_FALSE(monitor.update(0));
+
+  EXPECT_TRUE(monitor.update(40000));
+  EXPECT_TRUE(monitor.hasRate());
+  EXPECT_DOUBLE_EQ(25, monitor.getFrequency());
+
+  // small variations are not a change
+  EXPECT_FALSE(monitor.update(40000));
+  EXPECT_FALSE(monitor.update(40300));
+  EXPECT_DOUBLE_EQ(25, monitor.getFrequency());
+
+  EXPECT_TRUE(monitor.update(77780));
+  EXPECT_NEAR(12.857, monitor.getFrequency(), 0.001);
+
+  // after a reset the next header sets the rate again
+  monitor.reset();
+  EXPECT_FALSE(monitor.hasRate());
+  EXPECT_TRUE(monitor.update(77780));
+}
@@ -0,0 +1,102 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_view_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_conversions.h"
+#include "omron_os32c_driver/scan_view.h"
+
+using namespace omron_os32c_driver;
+
+class ScanViewTest : public ::testing ::Test
+{
+};
+
+TEST_F(ScanViewTest, test_views)
+{
+  RangeAndReflectanceMeasurement rr;
+  rr.header.scan_rate = 40000;
+  rr.header.scan_beam_period = 43000;
+  rr.header.num_beams = 3;
+  rr.range_data.resize(3, 1000);
+  rr.reflectance_data.resize(3, 20);
+
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  ScanView scan(rr, &selection, true);
+  EXPECT_EQ(3, scan.getNumBeams());
+  EXPECT_EQ(&rr.range_data[0], scan.getRanges());
+  EXPECT_EQ(&rr.reflectance_data[0], scan.getReflectance());
+  EXPECT_EQ(&selection, scan.getSelection());
+  EXPECT_TRUE(scan.isSelectionChanged());
+  EXPECT_DOUBLE_EQ(0.04, scan.getScanPeriod());
+  EXPECT_DOUBLE_EQ(43E-6, scan.getBeamPeriod());
+
+  MeasurementReport mr;
+  mr.header.num_beams = 2;
+  mr.measurement_data.resize(2, 1000);
+  ScanView ranges_only(mr);
+  EXPECT_EQ(2, ranges_only.getNumBeams());
+  EXPECT_TRUE(ranges_only.getReflectance() == NULL);
+  EXPECT_TRUE(ranges_only.getSelection() == NULL);
+  EXPECT_FALSE(ranges_only.isSelectionChanged());
+
+  rr.reflectance_data.resize(2);
+  EXPECT_THROW(ScanView view(rr), std::invalid_argument);
+  mr.header.num_beams = 3;
+  EXPECT_THROW(ScanView view(mr), std::invalid_argument);
+}
+
+TEST_F(ScanViewTest, test_convert)
+{
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  selection.setDecimation(2);
+
+  sensor_msgs::LaserScan ls;
+  fillLaserScanStaticConfig(selection, &ls);
+  EXPECT_FLOAT_EQ(OS32C::calcBeamCentre(0), ls.angle_max);
+  EXPECT_FLOAT_EQ(OS32C::calcBeamCentre(676), ls.angle_min);
+  EXPECT_FLOAT_EQ(2 * OS32C::ANGLE_INC, ls.angle_increment);
+
+  // intensities from an earlier scan are not kept for a scan without reflectance
+  ls.intensities.resize(2, 10);
+  MeasurementReport mr;
+  mr.header.num_beams = 2;
+  mr.measurement_data.push_back(0xFFFF);
+  mr.measurement_data.push_back(1253);
+  convertToLaserScan(ScanView(mr, &selection), &ls);
+  ASSERT_EQ(2, ls.ranges.size());
+  EXPECT_FLOAT_EQ(OS32C::DISTANCE_MAX, ls.ranges[0]);
+  EXPECT_FLOAT_EQ(1.253, ls.ranges[1]);
+  EXPECT_TRUE(ls.intensities.empty());
+
+  RawScan raw;
+  convertToRawScan(ScanView(mr), &raw);
+  ASSERT_EQ(2, raw.ranges.size());
+  EXPECT_EQ(RawScan::RANGE_NO_RETURN, raw.ranges[0]);
+  EXPECT_TRUE(raw.intensities.empty());
+}
@@ -0,0 +1,120 @@
+/**
+Software License Agreement (BSD)
+
+\file      sector_minima_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/sector_minima.h"
+
+using namespace omron_os32c_driver;
+
+class SectorMinimaTest : public ::testing ::Test
+{
+public:
+  SectorMinimaTest() : ranges_(BeamSelection::NUM_BEAMS, 5000)
+  {
+    // beams 313 to 363, and 413 to 438
+    minima_.addSector(DEG2RAD(10), DEG2RAD(-10));
+    minima_.addSector(DEG2RAD(-30), DEG2RAD(-40));
+  }
+
+protected:
+  SectorMinima minima_;
+  std::vector<EIP_UINT> ranges_;
+};
+
+TEST_F(SectorMinimaTest, test_invalid_sector)
+{
+  EXPECT_THROW(minima_.addSector(DEG2RAD(-10), DEG2RAD(10)), std::invalid_argument);
+  EXPECT_THROW(minima_.addSector(DEG2RAD(140), DEG2RAD(10)), std::invalid_argument);
+  EXPECT_EQ(2, minima_.getNumSectors());
+  EXPECT_DOUBLE_EQ(DEG2RAD(10), minima_.getStartAngle(0));
+  EXPECT_DOUBLE_EQ(DEG2RAD(-40), minima_.getEndAngle(1));
+}
+
+TEST_F(SectorMinimaTest, test_all_beams)
+{
+  BeamSelection selection;
+  selection.addSector(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN);
+  minima_.configure(selection);
+  ASSERT_TRUE(minima_.isMeasured(0));
+  ASSERT_TRUE(minima_.isMeasured(1));
+
+  // the first beam at the minimum wins, and beams outside the sector do not count
+  ranges_[312] = 100;
+  ranges_[320] = 1500;
+  ranges_[330] = 1500;
+  ranges_[363] = 1600;
+  ranges_[364] = 100;
+  minima_.reduce(&ranges_[0], ranges_.size());
+  EXPECT_EQ(1500, minima_.getRange(0));
+  EXPECT_EQ(320, minima_.getBeam(0));
+  EXPECT_EQ(5000, minima_.getRange(1));
+  EXPECT_EQ(413, minima_.getBeam(1));
+
+  // noisy beams and missing returns are not ranges
+  std::fill(ranges_.begin() + 413, ranges_.begin() + 439, SectorMinima::NO_RETURN);
+  ranges_[420] = 0x0001;
+  ranges_[438] = 2;
+  minima_.reduce(&ranges_[0], ranges_.size());
+  EXPECT_EQ(2, minima_.getRange(1));
+  EXPECT_EQ(438, minima_.getBeam(1));
+  ranges_[438] = 0x0001;
+  minima_.reduce(&ranges_[0], ranges_.size());
+  EXPECT_EQ(SectorMinima::NO_RETURN, minima_.getRange(1));
+  EXPECT_EQ(-1, minima_.getBeam(1));
+
+  // a short scan only covers part of the sectors
+  minima_.reduce(&ranges_[0], 325);
+  EXPECT_EQ(1500, minima_.getRange(0));
+  EXPECT_EQ(SectorMinima::NO_RETURN, minima_.getRange(1));
+}
+
+TEST_F(SectorMinimaTest, test_beam_selection)
+{
+  // beams 113 to 338 at every other beam, which only overlaps the first sector
+  BeamSelection selection;
+  selection.addSector(DEG2RAD(90), DEG2RAD(0));
+  selection.setDecimation(2);
+  minima_.configure(selection);
+  EXPECT_TRUE(minima_.isMeasured(0));
+  EXPECT_FALSE(minima_.isMeasured(1));
+
+  std::vector<EIP_UINT> ranges(selection.getNumBeams(), 5000);
+  const std::vector<int>& beams = selection.getBeams();
+  size_t index = std::find(beams.begin(), beams.end(), 315) - beams.begin();
+  ASSERT_LT(index, ranges.size());
+  ranges[index] = 700;
+  ranges[index - 2] = 600;
+  minima_.reduce(&ranges[0], ranges.size());
+  EXPECT_EQ(700, minima_.getRange(0));
+  EXPECT_EQ(315, minima_.getBeam(0));
+  EXPECT_EQ(selection.getSlot(index), minima_.getSlot(0));
+  EXPECT_EQ(selection.getNumSlots(), minima_.getNumSlots());
+  EXPECT_EQ(SectorMinima::NO_RETURN, minima_.getRange(1));
+  EXPECT_EQ(-1, minima_.getBeam(1));
+  EXPECT_EQ(-1, minima_.getSlot(1));
+}
@@ -0,0 +1,140 @@
+/**
+Software License Agreement (BSD)
+
+\file      shm_scan_ring_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <unistd.h>
+#include <sstream>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/shm_scan_ring.h"
+
+using namespace omron_os32c_driver;
+
+class ShmScanRingTest : public ::testing ::Test
+{
+public:
+  ShmScanRingTest()
+  {
+    std::ostringstream name;
+    name << "/os32c_test_" << getpid();
+    name_ = name.str();
+    rr_.header.num_beams = 3;
+    rr_.range_data.resize(3);
+    rr_.reflectance_data.resize(3, 5);
+  }
+
+  void write(ShmScanWriter& writer, EIP_UDINT scan_count)
+  {
+    rr_.header.scan_count = scan_count;
+    rr_.range_data.assign(3, 1000 + scan_count);
+    writer.write(ScanView(rr_), scan_count, scan_count + 0.5);
+  }
+
+protected:
+  string name_;
+  RangeAndReflectanceMeasurement rr_;
+};
+
+TEST_F(ShmScanRingTest, test_read)
+{
+  EXPECT_THROW(ShmScanReader reader(name_), std::runtime_error);
+
+  ShmScanWriter writer(name_, 4);
+  ShmScanReader reader(name_);
+  ShmScan scan;
+  EXPECT_FALSE(reader.readNext(&scan));
+  EXPECT_FALSE(reader.readLatest(&scan));
+
+  write(writer, 1);
+  write(writer, 2);
+  ASSERT_TRUE(reader.readNext(&scan));
+  EXPECT_EQ(0, scan.index);
+  EXPECT_EQ(1, scan.header.scan_count);
+  EXPECT_EQ(3, scan.header.num_beams);
+  EXPECT_DOUBLE_EQ(1, scan.stamp);
+  EXPECT_DOUBLE_EQ(1.5, scan.monotonic_stamp);
+  ASSERT_EQ(3, scan.ranges.size());
+  EXPECT_EQ(1001, scan.ranges[2]);
+  ASSERT_EQ(3, scan.reflectance.size());
+  EXPECT_EQ(5, scan.reflectance[0]);
+  ASSERT_TRUE(reader.readNext(&scan));
+  EXPECT_EQ(2, scan.header.scan_count);
+  EXPECT_FALSE(reader.readNext(&scan));
+
+  // a second reader starts at the oldest scan, and can skip to the newest
+  ShmScanReader latest_reader(name_);
+  write(writer, 3);
+  ASSERT_TRUE(latest_reader.readLatest(&scan));
+  EXPECT_EQ(3, scan.header.scan_count);
+  EXPECT_FALSE(latest_reader.readLatest(&scan));
+  EXPECT_EQ(0, latest_reader.getDropped());
+
+  // scans measured without reflectance
+  MeasurementReport mr;
+  mr.header.scan_count = 4;
+  mr.header.num_beams = 1;
+  mr.measurement_data.resize(1, 2000);
+  writer.write(ScanView(mr), 4, 4);
+  ASSERT_TRUE(reader.readNext(&scan));
+  ASSERT_TRUE(reader.readNext(&scan));
+  EXPECT_EQ(4, scan.header.scan_count);
+  ASSERT_EQ(1, scan.ranges.size());
+  EXPECT_TRUE(scan.reflectance.empty());
+  EXPECT_FALSE(reader.isClosed());
+}
+
+TEST_F(ShmScanRingTest, test_overrun)
+{
+  ShmScanWriter writer(name_, 4);
+  ShmScanReader reader(name_);
+  for (int i = 1; i <= 10; ++i)
+  {
+    write(writer, i);
+  }
+
+  // the scans that were overwritten are skipped
+  ShmScan scan;
+  ASSERT_TRUE(reader.readNext(&scan));
+  EXPECT_EQ(7, scan.header.scan_count);
+  EXPECT_EQ(6, reader.getDropped());
+  for (int i = 8; i <= 10; ++i)
+  {
+    ASSERT_TRUE(reader.readNext(&scan));
+    EXPECT_EQ(i, scan.header.scan_count);
+  }
+  EXPECT_FALSE(reader.readNext(&scan));
+}
+
+TEST_F(ShmScanRingTest, test_closed)
+{
+  EXPECT_THROW(ShmScanWriter writer("no_slash"), std::invalid_argument);
+  EXPECT_THROW(ShmScanWriter writer(name_, 1), std::invalid_argument);
+
+  ShmScanWriter* writer = new ShmScanWriter(name_);
+  ShmScanReader reader(name_);
+  EXPECT_FALSE(reader.isClosed());
+  delete writer;
+  EXPECT_TRUE(reader.isClosed());
+  EXPECT_THROW(ShmScanReader reopened(name_), std::runtime_error);
+}
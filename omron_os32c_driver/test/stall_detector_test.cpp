@@ -0,0 +1,89 @@
+/**
+Software License Agreement (BSD)
+
+\file      stall_detector_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/stall_detector.h"
+
+using namespace omron_os32c_driver;
+
+class StallDetectorTest : public ::testing ::Test
+{
+};
+
+TEST_F(StallDetectorTest, test_deadline)
+{
+  StallDetector detector(3, 0.1, 2.0);
+  detector.reset(10.0);
+  EXPECT_DOUBLE_EQ(2.0, detector.getDeadline());
+  EXPECT_FALSE(detector.isStalled(11.9));
+  EXPECT_TRUE(detector.isStalled(12.1));
+  EXPECT_DOUBLE_EQ(1.5, detector.getTimeRemaining(10.5));
+  EXPECT_DOUBLE_EQ(0.0, detector.getTimeRemaining(12.1));
+
+  // the first scan after connecting does not count as an interval
+  detector.scanReceived(11.0, 0.04);
+  EXPECT_DOUBLE_EQ(2.0, detector.getDeadline());
+
+  // scans at 25 Hz with a little jitter
+  double now = 11.0;
+  for (int i = 0; i < 100; ++i)
+  {
+    now += (i % 2) ? 0.042 : 0.038;
+    detector.scanReceived(now, 0.04);
+    EXPECT_FALSE(detector.isStalled(now + 0.05));
+  }
+  EXPECT_NEAR(0.04, detector.getMeanInterval(), 0.001);
+  EXPECT_NEAR(0.12, detector.getDeadline(), 0.01);
+  EXPECT_DOUBLE_EQ(now, detector.getLastScanTime());
+  EXPECT_FALSE(detector.isStalled(now + 0.1));
+  EXPECT_TRUE(detector.isStalled(now + 0.15));
+
+  // polling slower than the sensor scans follows the polling interval
+  for (int i = 0; i < 200; ++i)
+  {
+    now += 0.078;
+    detector.scanReceived(now, 0.04);
+  }
+  EXPECT_NEAR(0.234, detector.getDeadline(), 0.01);
+
+  detector.reset(now);
+  EXPECT_DOUBLE_EQ(2.0, detector.getDeadline());
+}
+
+TEST_F(StallDetectorTest, test_limits)
+{
+  StallDetector detector(3, 0.1, 0.5);
+  detector.reset(0);
+  detector.scanReceived(0.001, 0.001);
+  detector.scanReceived(0.002, 0.001);
+  EXPECT_DOUBLE_EQ(0.1, detector.getDeadline());
+  detector.scanReceived(1.002, 1.0);
+  EXPECT_DOUBLE_EQ(0.5, detector.getDeadline());
+
+  EXPECT_THROW(StallDetector(1, 0.1, 1), std::invalid_argument);
+  EXPECT_THROW(StallDetector(3, 0, 1), std::invalid_argument);
+  EXPECT_THROW(StallDetector(3, 1, 0.5), std::invalid_argument);
+}
@@ -0,0 +1,112 @@
+/**
+Software License Agreement (BSD)
+
+\file      temporal_median_filter_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/temporal_median_filter.h"
+
+using namespace omron_os32c_driver;
+
+class TemporalMedianFilterTest : public ::testing ::Test
+{
+};
+
+TEST_F(TemporalMedianFilterTest, test_invalid_window)
+{
+  EXPECT_THROW(TemporalMedianFilter(1), std::invalid_argument);
+  EXPECT_THROW(TemporalMedianFilter(4), std::invalid_argument);
+  EXPECT_NO_THROW(TemporalMedianFilter(3));
+  EXPECT_NO_THROW(TemporalMedianFilter(5));
+}
+
+TEST_F(TemporalMedianFilterTest, test_spikes)
+{
+  TemporalMedianFilter filter(3);
+  vector<EIP_UINT> ranges(3, 1000);
+  filter.filter(ranges);
+  EXPECT_EQ(1000, ranges[0]);
+
+  // a single noisy beam, missing return and spike are all removed
+  ranges[0] = 0x0001;
+  ranges[1] = 0xFFFF;
+  ranges[2] = 200;
+  filter.filter(ranges);
+  EXPECT_EQ(1000, ranges[0]);
+  EXPECT_EQ(1000, ranges[1]);
+  EXPECT_EQ(1000, ranges[2]);
+
+  // but a real change comes through after two scans
+  ranges.assign(3, 2000);
+  filter.filter(ranges);
+  EXPECT_EQ(1000, ranges[0]);
+  ranges.assign(3, 2000);
+  filter.filter(ranges);
+  EXPECT_EQ(2000, ranges[0]);
+
+  // a change in the number of beams restarts the history
+  ranges.assign(5, 3000);
+  filter.filter(ranges);
+  EXPECT_EQ(5, ranges.size());
+  EXPECT_EQ(3000, ranges[4]);
+}
+
+TEST_F(TemporalMedianFilterTest, test_matches_sort)
+{
+  // every ordering of 5 values, one beam each, in each position of the ring
+  EIP_UINT values[] = { 10, 20, 30, 40, 50 };
+  int window_sizes[] = { 3, 5 };
+  for (int w = 0; w < 2; ++w)
+  {
+    int window = window_sizes[w];
+    vector<vector<EIP_UINT> > scans;
+    do
+    {
+      scans.push_back(vector<EIP_UINT>(values, values + window));
+    } while (std::next_permutation(values, values + 5));
+
+    vector<EIP_UINT> beams(scans.size()), expected(scans.size());
+    for (int offset = 0; offset < window; ++offset)
+    {
+      TemporalMedianFilter filter(window);
+      filter.reset();
+      for (int k = 0; k < window + offset; ++k)
+      {
+        for (size_t i = 0; i < scans.size(); ++i)
+        {
+          beams[i] = scans[i][k % window];
+        }
+        filter.filter(beams);
+      }
+      for (size_t i = 0; i < scans.size(); ++i)
+      {
+        vector<EIP_UINT> sorted = scans[i];
+        std::sort(sorted.begin(), sorted.end());
+        expected[i] = sorted[window / 2];
+      }
+      EXPECT_EQ(expected, beams) << "window " << window << " offset " << offset;
+    }
+  }
+}
@@ -0,0 +1,196 @@
+/**
+Software License Agreement (BSD)
+
+\file      timeout_tcp_socket_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/timeout_tcp_socket.h"
+#include "odva_ethernetip/socket/test_socket.h"
+
+using boost::make_shared;
+using namespace omron_os32c_driver;
+
+namespace {
+
+double now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/**
+ * Listening socket on the loopback interface. Connections complete as soon as
+ * they are queued, but nothing is ever sent back unless accepted and written to.
+ */
+class Listener
+{
+public:
+  Listener() : fd_(socket(AF_INET, SOCK_STREAM, 0))
+  {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), len) != 0 || listen(fd_, 4) != 0 ||
+        getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+    {
+      throw std::runtime_error("Cannot listen on loopback");
+    }
+    std::ostringstream port;
+    port << ntohs(addr.sin_port);
+    port_ = port.str();
+  }
+
+  ~Listener()
+  {
+    close(fd_);
+  }
+
+  const string& getPort() const
+  {
+    return port_;
+  }
+
+  int accept()
+  {
+    return ::accept(fd_, NULL, NULL);
+  }
+
+private:
+  int fd_;
+  string port_;
+};
+
+void* abortSocket(void* arg)
+{
+  usleep(50000);
+  static_cast<TimeoutTCPSocket*>(arg)->abort();
+  return NULL;
+}
+
+}  // namespace
+
+class TimeoutTCPSocketTest : public ::testing ::Test
+{
+};
+
+TEST_F(TimeoutTCPSocketTest, test_invalid_timeouts)
+{
+  EXPECT_THROW(TimeoutTCPSocket(0, 1), std::invalid_argument);
+  EXPECT_THROW(TimeoutTCPSocket(1, -1), std::invalid_argument);
+  TimeoutTCPSocket socket(1, 0);
+  EXPECT_THROW(socket.setRequestTimeout(-0.1), std::invalid_argument);
+  EXPECT_FALSE(socket.isOpen());
+  char reply[8];
+  EXPECT_THROW(socket.receive(boost::asio::buffer(reply)), std::runtime_error);
+}
+
+TEST_F(TimeoutTCPSocketTest, test_round_trip)
+{
+  Listener listener;
+  TimeoutTCPSocket socket(1, 1);
+  socket.open("127.0.0.1", listener.getPort());
+  EXPECT_TRUE(socket.isOpen());
+  int peer = listener.accept();
+  ASSERT_GE(peer, 0);
+
+  char request[] = "ping";
+  EXPECT_EQ(4, socket.send(boost::asio::buffer(request, 4)));
+  char echo[8];
+  ASSERT_EQ(4, read(peer, echo, sizeof(echo)));
+  ASSERT_EQ(4, write(peer, echo, 4));
+  char reply[8];
+  EXPECT_EQ(4, socket.receive(boost::asio::buffer(reply)));
+  EXPECT_EQ(0, memcmp(request, reply, 4));
+
+  // the sensor hanging up fails the next request
+  close(peer);
+  EXPECT_THROW(socket.receive(boost::asio::buffer(reply)), std::runtime_error);
+  socket.close();
+  EXPECT_FALSE(socket.isOpen());
+}
+
+TEST_F(TimeoutTCPSocketTest, test_connection_refused)
+{
+  string port;
+  {
+    Listener listener;
+    port = listener.getPort();
+  }
+  TimeoutTCPSocket socket(1, 1);
+  EXPECT_THROW(socket.open("127.0.0.1", port), std::runtime_error);
+  EXPECT_FALSE(socket.isOpen());
+}
+
+TEST_F(TimeoutTCPSocketTest, test_silent_sensor)
+{
+  Listener listener;
+  TimeoutTCPSocket socket(1, 0.1);
+  socket.open("127.0.0.1", listener.getPort());
+
+  char reply[8];
+  double start = now();
+  EXPECT_THROW(socket.receive(boost::asio::buffer(reply)), std::runtime_error);
+  double elapsed = now() - start;
+  EXPECT_GE(elapsed, 0.09);
+  EXPECT_LT(elapsed, 1.0);
+
+  // a request to a sensor that never answers fails rather than blocking
+  shared_ptr<TimeoutTCPSocket> session_socket = make_shared<TimeoutTCPSocket>(1, 0.1);
+  session_socket->open("127.0.0.1", listener.getPort());
+  OS32C silent(session_socket, make_shared<eip::socket::TestSocket>());
+  RangeAndReflectanceMeasurement rr;
+  start = now();
+  EXPECT_THROW(silent.getSingleRRScan(rr), std::runtime_error);
+  EXPECT_LT(now() - start, 1.0);
+}
+
+TEST_F(TimeoutTCPSocketTest, test_abort)
+{
+  Listener listener;
+  TimeoutTCPSocket socket(1, 0);
+  socket.open("127.0.0.1", listener.getPort());
+
+  // waits forever without a request timeout, until woken from another thread
+  pthread_t aborter;
+  ASSERT_EQ(0, pthread_create(&aborter, NULL, abortSocket, &socket));
+  char reply[8];
+  EXPECT_THROW(socket.receive(boost::asio::buffer(reply)), std::runtime_error);
+  pthread_join(aborter, NULL);
+}
@@ -0,0 +1,121 @@
+/**
+Software License Agreement (BSD)
+
+\file      work_stealing_pool_test.cpp
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <unistd.h>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/work_stealing_pool.h"
+
+using namespace omron_os32c_driver;
+
+/**
+ * Counts how often each task runs and which worker ran it. The tasks in the
+ * first half sleep, so that whoever was given them falls behind.
+ */
+class CountingTask : public ParallelTask
+{
+public:
+  CountingTask(size_t num_tasks, size_t num_workers, size_t failing_task = -1)
+    : runs(num_tasks), workers(num_tasks), failing_task_(failing_task), num_workers_(num_workers)
+  {
+  }
+
+  virtual void run(size_t task, size_t worker)
+  {
+    ASSERT_LT(worker, num_workers_);
+    ++runs[task];
+    workers[task] = worker;
+    if (task == failing_task_)
+    {
+      throw std::runtime_error("task failed");
+    }
+    if (task < runs.size() / 2)
+    {
+      usleep(1000);
+    }
+  }
+
+  vector<int> runs;
+  vector<size_t> workers;
+
+private:
+  size_t failing_task_;
+  size_t num_workers_;
+};
+
+TEST(WorkStealingPoolTest, test_runs_every_task_once)
+{
+  WorkStealingPool pool(4);
+  EXPECT_EQ(4, pool.getNumWorkers());
+  CountingTask task(100, 4);
+  pool.run(100, &task);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(1, task.runs[i]) << "task " << i;
+  }
+
+  // the slow first half is shared out rather than left to workers 0 and 1
+  bool stolen = false;
+  for (size_t i = 0; i < 50; ++i)
+  {
+    stolen = stolen || task.workers[i] >= 2;
+  }
+  EXPECT_TRUE(stolen);
+
+  // the pool can be reused, including with fewer tasks than workers
+  CountingTask few(3, 4);
+  pool.run(3, &few);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(1, few.runs[i]);
+  }
+  pool.run(0, &few);
+}
+
+TEST(WorkStealingPoolTest, test_default_workers)
+{
+  WorkStealingPool pool;
+  EXPECT_LE(1, pool.getNumWorkers());
+  CountingTask task(10, pool.getNumWorkers());
+  pool.run(10, &task);
+  for (size_t i = 0; i < 10; ++i)
+  {
+    EXPECT_EQ(1, task.runs[i]);
+  }
+}
+
+TEST(WorkStealingPoolTest, test_exception)
+{
+  WorkStealingPool pool(3);
+  CountingTask task(30, 3, 12);
+  EXPECT_THROW(pool.run(30, &task), std::runtime_error);
+  EXPECT_EQ(1, task.runs[12]);
+  for (size_t i = 0; i < 30; ++i)
+  {
+    EXPECT_GE(1, task.runs[i]);
+  }
+}